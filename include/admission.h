@@ -0,0 +1,55 @@
+// admission.h
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "common.h"
+#include <stdio.h>
+#include <sys/socket.h>
+
+/* Admission control for the server reactor: token buckets per connection
+ * and per source IP, size bounds per message type, and a cap on the rate
+ * of new connections. A connection's own state belongs to whoever
+ * registers it, then to the reactor; the per-IP table and the accept
+ * bucket are shared (server_adopt_connection() runs on any thread) and
+ * locked.
+ * Unix-domain peers are local (bots, gateways) and skip the per-IP limits. */
+
+typedef struct {
+    double tokens;
+    uint64_t lastNs;
+} TokenBucket;
+
+typedef struct {
+    double connRate;            // New connections per second, whole server
+    double connBurst;
+    double ipConnRate;          // New connections per second, per source IP
+    double ipConnBurst;
+    double frameRate;           // Frames per second, per connection
+    double frameBurst;
+    double ipFrameRate;         // Frames per second, per source IP
+    double ipFrameBurst;
+    int floodDisconnect;        // Consecutive throttled frames before disconnecting
+    int maxConnections;         // Shed new connections above this
+    int shedQueueDepth;         // Shed new connections while this many tasks wait
+} AdmissionLimits;
+
+extern AdmissionLimits admissionLimits;
+
+// Verdict on an inbound frame
+typedef enum {
+    ADMIT_OK = 0,
+    ADMIT_DROP = 1,         // Over its rate: discard the frame
+    ADMIT_CLOSE = 2         // Malformed or flooding: close the connection
+} AdmitResult;
+
+int bucket_take(TokenBucket *b, double rate, double burst, uint64_t nowNs);
+uint64_t admission_now_ns(void);
+
+int admission_accept(int fd, const struct sockaddr *peer, socklen_t peerLen, int openConns, int queueDepth);
+void admission_conn_open(int fd, const struct sockaddr *peer, socklen_t peerLen);
+void admission_conn_close(int fd);
+AdmitResult admission_frame(int fd, uint8_t type, uint32_t len);
+int admission_frame_size_ok(uint8_t type, uint32_t len);
+void admission_stats_print(FILE *out);
+
+#endif
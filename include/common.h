@@ -5,11 +5,13 @@
 #include <stdint.h> // Required for uint32_t, int32_t
 
 #define DEFAULT_PORT 32000
-#define MAX_CLIENTS 4
+#define MAX_PLAYERS 6      // Largest table a rule set may describe
+#define MAX_CLIENTS MAX_PLAYERS
+#define MAX_OBJECTS 8
+#define MAX_CARDS 32
+#define MAX_HAND 8
 #define MAX_MSG 1024
-
-extern const char *nomcartes[13];
-extern const char *nameobjets[8];
+#define ENDPOINT_UNIX_PREFIX "unix:"   // "unix:/path" selects the Unix-domain transport
 
 typedef struct {
     char ipAddress[40];
@@ -32,6 +34,23 @@ typedef enum {
     MSG_ACTION_G    = 0x08, // 'G' - Client to Server: Make a Guess
     MSG_VERIFY      = 0x09, // 'V' - Server to Client: Broadcast verification result
 	MSG_GAME_OVER   = 0x0A,	// 'E' - Server to Client: Game Over Notification
+	MSG_RULES       = 0x0B, // 'R' - Server to Client: Rule set of the table (RuleSet, see rules.h)
+	MSG_PING        = 0x0C, // 'P' - Client to Server: Round-trip probe, echoed as MSG_PONG
+	MSG_PONG        = 0x0D, // 'Q' - Server to Client: The MSG_PING payload, unchanged
+	MSG_RANK_QUERY  = 0x0E, // 'K' - Client to Server: Rank of a player, or a page of the leaderboard
+	MSG_RANK_REPLY  = 0x0F, // 'B' - Server to Client: Answer to MSG_RANK_QUERY
+	MSG_ROOM_LIST   = 0x10, // 'Y' - Client to Server: Page of the room directory, (un)subscribing to deltas
+	MSG_ROOM_PAGE   = 0x11, // 'Z' - Server to Client: Answer to MSG_ROOM_LIST
+	MSG_ROOM_DELTA  = 0x12, // 'U' - Server to Client: Rooms changed since the last delta (subscribers only)
+	MSG_JOIN_ROOM   = 0x13, // 'J' - Client to Server: Room the next MSG_CONNECT seats the player in
+	MSG_CHAT        = 0x14, // 'T' - Client to Server: A line of table chat
+	MSG_CHAT_LINE   = 0x15, // 'W' - Server to Client: A chat line, relayed to the whole room
+	MSG_CHAT_HISTORY = 0x16, // 'H' - Server to Client: The room's recent chat lines, sent on joining
+	MSG_REDIRECT    = 0x17, // 'N' - Server to Client: The table moved to another server, follow it
+	MSG_RESUME      = 0x18, // 'A' - Client to Server: Take a seat back after MSG_REDIRECT
+	MSG_MIGRATE     = 0x19, // 'F' - Admin to Server (Unix socket only): Move a table to another server
+	MSG_ROOM_IMPORT = 0x1A, // 'm' - Server to Server: A migrated table's state
+	MSG_MIGRATE_RESULT = 0x1B, // 'r' - Server to Server/Admin: Answer to MSG_ROOM_IMPORT or MSG_MIGRATE
 	MSG_ERROR       = 0xFF	// 'X' - Server to Client: Error Message
 } MessageType;
 
@@ -65,8 +84,9 @@ typedef struct {
 
 // Payload for MSG_DISTRIBUTE (Server to Client)
 typedef struct {
-	int32_t Cards[3]; 		// The 3 cards assigned to the player (encoded as integers)
-	int32_t objCounts[8]; 	// Initial counts of each object type (8 types)
+	int32_t nbCards;				// Hand size under the active rule set
+	int32_t Cards[MAX_HAND]; 		// The cards assigned to the player (encoded as integers)
+	int32_t objCounts[MAX_OBJECTS]; // The player's own count of each object type
 } __attribute__((packed)) Payload_Distribute;
 
 // Payload for MSG_TURN (Server to Client)
@@ -107,4 +127,153 @@ typedef struct {
 	int32_t is_winner; // 1=WIN, 0=LOSE, -1=DRAW
 } __attribute__((packed)) Payload_Game_Over;
 
+// Payload for MSG_PING / MSG_PONG (opaque to the server, echoed as is)
+typedef struct {
+	uint32_t seq;      // Probe number
+	uint64_t sentNs;   // Sender's monotonic clock when sent
+} __attribute__((packed)) Payload_Ping;
+
+#define RANK_PAGE 10        // Leaderboard entries per MSG_RANK_REPLY
+
+// Payload for MSG_RANK_QUERY (Client to Server)
+typedef struct {
+	char name[32];     // Player to look up; empty for a leaderboard page
+	int32_t first;     // Page: 0-based rank of the first entry
+	int32_t count;     // Page: entries wanted (at most RANK_PAGE)
+} __attribute__((packed)) Payload_Rank_Query;
+
+typedef struct {
+	int32_t rank;      // 1 = best
+	char name[32];
+	int32_t rating;
+	int32_t games;
+	int32_t wins;
+} __attribute__((packed)) Rank_Entry;
+
+// Payload for MSG_RANK_REPLY (Server to Client)
+typedef struct {
+	int32_t total;     // Rated players
+	int32_t count;     // Valid entries (0: unknown player or past the end)
+	Rank_Entry entries[RANK_PAGE];
+} __attribute__((packed)) Payload_Rank_Reply;
+
+#define ROOM_PAGE 16         // Rooms per MSG_ROOM_PAGE
+#define ROOM_DELTA_MAX 64    // Rooms per MSG_ROOM_DELTA (the server's room limit)
+#define ROOM_ANY -1          // MSG_JOIN_ROOM: let the server pick
+
+// Room states in the directory
+enum {
+	ROOM_WAITING = 0,   // Seats free, game not started
+	ROOM_PLAYING = 1,
+	ROOM_FINISHED = 2   // Game over, players still connected
+};
+
+typedef struct {
+	int32_t id;
+	uint8_t players;   // Seated players
+	uint8_t seats;
+	uint8_t state;     // ROOM_WAITING .. ROOM_FINISHED
+} __attribute__((packed)) Room_Info;
+
+// Payload for MSG_ROOM_LIST (Client to Server)
+typedef struct {
+	int32_t first;     // First room of the page
+	int32_t count;     // Rooms wanted (at most ROOM_PAGE)
+	int32_t subscribe; // 1: send MSG_ROOM_DELTA from now on, 0: stop, -1: unchanged
+} __attribute__((packed)) Payload_Room_List;
+
+// Payload for MSG_ROOM_PAGE (Server to Client)
+typedef struct {
+	int32_t total;     // Rooms on the server
+	int32_t first;
+	int32_t count;     // Valid entries
+	Room_Info rooms[ROOM_PAGE];
+} __attribute__((packed)) Payload_Room_Page;
+
+// Payload for MSG_ROOM_DELTA (Server to Client); only `count` entries are sent
+typedef struct {
+	uint32_t seq;      // Delta number, to spot drops
+	int32_t count;
+	Room_Info rooms[ROOM_DELTA_MAX];
+} __attribute__((packed)) Payload_Room_Delta;
+
+// Payload for MSG_JOIN_ROOM (Client to Server)
+typedef struct {
+	int32_t roomId;    // ROOM_ANY for the fullest room with a free seat
+} __attribute__((packed)) Payload_Join_Room;
+
+#define CHAT_MAX_TEXT 200    // Longest chat line, in bytes
+#define CHAT_HISTORY 16      // Recent lines a room keeps for newcomers
+
+// Payload for MSG_CHAT (Client to Server): 1 to CHAT_MAX_TEXT bytes of text, no terminator needed
+typedef struct {
+	char text[CHAT_MAX_TEXT];
+} __attribute__((packed)) Payload_Chat;
+
+// Payload for MSG_CHAT_LINE (Server to Client); sent up to the text's terminator
+typedef struct {
+	uint32_t seq;      // Line number in the room
+	int32_t playerId;
+	char name[32];
+	char text[CHAT_MAX_TEXT + 1];
+} __attribute__((packed)) Chat_Line;
+
+// Payload for MSG_CHAT_HISTORY (Server to Client); only `count` lines are sent, oldest first
+typedef struct {
+	int32_t count;
+	Chat_Line lines[CHAT_HISTORY];
+} __attribute__((packed)) Payload_Chat_History;
+
+#define ENDPOINT_MAX 108       // "unix:/path" or an IPv4 address
+#define ROOM_IMPORT_MAX 4000   // Largest MSG_ROOM_IMPORT, under the default max-frame (4096)
+
+// Payload for MSG_REDIRECT (Server to Client); nothing after it comes from the old server
+typedef struct {
+	char endpoint[ENDPOINT_MAX]; // Server now holding the table
+	int32_t port;
+	int32_t roomId;    // Room there
+	int32_t playerId;  // Seat, unchanged
+	uint64_t token;    // Proves the seat to the new server
+} __attribute__((packed)) Payload_Redirect;
+
+// Payload for MSG_RESUME (Client to Server): fields copied from MSG_REDIRECT
+typedef struct {
+	int32_t roomId;
+	int32_t playerId;
+	uint64_t token;
+} __attribute__((packed)) Payload_Resume;
+
+// Payload for MSG_MIGRATE (Admin to Server)
+typedef struct {
+	int32_t roomId;
+	int32_t port;
+	char endpoint[ENDPOINT_MAX]; // Target server, as the players will reach it
+} __attribute__((packed)) Payload_Migrate;
+
+// Payload for MSG_ROOM_IMPORT (Server to Server); followed by the room state (see migrate.h)
+typedef struct {
+	char secret[32];   // The servers' shared migrate-secret
+	char rules[32];    // Active rule set, must match the target's
+} __attribute__((packed)) Payload_Room_Import;
+
+// Migration outcome
+enum {
+	MIGRATE_OK = 0,
+	MIGRATE_BAD_ROOM = 1,     // No such room
+	MIGRATE_EMPTY = 2,        // Nobody seated, nothing to move
+	MIGRATE_REFUSED = 3,      // Target: wrong secret, other rules, or no secret set
+	MIGRATE_NO_ROOM = 4,      // Target: no empty room left
+	MIGRATE_UNREACHABLE = 5,  // Target did not answer in time
+	MIGRATE_BUSY = 6          // Room still waiting for the players of a previous migration
+};
+
+// Payload for MSG_MIGRATE_RESULT
+typedef struct {
+	int32_t status;    // MIGRATE_OK .. MIGRATE_BUSY
+	int32_t roomId;    // Room on the target server
+	uint32_t pauseUs;  // MSG_MIGRATE only: how long the table was held
+} __attribute__((packed)) Payload_Migrate_Result;
+
+int connect_endpoint(const char *endpoint, int port);
+
 #endif
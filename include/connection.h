@@ -0,0 +1,58 @@
+// connection.h
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include "common.h"
+#include <stdio.h>
+#include <stddef.h>
+
+/* Per-connection buffering for the server reactor.
+ * Sockets are non-blocking: workers append to a bounded outbound buffer and
+ * never block, the reactor flushes the rest on EPOLLOUT. */
+
+#define CONN_MAX_FD 4096
+#define CONN_LOW_CHUNK 4096     // Low-lane bytes moved ahead of later game frames at a time
+
+// Delivery class of an outbound frame
+typedef enum {
+    SEND_GAME = 0,      // Needed to play (turn, verify, cards...): never dropped
+    SEND_SPECTATOR = 1, // Only refreshes what the client displays: may be dropped
+    SEND_CHAT = 2       // Lowest lane: waits for the game backlog to drain, dropped when its queue is full
+} SendClass;
+
+// What to do with a client that stays over its outbound limit
+typedef enum {
+    SLOW_DISCONNECT = 0,     // Close the connection
+    SLOW_DROP_SPECTATOR = 1  // Drop spectator-only frames, disconnect at twice the limit
+} SlowConsumerPolicy;
+
+typedef struct {
+    size_t outLowWatermark;     // Resume reading the client's input below this
+    size_t outHighWatermark;    // Pause reading the client's input above this
+    size_t outLimit;            // Apply the slow-consumer policy above this
+    size_t lowLimit;            // Queued SEND_CHAT bytes; more are dropped
+    SlowConsumerPolicy slowPolicy;
+    uint32_t inMaxFrame;        // Largest payload a client may announce
+} ConnLimits;
+
+extern ConnLimits connLimits;
+
+// Returns 0 to keep reading, -1 to close the connection
+typedef int (*FrameHandler)(int fd, const PacketHeader *header, const void *payload);
+
+void conn_init(int epollFd);
+int conn_open(int fd);
+void conn_close(int fd);
+int conn_is_open(int fd);
+int conn_read(int fd, FrameHandler onFrame);
+void conn_on_writable(int fd);
+int conn_send_packet(int fd, uint8_t type, const void *payload, uint32_t len, SendClass cls);
+int conn_count(void);
+int conn_list(int *fds, int max);
+void conn_detach(int fd);
+void conn_attach(int fd);
+int conn_get_buffers(int fd, const void **in, size_t *inLen, const void **out, size_t *outLen);
+int conn_restore_buffers(int fd, const void *in, size_t inLen, const void *out, size_t outLen);
+void conn_stats_print(FILE *out);
+
+#endif
@@ -0,0 +1,35 @@
+// game.h
+#ifndef GAME_H
+#define GAME_H
+
+#include "common.h"
+#include "rules.h"
+
+/* Rules of one game, without sockets or globals: deal, O/S/G resolution
+ * and turn order. The server runs one Game; the tournament runner runs
+ * millions side by side, each with its own random generator. */
+
+typedef struct {
+    const RuleSet *rules;
+    uint64_t rng;                           // Per-game generator state
+    int deck[MAX_CARDS];                    // Hands in seat order, then the culprit
+    int table[MAX_PLAYERS][MAX_OBJECTS];    // Symbols in each player's hand
+    int alive[MAX_PLAYERS];
+    int current;                            // Seat whose turn it is
+    int crimeCard;
+    int winner;                             // -1 while the game runs
+} Game;
+
+void game_init(Game *g, const RuleSet *rules, uint64_t seed);
+uint32_t game_rand(Game *g, uint32_t bound);
+void game_shuffle(Game *g);
+void game_deal(Game *g);
+void game_start(Game *g);
+const int *game_hand(const Game *g, int player);
+int game_observe(const Game *g, int object);
+int game_speculate(const Game *g, int target, int object);
+int game_guess(Game *g, int player, int card);
+int game_advance_turn(Game *g);
+int game_alive_count(const Game *g);
+
+#endif
@@ -0,0 +1,38 @@
+// gateway.h
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include "common.h"
+#include <stdio.h>
+
+/* Front gateway in front of several servers (backends).
+ * Clients connect to the gateway as to a server. Before they sit down it
+ * serves the lobby itself (MSG_ROOM_LIST pages and deltas), merged from a
+ * directory feed it keeps open to every backend. Each backend slot has
+ * its own range of ROOM_DELTA_MAX lobby room ids, so the rooms add up;
+ * the first other frame routes the session to the owner of the chosen
+ * room (always with MSG_JOIN_ROOM, under the backend's own room id), and
+ * from then on the bytes are moved in both directions with splice()
+ * without being copied to user space. A backend that goes down, or is
+ * removed from the list (SIGHUP), stops getting new sessions while its
+ * current games play on; its rooms leave the lobby. */
+
+#define GW_MAX_BACKENDS 32
+#define GW_ROOMS (GW_MAX_BACKENDS * ROOM_DELTA_MAX)   // Lobby room ids: one range per backend slot
+#define GW_MAX_FD 4096
+#define GW_FRAME_MAX 512            // Largest frame read before the session is routed
+#define GW_OUT_MAX 2048             // Lobby frames queued for a client
+#define GW_SPLICE_CHUNK 65536       // Bytes moved per splice() call
+#define GW_RETRY_MS 1000            // Reconnecting to a backend that went down
+
+typedef struct {
+    int port;
+    const char *backends[GW_MAX_BACKENDS];     // "host:port" or "unix:/path", from --backend=
+    int nbBackends;
+    const char *backendsFile;                  // One backend per line, read again on SIGHUP
+} GatewayConfig;
+
+int gateway_run(const GatewayConfig *cfg);
+void gateway_stats_print(FILE *out);
+
+#endif
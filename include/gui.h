@@ -19,11 +19,12 @@ typedef enum {
 
 void render_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y, SDL_Color color);
 void render_icon(SDL_Renderer *renderer, SDL_Texture *tex, int x, int y, int size);
-void render_cards(SDL_Renderer* renderer, SDL_Texture* cards[], int* mycards, int cardCount);
+void render_cards(SDL_Renderer* renderer, const int* mycards, int cardCount);
 void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font);
 void draw_guess_popup(SDL_Renderer* renderer, TTF_Font* font);
 void show_end_popup(SDL_Renderer* renderer, TTF_Font* font, const char* result);
 void setShowEndDialog(int value);
+void gui_request_redraw(void);
 void send_action_request(char type, int objet, int cible);
 void run_gui();
 void draw_game_board(SDL_Renderer* renderer, TTF_Font* font);
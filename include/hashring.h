@@ -0,0 +1,31 @@
+// hashring.h
+#ifndef HASHRING_H
+#define HASHRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Consistent hashing ring.
+ * Every node is placed at RING_VNODES points, hashed from its name; a key
+ * belongs to the first point at or after its own hash. Adding or removing
+ * one node out of N only moves about 1/N of the keys, the others keep
+ * their node. */
+
+#define RING_VNODES 64      // Points per node: evens out the share of each node
+
+typedef struct {
+    uint32_t point;
+    int node;
+} RingPoint;
+
+typedef struct {
+    RingPoint *points;      // Sorted by point
+    int nbPoints;
+} HashRing;
+
+uint32_t ring_hash(const void *data, size_t len);
+int ring_build(HashRing *ring, const char *const *names, int count);
+int ring_lookup(const HashRing *ring, uint32_t key);
+void ring_free(HashRing *ring);
+
+#endif
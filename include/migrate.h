@@ -0,0 +1,41 @@
+// migrate.h
+#ifndef MIGRATE_H
+#define MIGRATE_H
+
+#include "common.h"
+#include "rooms.h"
+
+/* Live room migration between servers.
+ * The source server packs a table into one MSG_ROOM_IMPORT frame: the
+ * game (deck, tableCartes, playerAlive, turn), the seats with a resume
+ * token each, and as much of the chat as fits. It is sent to the target
+ * while the table is held; once the target answers, every player is sent
+ * MSG_REDIRECT and takes the seat back there with MSG_RESUME. */
+
+#define MIGRATE_TIMEOUT_MS 50      // Longest the whole transfer may take while the source holds the table
+
+// Room state following Payload_Room_Import, then `chatLines` Chat_Line
+// records (oldest first), each cut after its text's terminator
+typedef struct {
+    int32_t nbClients;
+    int32_t nbPlayers;
+    int32_t joueurCourant;
+    int32_t crimeCard;
+    int32_t gameStarted;
+    int32_t finished;
+    int8_t deck[MAX_CARDS];
+    int8_t tableCartes[MAX_PLAYERS][MAX_OBJECTS];
+    int8_t playerAlive[MAX_PLAYERS];
+    char names[MAX_CLIENTS][32];
+    uint64_t resumeToken[MAX_CLIENTS];   // 0: seat already gone, not coming back
+    uint32_t chatSeq;
+    uint8_t chatLines;
+} __attribute__((packed)) MigrateRoom;
+
+uint32_t migrate_pack(const Room *r, void *buf, uint32_t cap);
+int migrate_unpack(Room *r, const void *buf, uint32_t len);
+uint64_t migrate_token(void);
+int migrate_connect(const char *endpoint, int port);
+int migrate_transfer(int sock, const void *payload, uint32_t len, Payload_Migrate_Result *result);
+
+#endif
@@ -0,0 +1,44 @@
+// perf_overlay.h
+#ifndef PERF_OVERLAY_H
+#define PERF_OVERLAY_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdint.h>
+
+/* Client performance overlay (F3): frame time split into event, update,
+ * render and present phases, draw and texture counts, time since the last
+ * server message and the ping round trip. Every frame can also be logged
+ * as a CSV row (SH13_PERF_CSV=path). GUI thread only. */
+
+#define PERF_REFRESH_MS 500     // Repaint period while the overlay is shown
+#define PERF_PING_MS 1000       // Ping period while measuring
+
+typedef enum {
+    PERF_EVENTS = 0,            // Draining the SDL event queue
+    PERF_UPDATE,                // Snapshot refresh and asset uploads
+    PERF_RENDER,                // Building the frame
+    PERF_PRESENT,               // SDL_RenderPresent (vsync wait included)
+    PERF_PHASES
+} PerfPhase;
+
+// What the GUI knows about the connection when a frame ends
+typedef struct {
+    int rttUs;                  // -1 if unknown
+    uint64_t lastMessageNs;     // 0 if nothing received yet
+    int textures;
+} PerfFrameInfo;
+
+void perf_init(void);
+void perf_shutdown(void);
+int perf_active(void);
+int perf_overlay_visible(void);
+void perf_overlay_toggle(void);
+
+void perf_frame_begin(void);
+void perf_phase_end(PerfPhase phase);
+void perf_count_draws(int n);      // Textured draw calls (text, sprite batches, layers)
+void perf_frame_end(const PerfFrameInfo *info);
+void perf_overlay_draw(SDL_Renderer *renderer, TTF_Font *font);
+
+#endif
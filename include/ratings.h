@@ -0,0 +1,29 @@
+// ratings.h
+#ifndef RATINGS_H
+#define RATINGS_H
+
+#include "common.h"
+#include <stdio.h>
+
+/* Persistent player ratings (Elo, by player name). Every change is
+ * appended to a log that is replayed at startup; in memory, profiles are
+ * found by name through a hash table and ranked by an order-statistic
+ * treap, so rank lookups and leaderboard pages cost O(log n).
+ *
+ * Game results are only queued on the game-over path: a dedicated thread
+ * updates ratings and writes the log. */
+
+#define RATING_INITIAL 1500.0
+#define RATING_K 32.0
+#define RATINGS_QUEUE_MAX 4096     // Pending results; more are dropped (and counted)
+
+int ratings_open(const char *path);
+void ratings_close(void);
+void ratings_game_over(const char (*names)[32], int nbPlayers, int winner);
+int ratings_lookup(const char *name, Rank_Entry *out);
+int ratings_page(int first, int count, Rank_Entry *out);
+int ratings_count(void);
+void ratings_query(const Payload_Rank_Query *q, Payload_Rank_Reply *reply);
+void ratings_stats_print(FILE *out);
+
+#endif
@@ -1,15 +1,40 @@
-
 #ifndef RESOURCES_H
 #define RESOURCES_H
 
 #include <SDL.h>
 
-extern SDL_Texture* icons[8];
-extern SDL_Texture* cards[13];
+/* Card images and object icons, packed into a single atlas texture so a
+ * whole UI layer draws with one SDL_RenderGeometry call.
+ * PNGs are decoded by a small worker pool while the window comes up; the
+ * render thread uploads each image into the atlas as soon as it is ready. */
+
+#define ATLAS_ICONS 8           // Object icons shipped in img/
+#define ATLAS_CARDS 13          // Card images shipped in img/
+#define ATLAS_CARD_W 300        // Cards are stored at their on-screen size
+#define ATLAS_CARD_H 200
+#define ATLAS_CARDS_PER_ROW 4
+
+#define ASSET_WORKERS_MAX 4     // Decoder threads, fewer on small machines
+
+#define SPRITE_BATCH_MAX 128    // Quads per draw call
 
-void load_icons(SDL_Renderer* renderer);
-void load_cards(SDL_Renderer* renderer);
-void load_all_textures(SDL_Renderer* renderer);
+// Quads waiting to be drawn from the atlas
+typedef struct {
+    SDL_Vertex vertices[SPRITE_BATCH_MAX * 4];
+    int indices[SPRITE_BATCH_MAX * 6];
+    int count;
+} SpriteBatch;
+
+extern SDL_Texture* atlas;
+
+void assets_start(void (*onDecoded)(void));
+int assets_upload(SDL_Renderer* renderer);
+int assets_pending(void);
 void unload_textures();
+const SDL_Rect *atlas_icon(int i);
+const SDL_Rect *atlas_card(int i);
+
+void sprite_batch_add(SpriteBatch *batch, SDL_Renderer *renderer, const SDL_Rect *src, const SDL_Rect *dst);
+void sprite_batch_flush(SpriteBatch *batch, SDL_Renderer *renderer);
 
 #endif
@@ -0,0 +1,72 @@
+// rooms.h
+#ifndef ROOMS_H
+#define ROOMS_H
+
+#include "common.h"
+#include "game.h"
+#include "admission.h"
+#include <stdio.h>
+#include <pthread.h>
+
+/* Game rooms and the lobby directory.
+ * Each room is one table under the active rule set, with its own lock.
+ * The directory mirrors every room's seats and state in one atomic word,
+ * so listings are served without touching any room lock. Subscribed
+ * connections are sent the rooms that changed, coalesced by a publisher
+ * thread, instead of polling. Each room also keeps its last chat lines,
+ * sent to every player who sits down. A table migrated in from another
+ * server waits, game held, until its players take their seats back
+ * (MSG_RESUME) or ROOM_RESUME_TIMEOUT_MS runs out. */
+
+#define MAX_ROOMS ROOM_DELTA_MAX
+#define ROOM_DELTA_INTERVAL_MS 100     // Default coalescing window of the delta publisher
+#define ROOM_RESUME_TIMEOUT_MS 5000    // Migrated seats not taken back by then are given up
+
+typedef struct {
+    int id;
+    pthread_mutex_t lock;
+    Client tcpClients[MAX_CLIENTS];
+    int clientSockets[MAX_CLIENTS];    // -1 once the player's connection closed
+    int nbClients;
+    int nbPlayers;                     // Seats, from the active rule set
+    int gameStarted;
+    int finished;                      // Game over, players still connected
+    Game game;
+    // Chat: ring of the last CHAT_HISTORY lines, seq counts every line
+    Chat_Line chat[CHAT_HISTORY];
+    uint32_t chatSeq;
+    TokenBucket chatBucket[MAX_CLIENTS];
+    // Migration: seats awaiting MSG_RESUME (token 0 = none), until resumeUntilNs
+    uint64_t resumeToken[MAX_CLIENTS];
+    uint64_t resumeUntilNs;
+} Room;
+
+extern Room rooms[MAX_ROOMS];
+extern int nbRooms;
+
+void rooms_init(int count);
+void room_reset(Room *r);
+void room_publish(Room *r);
+Room *room_of(int fd);
+Room *room_enter(int fd);
+int room_bind(int fd, Room *r);
+void room_attach(int fd, Room *r);
+void room_prefer(int fd, int roomId);
+void room_disconnect(int fd);
+Room *room_take_empty(void);
+int room_resume(int fd, Room *r);
+int room_resuming(const Room *r);
+void room_resume_wait(Room *r);
+void room_resume_end(Room *r);
+void room_detach(int fd);
+const Chat_Line *room_chat_append(Room *r, int playerId, const char *text, size_t len);
+uint32_t room_chat_history(const Room *r, Payload_Chat_History *history);
+
+void directory_page(int first, int count, Payload_Room_Page *page);
+void directory_subscribe(int fd, int on);
+int directory_subscribed(int fd);
+void directory_start(int intervalMs);
+void directory_pause(int paused);
+void directory_stats_print(FILE *out);
+
+#endif
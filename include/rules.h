@@ -0,0 +1,28 @@
+// rules.h
+#ifndef RULES_H
+#define RULES_H
+
+#include "common.h"
+
+/* Rule set: table size, deck composition and object set as data.
+ * Also the MSG_RULES payload, hence the fixed-width packed layout. */
+
+typedef struct {
+    char name[32];
+    int32_t nbPlayers;                          // Seated players (2-6)
+    int32_t nbCards;                            // Deck size, the last dealt card is the culprit
+    int32_t handSize;                           // (nbCards - 1) / nbPlayers
+    int32_t nbObjects;                          // Object kinds (at most MAX_OBJECTS)
+    char objectNames[MAX_OBJECTS][16];
+    char cardNames[MAX_CARDS][32];
+    uint8_t cardObjects[MAX_CARDS][MAX_OBJECTS]; // Symbols printed on each card
+} __attribute__((packed)) RuleSet;
+
+extern RuleSet activeRules;
+
+const RuleSet *rules_builtin(const char *name);
+int rules_load_file(RuleSet *rules, const char *path);
+int rules_load(RuleSet *rules, const char *nameOrPath);
+int rules_validate(const RuleSet *rules);
+
+#endif
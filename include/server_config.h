@@ -0,0 +1,47 @@
+// server_config.h
+#ifndef SERVER_CONFIG_H
+#define SERVER_CONFIG_H
+
+#include <sched.h>
+#include "connection.h"
+#include "admission.h"
+
+/* Runtime server settings: command line (--key=value) or a config file
+ * (key = value per line, '#' comments), command line winning. */
+
+typedef struct {
+    int port;
+    char unixPath[108];         // Empty = no Unix-domain listener
+    int upgradeListenerOnly;    // Hot upgrade hands off the listeners only
+    char rules[256];            // Built-in rule set name or rules file
+    char ratingsLog[256];       // Ratings log; empty = ratings kept in memory only
+    int rooms;                  // Game rooms (tables) served at once
+    int roomDeltaMs;            // Coalescing window of the lobby deltas
+    double chatRate;            // Chat lines per second, per player (0 = unlimited)
+    double chatBurst;
+    char traceFile[256];        // Chrome trace-event output; empty = not recording
+    char migrateSecret[32];     // Shared by servers exchanging tables; empty = imports refused
+
+    // Thread topology
+    int minThreads;             // Workers kept alive when idle
+    int maxThreads;             // Ceiling the pool grows to with queue depth
+    int maxEvents;              // epoll_wait batch size
+    int listenBacklog;
+    int reactorCpu;             // -1 = not pinned
+    cpu_set_t workerCpus;       // Empty = not pinned
+    char avoidIrqOf[32];        // NIC whose IRQ CPUs are kept free of server threads
+
+    ConnLimits conn;
+    AdmissionLimits admission;
+} ServerConfig;
+
+extern ServerConfig serverConfig;
+
+void config_defaults(ServerConfig *cfg);
+int config_load_file(ServerConfig *cfg, const char *path);
+int config_parse_args(ServerConfig *cfg, int argc, char *argv[]);
+int config_parse_cpu_list(const char *list, cpu_set_t *set);
+int config_irq_cpus(const char *nic, cpu_set_t *set);
+void config_print(const ServerConfig *cfg);
+
+#endif
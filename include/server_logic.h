@@ -3,14 +3,10 @@
 #define SERVER_LOGIC_H
 
 #include "common.h"
+#include "game.h"
+#include "rooms.h"
 
-extern Client tcpClients[MAX_CLIENTS];
-extern int nbClients;
-extern int deck[13];
-extern int tableCartes[4][8];
-extern int joueurCourant;
 extern int fsmServer;
-extern int nbPlayers;
 
 typedef enum {
     GAME_NOT_STARTED,
@@ -19,8 +15,6 @@ typedef enum {
 } GameState;
 
 
-void melangerDeck();
-void createTable();
 void printDeck();
 void printClients();
 void advanceToNextPlayer();
@@ -28,6 +22,7 @@ void sendMessageToClient(char *clientip,int clientport,char *mess);
 void broadcastMessage(char *mess);
 int getNextAvailablePort();
 void start_server_listener(int port);
+int server_adopt_connection(int fd);
 void sendError(int clientId, const char* errorType);
 
 #endif
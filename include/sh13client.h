@@ -0,0 +1,94 @@
+// sh13client.h
+#ifndef SH13CLIENT_H
+#define SH13CLIENT_H
+
+#include "common.h"
+#include "rules.h"
+
+/* libsh13client: the client side of the protocol, without SDL.
+ * Each connection is an opaque Sh13Client holding its socket, receive
+ * buffer and game state, so one process can run any number of sessions
+ * (GUI, bots, load generators). Nothing here is global or locked: a
+ * context is driven by one thread, sends may come from another.
+ * A session whose table migrates follows MSG_REDIRECT by itself. */
+
+enum {
+    GAME_NOT_CONNECTED = 0,
+    GAME_WAITING = 1,
+    GAME_STARTED = 2,
+    GAME_ENDED = 3
+};
+
+// Game state as seen by one connection, updated before the callbacks run
+typedef struct {
+    unsigned version;                   // Bumped after every read that changed it
+    int connected;                      // An ID was assigned by the server
+    int myClientId;
+    int gameState;                      // GAME_NOT_CONNECTED .. GAME_ENDED
+    int isMyTurn;
+    int currentTurnPlayer;
+    int playerCount;
+    char playerNames[MAX_PLAYERS][32];
+    int playerAlive[MAX_PLAYERS];
+    int objectTable[MAX_PLAYERS][MAX_OBJECTS];
+    int myCards[MAX_HAND];
+    int myCardCount;
+    int objectCounts[MAX_OBJECTS];
+    char lastResult[128];
+    RuleSet rules;
+    int rttUs;                          // Last ping round trip, -1 before the first pong
+    uint64_t lastMessageNs;             // CLOCK_MONOTONIC of the last frame received
+} Sh13State;
+
+typedef struct Sh13Client Sh13Client;
+
+// Event callbacks, all optional; payloads are only valid during the call
+typedef struct {
+    void (*onIdAssign)(Sh13Client *c, const Payload_ID_Assign *p, void *user);
+    void (*onRules)(Sh13Client *c, const RuleSet *rules, void *user);
+    void (*onPlayerList)(Sh13Client *c, const Payload_Player_List *p, void *user);
+    void (*onDistribute)(Sh13Client *c, const Payload_Distribute *p, void *user);
+    void (*onTurn)(Sh13Client *c, const Payload_Turn *p, void *user);
+    void (*onVerify)(Sh13Client *c, const Payload_Verify *p, void *user);
+    void (*onGameOver)(Sh13Client *c, const Payload_Game_Over *p, void *user);
+    void (*onPong)(Sh13Client *c, int rttUs, void *user);
+    void (*onRank)(Sh13Client *c, const Payload_Rank_Reply *p, void *user);
+    void (*onRoomPage)(Sh13Client *c, const Payload_Room_Page *p, void *user);
+    // Only p->count entries are valid
+    void (*onRoomDelta)(Sh13Client *c, const Payload_Room_Delta *p, void *user);
+    void (*onChat)(Sh13Client *c, const Chat_Line *line, void *user);
+    // Only p->count lines are valid, oldest first
+    void (*onChatHistory)(Sh13Client *c, const Payload_Chat_History *p, void *user);
+    // The table moved (MSG_REDIRECT): the session is already on the new
+    // server, under the same descriptor, and has asked for its seat back
+    void (*onRedirect)(Sh13Client *c, const Payload_Redirect *p, void *user);
+    // Any frame, including types this library does not decode
+    void (*onFrame)(Sh13Client *c, uint8_t type, const void *payload, uint32_t len, void *user);
+    // Once per read, after every frame it carried was applied
+    void (*onBatch)(Sh13Client *c, void *user);
+    // The connection ended; the socket is already closed
+    void (*onDisconnect)(Sh13Client *c, void *user);
+} Sh13Callbacks;
+
+Sh13Client *sh13_client_new(const Sh13Callbacks *callbacks, void *user);
+void sh13_client_free(Sh13Client *c);
+int sh13_client_connect(Sh13Client *c, const char *endpoint, int port);
+int sh13_client_fd(const Sh13Client *c);
+void *sh13_client_user(const Sh13Client *c);
+const Sh13State *sh13_client_state(const Sh13Client *c);
+
+int sh13_client_read(Sh13Client *c);
+void sh13_client_run(Sh13Client *c);
+
+int sh13_client_send_connect(Sh13Client *c, const char *name, int port);
+int sh13_client_observe(Sh13Client *c, int objectId);
+int sh13_client_speculate(Sh13Client *c, int targetId, int objectId);
+int sh13_client_guess(Sh13Client *c, int cardId);
+int sh13_client_ping(Sh13Client *c);
+int sh13_client_rank_query(Sh13Client *c, const char *name, int first, int count);
+int sh13_client_room_list(Sh13Client *c, int first, int count, int subscribe);
+int sh13_client_join_room(Sh13Client *c, int roomId);
+int sh13_client_chat(Sh13Client *c, const char *text);
+uint64_t sh13_now_ns(void);
+
+#endif
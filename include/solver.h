@@ -0,0 +1,64 @@
+// solver.h
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "strategy.h"
+#include "worlds.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* Offline solver: exact value of a player's information set. The set is
+ * the list of worlds (deals of the unseen cards to the opponents, plus the
+ * culprit) consistent with the player's hand and the O/S answers so far.
+ * The value at depth d is the best probability of naming the culprit
+ * within d of the player's own turns, every O/S answer being weighted by
+ * how many worlds give it. Opponents' turns are not modelled: this is the
+ * race the player runs against the table, played perfectly. */
+
+// Information set as constraints: bounds per opponent and object, and the
+// objects an O answered "somebody has it" for
+typedef struct {
+    uint8_t lo[MAX_PLAYERS][MAX_OBJECTS];
+    uint8_t hi[MAX_PLAYERS][MAX_OBJECTS];
+    uint8_t seen;
+} SolverState;
+
+// Lockless transposition table (key stored xor-ed with the data, so a torn
+// entry written by two threads at once reads as a miss)
+typedef struct {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} TTEntry;
+
+typedef struct {
+    TTEntry *entries;
+    uint64_t mask;
+} TransTable;
+
+typedef struct {
+    long nodes, hits, stores;
+} SolverCounters;
+
+typedef struct {
+    const RuleSet *rules;
+    int hand[MAX_HAND];
+    WorldSet ws;                    // Seat 0 is the solving player
+    uint64_t handKey;
+    TransTable *tt;
+} Solver;
+
+typedef struct {
+    BotAction action;
+    double value;
+} SolverAction;
+
+int tt_init(TransTable *tt, size_t megabytes);
+void tt_free(TransTable *tt);
+
+int solver_init(Solver *s, const RuleSet *rules, const int *hand, TransTable *tt);
+void solver_free(Solver *s);
+double solver_value(const Solver *s, int depth, SolverCounters *c);
+int solver_root_actions(const Solver *s, int depth, int threads, SolverAction *out, int max, SolverCounters *c);
+double solver_policy_value(const Solver *s, const Strategy *strategy, int depth, uint64_t seed);
+
+#endif
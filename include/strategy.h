@@ -0,0 +1,52 @@
+// strategy.h
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "common.h"
+#include "rules.h"
+
+/* Pluggable bot strategies for the tournament runner. A bot only sees what
+ * a client sees: its own hand, the O/S answers broadcast to the table and
+ * who got eliminated. Knowledge turns that into per-player bounds on each
+ * object count and a set of cards that can still be the culprit. */
+
+typedef struct {
+    const RuleSet *rules;
+    int self;
+    uint32_t mine[MAX_CARDS / 32 + 1];          // Bitset of the cards in my hand
+    int myCounts[MAX_OBJECTS];
+    int totals[MAX_OBJECTS];                    // Symbols in the whole deck
+    uint8_t lo[MAX_PLAYERS][MAX_OBJECTS];       // Known bounds on each player's counts
+    uint8_t hi[MAX_PLAYERS][MAX_OBJECTS];
+    int alive[MAX_PLAYERS];
+} Knowledge;
+
+typedef enum {
+    BOT_OBSERVE,        // O: object
+    BOT_SPECULATE,      // S: target, object
+    BOT_GUESS           // G: card
+} BotActionKind;
+
+typedef struct {
+    BotActionKind kind;
+    int object;
+    int target;
+    int card;
+} BotAction;
+
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*choose)(const Knowledge *k, uint64_t *rng, BotAction *out);
+} Strategy;
+
+void knowledge_init(Knowledge *k, const RuleSet *rules, int self, const int *hand);
+void knowledge_observe(Knowledge *k, int object, int found);
+void knowledge_speculate(Knowledge *k, int target, int object, int count);
+void knowledge_eliminated(Knowledge *k, int player);
+int knowledge_candidates(const Knowledge *k, int *out);
+
+const Strategy *strategy_find(const char *name);
+const Strategy *strategy_list(int *count);
+
+#endif
@@ -0,0 +1,25 @@
+// text_cache.h
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+/* Rendered-string cache: each (font, color, text) is rasterized and
+ * uploaded once, then reused until evicted (least recently used first). */
+
+#define TEXT_CACHE_CAPACITY 512     // Cached strings
+#define TEXT_CACHE_MAX_LEN 128      // Longer strings are rendered uncached
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    int entries;
+} TextCacheStats;
+
+SDL_Texture *text_cache_get(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color, int *w, int *h);
+void text_cache_clear(void);
+void text_cache_stats(TextCacheStats *stats);
+
+#endif
@@ -0,0 +1,44 @@
+// tournament.h
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include "strategy.h"
+
+/* In-process tournament between strategies: games run on the server's
+ * rules (game.c) without sockets, spread over worker threads that steal
+ * ranges of game indices from each other. Game i only depends on the
+ * tournament seed and i, so results do not depend on the thread count. */
+
+#define TOURNAMENT_MAX_STRATEGIES 8
+
+typedef enum {
+    FORMAT_ROUND_ROBIN,     // Every seating of the strategies, cycled
+    FORMAT_SWISS            // Rounds of tables of neighbours in the standings
+} TournamentFormat;
+
+typedef struct {
+    const RuleSet *rules;
+    const Strategy *strategies[TOURNAMENT_MAX_STRATEGIES];
+    int nbStrategies;
+    TournamentFormat format;
+    long games;             // Total games
+    int rounds;             // Swiss rounds
+    int threads;
+    int maxTurns;           // Longer games count as draws
+    uint64_t seed;
+} TournamentConfig;
+
+typedef struct {
+    long games, draws, turns;
+    long played[TOURNAMENT_MAX_STRATEGIES];     // Seats taken
+    long wins[TOURNAMENT_MAX_STRATEGIES];
+    long beat[TOURNAMENT_MAX_STRATEGIES][TOURNAMENT_MAX_STRATEGIES];   // Wins of i over a seated j
+    double elo[TOURNAMENT_MAX_STRATEGIES];
+    double seconds;
+    long steals;
+} TournamentResult;
+
+int tournament_run(const TournamentConfig *cfg, TournamentResult *res);
+void wilson_interval(long wins, long n, double *lo, double *hi);
+
+#endif
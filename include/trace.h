@@ -0,0 +1,67 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/* Server tracepoints.
+ * Every TRACE_* site is a USDT probe of provider "sh13" when <sys/sdt.h>
+ * is available (systemtap-sdt-dev): a single nop until perf or bpftrace
+ * attaches to it. With --trace=FILE the same sites are also recorded as
+ * Chrome trace events (chrome://tracing, Perfetto); when it is off, each
+ * site costs one predicted branch. */
+
+#if defined(__has_include) && !defined(SH13_NO_SDT)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACE_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef TRACE_HAVE_SDT
+#define TRACE_SDT1(name, a) DTRACE_PROBE1(sh13, name, a)
+#define TRACE_SDT2(name, a, b) DTRACE_PROBE2(sh13, name, a, b)
+#define TRACE_SDT3(name, a, b, c) DTRACE_PROBE3(sh13, name, a, b, c)
+#else
+#define TRACE_SDT1(name, a) ((void)0)
+#define TRACE_SDT2(name, a, b) ((void)0)
+#define TRACE_SDT3(name, a, b, c) ((void)0)
+#endif
+
+#define TRACE_BUF_EVENTS 4096       // Events a thread buffers before writing them out
+
+typedef enum {
+    TRACE_ACCEPT,       // fd
+    TRACE_FRAME,        // fd, type: frame decoded by the reactor
+    TRACE_ENQUEUE,      // fd, queue depth
+    TRACE_QUEUE_WAIT,   // fd, type: span from enqueue to dequeue
+    TRACE_HANDLE,       // fd, type: span of handle_logic
+    TRACE_BROADCAST,    // room, type
+    TRACE_SEND_DONE,    // fd, bytes: outbound backlog fully written
+    TRACE_NB_EVENTS
+} TraceEvent;
+
+extern int traceEnabled;
+
+int trace_open(const char *path);
+void trace_flush(void);
+void trace_close(void);
+void trace_thread_name(const char *name);
+uint64_t trace_now_ns(void);
+void trace_instant(TraceEvent ev, int64_t a, int64_t b);
+void trace_span(TraceEvent ev, uint64_t startNs, uint64_t endNs, int64_t a, int64_t b);
+
+// A probe plus, when recording, an instant event
+#define TRACE_POINT1(name, ev, a) do { \
+    TRACE_SDT1(name, a); \
+    if (__builtin_expect(traceEnabled, 0)) trace_instant(ev, a, 0); \
+} while (0)
+#define TRACE_POINT2(name, ev, a, b) do { \
+    TRACE_SDT2(name, a, b); \
+    if (__builtin_expect(traceEnabled, 0)) trace_instant(ev, a, b); \
+} while (0)
+
+// Start of a span: only read the clock when recording
+#define TRACE_CLOCK() (__builtin_expect(traceEnabled, 0) ? trace_now_ns() : 0)
+
+#endif
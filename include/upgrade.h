@@ -0,0 +1,21 @@
+// upgrade.h
+#ifndef UPGRADE_H
+#define UPGRADE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Hot upgrade: hand the listening socket (and optionally live connections
+ * plus game state) to a freshly exec'd server binary over a Unix socket. */
+
+#define UPGRADE_ENV_FD "SH13_UPGRADE_FD"   // Env var carrying the channel fd in the new process
+
+void upgrade_init(int argc, char *argv[]);
+int upgrade_inherited_channel(void);
+pid_t upgrade_spawn(int *channel);
+int upgrade_send(int channel, const int *fds, int nfds, const void *blob, size_t blobLen);
+int upgrade_recv(int channel, int **fds, int *nfds, void **blob, size_t *blobLen);
+int upgrade_send_ack(int channel);
+int upgrade_wait_ack(int channel, int timeoutMs);
+
+#endif
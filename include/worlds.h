@@ -0,0 +1,45 @@
+// worlds.h
+#ifndef WORLDS_H
+#define WORLDS_H
+
+#include "rules.h"
+
+/* Consistent-world kernel. A world is one way the cards a player cannot
+ * see may lie: a hand per opponent plus the culprit. All the worlds of a
+ * hand are listed once, column by column (one byte per world for each
+ * seat and object count), and a bitmask says which are still possible.
+ * Each MSG_VERIFY answer re-filters the mask over whole columns, 32 (AVX2)
+ * or 16 (SSE2) worlds per instruction, picked at run time. */
+
+#define WORLDS_MAX (4 * 1024 * 1024)
+
+typedef enum {
+    WORLDS_SCALAR,
+    WORLDS_SSE2,
+    WORLDS_AVX2
+} WorldsIsa;
+
+typedef struct {
+    const RuleSet *rules;
+    int nbWorlds;
+    int padded;                                     // nbWorlds rounded up to 64
+    uint8_t *culprit;
+    uint8_t *counts[MAX_PLAYERS][MAX_OBJECTS];      // Seat 0 holds the hand
+    uint32_t *hands[MAX_PLAYERS];                   // Cards of each seat, as bitmasks
+    uint64_t *live;                                 // Worlds still possible
+    int nbLive;
+} WorldSet;
+
+int worlds_build(WorldSet *ws, const RuleSet *rules, const int *hand);
+void worlds_free(WorldSet *ws);
+void worlds_reset(WorldSet *ws);
+int worlds_filter_count(WorldSet *ws, int seat, int object, int lo, int hi);
+int worlds_filter_observe(WorldSet *ws, int object, int found, uint32_t aliveSeats);
+int worlds_filter_card(WorldSet *ws, int card, int isCulprit);
+void worlds_tally(const WorldSet *ws, long *perCulprit, long sums[MAX_PLAYERS][MAX_OBJECTS]);
+
+WorldsIsa worlds_isa(void);
+void worlds_set_isa(WorldsIsa isa);
+const char *worlds_isa_name(WorldsIsa isa);
+
+#endif
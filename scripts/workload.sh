@@ -0,0 +1,32 @@
+#!/bin/sh
+# workload.sh SERVER [GAMES] [TABLES] [PORT]
+# Starts SERVER on loopback, has sh13-bench play GAMES full games on TABLES
+# tables against it, then stops the server with SIGTERM so that it exits
+# normally (PGO profiles and traces are written at exit).
+# Admission limits are lifted: the bench opens hundreds of connections.
+
+SERVER=${1:?usage: $0 SERVER [GAMES] [TABLES] [PORT]}
+GAMES=${2:-5000}
+TABLES=${3:-16}
+PORT=${4:-32190}
+BENCH=${BENCH:-./sh13-bench}
+
+"$SERVER" "$PORT" --rooms="$TABLES" --ratings= \
+    --conn-rate=0 --ip-conn-rate=0 --frame-rate=0 --ip-frame-rate=0 > /dev/null &
+SERVER_PID=$!
+trap 'kill -TERM $SERVER_PID 2>/dev/null' EXIT
+sleep 0.5
+
+"$BENCH" --port="$PORT" --tables="$TABLES" --games="$GAMES"
+STATUS=$?
+
+# CPU time the server itself spent (the bench shares the machine)
+TICKS=$(getconf CLK_TCK)
+awk -v hz="$TICKS" -v games="$GAMES" '{ sub(/^.*\) /, ""); u = $12 / hz; s = $13 / hz;
+    printf "[Bench] server CPU: user %.2f s, sys %.2f s, %.0f us/game\n", u, s, (u + s) * 1e6 / games }' \
+    /proc/$SERVER_PID/stat
+
+kill -TERM $SERVER_PID
+wait $SERVER_PID
+trap - EXIT
+exit $STATUS
@@ -0,0 +1,247 @@
+// admission.c
+#include "../include/admission.h"
+#include "../include/connection.h"
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <netinet/in.h>
+
+#define IP_TABLE_SIZE 4096      // Power of two
+#define IP_PROBE 8              // Slots probed before evicting the stalest
+
+AdmissionLimits admissionLimits = {
+    .connRate        = 200,
+    .connBurst       = 400,
+    .ipConnRate      = 5,
+    .ipConnBurst     = 20,
+    .frameRate       = 20,
+    .frameBurst      = 40,
+    .ipFrameRate     = 100,
+    .ipFrameBurst    = 200,
+    .floodDisconnect = 200,
+    .maxConnections  = CONN_MAX_FD - 64,
+    .shedQueueDepth  = 4096
+};
+
+// Client-to-server messages and the payload sizes they may carry
+typedef struct {
+    uint8_t accepted;
+    uint32_t minLen, maxLen;
+} FrameBounds;
+
+static const FrameBounds frameBounds[256] = {
+    [MSG_CONNECT]  = { 1, sizeof(Payload_Connect),  sizeof(Payload_Connect) },
+    [MSG_ACTION_O] = { 1, sizeof(Payload_Action_O), sizeof(Payload_Action_O) },
+    [MSG_ACTION_S] = { 1, sizeof(Payload_Action_S), sizeof(Payload_Action_S) },
+    [MSG_ACTION_G] = { 1, sizeof(Payload_Action_G), sizeof(Payload_Action_G) },
+    [MSG_PING]     = { 1, sizeof(Payload_Ping),     sizeof(Payload_Ping) },
+    [MSG_RANK_QUERY] = { 1, sizeof(Payload_Rank_Query), sizeof(Payload_Rank_Query) },
+    [MSG_ROOM_LIST]  = { 1, sizeof(Payload_Room_List), sizeof(Payload_Room_List) },
+    [MSG_JOIN_ROOM]  = { 1, sizeof(Payload_Join_Room), sizeof(Payload_Join_Room) },
+    [MSG_CHAT]       = { 1, 1, CHAT_MAX_TEXT },
+    [MSG_RESUME]     = { 1, sizeof(Payload_Resume), sizeof(Payload_Resume) },
+    [MSG_MIGRATE]    = { 1, sizeof(Payload_Migrate), sizeof(Payload_Migrate) },
+    [MSG_ROOM_IMPORT] = { 1, sizeof(Payload_Room_Import), ROOM_IMPORT_MAX },
+};
+
+typedef struct {
+    uint32_t addr;          // IPv4, network order; 0 = free slot
+    uint64_t lastNs;
+    TokenBucket conns;
+    TokenBucket frames;
+} IpEntry;
+
+typedef struct {
+    int tracked;
+    uint32_t addr;          // 0 for local (Unix-domain) peers
+    TokenBucket frames;
+    int throttled;          // Consecutive frames over the rate
+} ConnAdmission;
+
+static IpEntry ipTable[IP_TABLE_SIZE];
+static pthread_mutex_t ipLock = PTHREAD_MUTEX_INITIALIZER;   // ipTable and acceptBucket
+static ConnAdmission connAdmission[CONN_MAX_FD];
+static TokenBucket acceptBucket;
+
+static struct {
+    atomic_ulong accepted;
+    atomic_ulong shedOverload;
+    atomic_ulong connRateRejects;
+    atomic_ulong ipConnRejects;
+    atomic_ulong framesThrottled;
+    atomic_ulong ipFramesThrottled;
+    atomic_ulong frameRejects;
+    atomic_ulong floodDisconnects;
+} admissionStats;
+
+uint64_t admission_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Refill a bucket for the elapsed time and take one token
+ *
+ * A zero rate disables the limit. A bucket never used before starts full.
+ *
+ * @return 1 if a token was taken, 0 if the bucket is empty
+ */
+int bucket_take(TokenBucket *b, double rate, double burst, uint64_t nowNs) {
+    if (rate <= 0) return 1;
+    if (b->lastNs == 0) {
+        b->tokens = burst;
+    } else {
+        b->tokens += rate * (double)(nowNs - b->lastNs) / 1e9;
+        if (b->tokens > burst) b->tokens = burst;
+    }
+    b->lastNs = nowNs;
+    if (b->tokens < 1.0) return 0;
+    b->tokens -= 1.0;
+    return 1;
+}
+
+static uint32_t peer_addr(const struct sockaddr *peer, socklen_t peerLen) {
+    if (!peer || peerLen < sizeof(struct sockaddr_in) || peer->sa_family != AF_INET) return 0;
+    uint32_t addr = ((const struct sockaddr_in *)peer)->sin_addr.s_addr;
+    return addr ? addr : 1; // Keep 0 free to mean "local"
+}
+
+// Find (or claim) the entry of a source IP; caller holds ipLock
+static IpEntry *ip_entry(uint32_t addr, uint64_t nowNs) {
+    uint32_t h = addr * 2654435761u;
+    IpEntry *stalest = NULL;
+    for (int i = 0; i < IP_PROBE; i++) {
+        IpEntry *e = &ipTable[(h + i) & (IP_TABLE_SIZE - 1)];
+        if (e->addr == addr) {
+            e->lastNs = nowNs;
+            return e;
+        }
+        if (e->addr == 0) {
+            stalest = e;
+            break;
+        }
+        if (!stalest || e->lastNs < stalest->lastNs) stalest = e;
+    }
+    memset(stalest, 0, sizeof(*stalest));
+    stalest->addr = addr;
+    stalest->lastNs = nowNs;
+    return stalest;
+}
+
+// Take a token from a source IP's connection or frame bucket
+static int ip_take(uint32_t addr, int frames, uint64_t nowNs) {
+    const AdmissionLimits *l = &admissionLimits;
+    pthread_mutex_lock(&ipLock);
+    IpEntry *e = ip_entry(addr, nowNs);
+    int ok = frames ? bucket_take(&e->frames, l->ipFrameRate, l->ipFrameBurst, nowNs)
+                    : bucket_take(&e->conns, l->ipConnRate, l->ipConnBurst, nowNs);
+    pthread_mutex_unlock(&ipLock);
+    return ok;
+}
+
+/**
+ * @brief Decide whether a freshly accepted connection may stay
+ *
+ * New connections are shed first when the server is overloaded, so the
+ * games already in progress keep their share of the reactor and workers.
+ *
+ * @return 1 to keep the connection, 0 to close it right away
+ */
+int admission_accept(int fd, const struct sockaddr *peer, socklen_t peerLen, int openConns, int queueDepth) {
+    const AdmissionLimits *l = &admissionLimits;
+    uint64_t now = admission_now_ns();
+
+    if ((l->maxConnections > 0 && openConns >= l->maxConnections) ||
+        (l->shedQueueDepth > 0 && queueDepth >= l->shedQueueDepth)) {
+        atomic_fetch_add(&admissionStats.shedOverload, 1);
+        return 0;
+    }
+    pthread_mutex_lock(&ipLock);
+    int ok = bucket_take(&acceptBucket, l->connRate, l->connBurst, now);
+    pthread_mutex_unlock(&ipLock);
+    if (!ok) {
+        atomic_fetch_add(&admissionStats.connRateRejects, 1);
+        return 0;
+    }
+    uint32_t addr = peer_addr(peer, peerLen);
+    if (addr && !ip_take(addr, 0, now)) {
+        atomic_fetch_add(&admissionStats.ipConnRejects, 1);
+        return 0;
+    }
+
+    admission_conn_open(fd, peer, peerLen);
+    atomic_fetch_add(&admissionStats.accepted, 1);
+    return 1;
+}
+
+/**
+ * @brief Start tracking a connection (accepted, inherited or adopted)
+ *
+ * Any thread, before the socket is handed to the reactor.
+ */
+void admission_conn_open(int fd, const struct sockaddr *peer, socklen_t peerLen) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return;
+    ConnAdmission *c = &connAdmission[fd];
+    memset(c, 0, sizeof(*c));
+    c->tracked = 1;
+    c->addr = peer_addr(peer, peerLen);
+}
+
+void admission_conn_close(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return;
+    connAdmission[fd].tracked = 0;
+}
+
+int admission_frame_size_ok(uint8_t type, uint32_t len) {
+    const FrameBounds *b = &frameBounds[type];
+    return b->accepted && len >= b->minLen && len <= b->maxLen;
+}
+
+/**
+ * @brief Police one complete inbound frame before it reaches the pool
+ */
+AdmitResult admission_frame(int fd, uint8_t type, uint32_t len) {
+    const AdmissionLimits *l = &admissionLimits;
+
+    if (!admission_frame_size_ok(type, len)) {
+        atomic_fetch_add(&admissionStats.frameRejects, 1);
+        return ADMIT_CLOSE;
+    }
+    if (fd < 0 || fd >= CONN_MAX_FD) return ADMIT_OK;
+
+    ConnAdmission *c = &connAdmission[fd];
+    if (!c->tracked) admission_conn_open(fd, NULL, 0);
+    // Admin commands from this host (sh13-migrate all) come in bursts and wait for each answer
+    if (type == MSG_MIGRATE && c->addr == 0) return ADMIT_OK;
+
+    uint64_t now = admission_now_ns();
+    int ok = bucket_take(&c->frames, l->frameRate, l->frameBurst, now);
+    if (!ok) {
+        atomic_fetch_add(&admissionStats.framesThrottled, 1);
+    } else if (c->addr && !ip_take(c->addr, 1, now)) {
+        atomic_fetch_add(&admissionStats.ipFramesThrottled, 1);
+        ok = 0;
+    }
+
+    if (ok) {
+        c->throttled = 0;
+        return ADMIT_OK;
+    }
+    if (l->floodDisconnect > 0 && ++c->throttled >= l->floodDisconnect) {
+        atomic_fetch_add(&admissionStats.floodDisconnects, 1);
+        return ADMIT_CLOSE;
+    }
+    return ADMIT_DROP;
+}
+
+void admission_stats_print(FILE *out) {
+    fprintf(out, "[Metrics] accepted=%lu shed_overload=%lu conn_rate_rejects=%lu ip_conn_rejects=%lu "
+                 "frames_throttled=%lu ip_frames_throttled=%lu frame_rejects=%lu flood_disconnects=%lu\n",
+            atomic_load(&admissionStats.accepted), atomic_load(&admissionStats.shedOverload),
+            atomic_load(&admissionStats.connRateRejects), atomic_load(&admissionStats.ipConnRejects),
+            atomic_load(&admissionStats.framesThrottled), atomic_load(&admissionStats.ipFramesThrottled),
+            atomic_load(&admissionStats.frameRejects), atomic_load(&admissionStats.floodDisconnects));
+    fflush(out);
+}
@@ -1,7 +1,10 @@
 // client_logic.c
+// GUI side of the client: one libsh13client session, its network thread,
+// and the snapshot the GUI draws from.
 #include "../include/client_logic.h"
 #include "../include/gui.h"
 #include "../include/common.h" // Includes Protocol definitions
+#include "../include/rules.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,85 +13,69 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <netdb.h>
 
-// External helper from common.c
-extern void send_packet(int sockfd, uint8_t type, const void *payload, uint32_t payload_len);
-extern int recv_all(int sockfd, void *buffer, size_t length);
-
-pthread_mutex_t gameStateMutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t playerDataMutex = PTHREAD_MUTEX_INITIALIZER;
-
-enum {
-    GAME_NOT_CONNECTED = 0,
-    GAME_WAITING = 1,
-    GAME_STARTED = 2,
-    GAME_ENDED = 3
-};
-
-const char *nameobjets[8] = {
-    "Pipe", "Ampoule", "Poing", "Insigne", 
-    "Cahier", "Collier", "Oeil", "Crâne"
-};
-
-char playerNames[4][32];
-int playerCount = 0;
-
 char serverIP[256] = "127.0.0.1";
 
-int socketClient = -1;
-int myClientId = -1;
+static Sh13Client *session;         // The GUI's connection
 char username[32] = "";
-char lastResult[128] = "";
-int myCards[3]= {-1, -1, -1};;
-int objectCounts[8]= {0};
-int gameState = 0;  // 0 = Waiting, 1 = Started, 2 = Ended
-int isMyTurn = 0;
 int gClientPort = 0;
-static int currentTurnPlayerId = -1;
 
-// Object matrices and player states for GUI display
-int objectTable[4][8] = {{0}};
-int playerAlive[4] = {1, 1, 1, 1};
+// The session's state is written by the network thread only and published
+// to the GUI as a versioned snapshot through a seqlock (odd = write in progress)
+static atomic_uint snapshotSeq;
+static ClientSnapshot published;
 
 volatile int synchro = 0;
 
+/**
+ * @brief Make the session state visible to the GUI (network thread only)
+ */
+static void publish_state(void) {
+    unsigned seq = atomic_load_explicit(&snapshotSeq, memory_order_relaxed);
+    atomic_store_explicit(&snapshotSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&published, sh13_client_state(session), sizeof(published));
+    published.version = seq / 2 + 1;
+    atomic_store_explicit(&snapshotSeq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief Version of the latest published state, without copying it
+ */
+unsigned client_snapshot_version(void) {
+    return atomic_load_explicit(&snapshotSeq, memory_order_acquire) / 2;
+}
+
+/**
+ * @brief Copy a consistent snapshot of the client state, lock-free
+ *
+ * Retries only if the network thread published during the copy.
+ *
+ * @return The snapshot's version
+ */
+unsigned client_snapshot(ClientSnapshot *out) {
+    for (;;) {
+        unsigned before = atomic_load_explicit(&snapshotSeq, memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(out, &published, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&snapshotSeq, memory_order_relaxed) == before) {
+            out->version = before / 2;
+            return out->version;
+        }
+    }
+}
+
 void setUsername(const char *name) {
-    strncpy(username, name, sizeof(username));
+    snprintf(username, sizeof(username), "%s", name);
 }
 
 const char* getUsername() {
     return username;
 }
 
-const char* getLastResult() {
-    static char safeResult[128];
-    pthread_mutex_lock(&gameStateMutex);
-    strncpy(safeResult, lastResult, sizeof(safeResult)-1);
-    pthread_mutex_unlock(&gameStateMutex);
-    return safeResult;
-}
-
-int* getMyCards() {
-    return myCards;
-}
-
-int* getObjectCounts() {
-    return objectCounts;
-}
-
-int isTurn() {
-    int turnStatus;
-    pthread_mutex_lock(&gameStateMutex);
-    turnStatus = isMyTurn;
-    pthread_mutex_unlock(&gameStateMutex);
-    return turnStatus;
-}
-
-int isGameEnded() {
-    return gameState == GAME_ENDED;
-}
-
 void getLocalIP(char *ip, size_t len) {
     char hostname[256];
     struct hostent *host;
@@ -103,124 +90,69 @@ void getLocalIP(char *ip, size_t len) {
 }
 
 void sendMessageToServer(char *ip, int port, char *mess) {
-    if (socketClient < 0) return;
-    send(socketClient, mess, strlen(mess), 0);
+    if (!session || sh13_client_fd(session) < 0) return;
+    send(sh13_client_fd(session), mess, strlen(mess), 0);
 }
 
-// New Binary Action Senders
+// Binary action senders, through the session
 void sendConnect(const char* name, int port) {
-    Payload_Connect pkg;
-    strncpy(pkg.name, name, 39);
-    pkg.port = port;
-    getLocalIP(pkg.ip, 40);
-    send_packet(socketClient, MSG_CONNECT, &pkg, sizeof(pkg));
+    if (session) sh13_client_send_connect(session, name, port);
 }
 
 void sendActionO(int objId) {
-    Payload_Action_O pkg = { .asking_player_id = myClientId, .object_id = objId };
-    send_packet(socketClient, MSG_ACTION_O, &pkg, sizeof(pkg));
+    if (session) sh13_client_observe(session, objId);
 }
 
 void sendActionS(int targetId, int objId) {
-    Payload_Action_S pkg = { .asking_player_id = myClientId, .target_player_id = targetId, .object_id = objId };
-    send_packet(socketClient, MSG_ACTION_S, &pkg, sizeof(pkg));
+    if (session) sh13_client_speculate(session, targetId, objId);
 }
 
 void sendActionG(int cardId) {
-    Payload_Action_G pkg = { .asking_player_id = myClientId, .guessed_card_id = cardId };
-    send_packet(socketClient, MSG_ACTION_G, &pkg, sizeof(pkg));
+    if (session) sh13_client_guess(session, cardId);
 }
 
-void* listenToServer(void *arg) {
-    while (1) {
-        PacketHeader header;
-        if (recv_all(socketClient, &header, sizeof(PacketHeader)) < 0) {
-            printf("Disconnected from server.\n");
-            break;
-        }
+// Latency probe; the round trip shows up in the snapshot's rttUs
+void sendPing(void) {
+    if (session && sh13_client_fd(session) >= 0) sh13_client_ping(session);
+}
 
-        uint32_t len = ntohl(header.length);
-        void *buffer = NULL;
-        
-        // Receive Payload (if exists)
-        if (len > 0) {
-            buffer = malloc(len);
-            recv_all(socketClient, buffer, len);
-        }
+// Session callbacks, run on the network thread
 
-        // Lock State for processing
-        pthread_mutex_lock(&gameStateMutex);
-        switch (header.type) {
-            case MSG_ID_ASSIGN: {
-                Payload_ID_Assign *p = (Payload_ID_Assign*)buffer;
-                myClientId = p->playerId;
-                printf("[Client] Assigned ID: %d\n", myClientId);
-                break;
-            }
-            case MSG_PLAYER_LIST: {
-                Payload_Player_List *p = (Payload_Player_List*)buffer;
-                pthread_mutex_lock(&playerDataMutex);
-                if (p->id >= 0 && p->id < 4) {
-                    strncpy(playerNames[p->id], p->name, 32);
-                    // Update player count based on the highest ID received + 1
-                    if (p->id >= playerCount) {
-                        playerCount = p->id + 1;
-                    }
-                }
-                pthread_mutex_unlock(&playerDataMutex);
-                if (p->id == myClientId) {
-                    printf("[Client] Lobby Update: Player %d is %s\n", p->id, p->name);
-                }
-                break;
-            }
-            case MSG_DISTRIBUTE: {
-                Payload_Distribute *p = (Payload_Distribute*)buffer;
-                memcpy(myCards, p->Cards, sizeof(myCards));
-                // memcpy(objectCounts, p->objCounts, sizeof(objectCounts)); // If server sends counts
-                gameState = GAME_STARTED; // STARTED
-                snprintf(lastResult, 128, "Game Started!");
-
-                pthread_mutex_lock(&playerDataMutex);
-                playerCount = 4; 
-                pthread_mutex_unlock(&playerDataMutex);
-                break;
-            }
-            case MSG_TURN: {
-                Payload_Turn *p = (Payload_Turn*)buffer;
-                isMyTurn = (p->player_id == myClientId);
-
-                currentTurnPlayerId = p->player_id;
-                snprintf(lastResult, 128, "Player %d's Turn", p->player_id);
-                break;
-            }
-            case MSG_VERIFY: {
-                Payload_Verify *p = (Payload_Verify*)buffer;
-                if (p->target_player_id == -1) {
-                    snprintf(lastResult, 128, "Global Check: Object %s %s found", 
-                             nameobjets[p->object_id], p->result_val ? "IS" : "NOT");
-                } else {
-                    snprintf(lastResult, 128, "Player %d has %d of %s", 
-                             p->target_player_id, p->result_val, nameobjets[p->object_id]);
-                }
-                break;
-            }
-            case MSG_GAME_OVER: {
-                Payload_Game_Over *p = (Payload_Game_Over*)buffer;
-                if (p->is_winner) {
-                    snprintf(lastResult, 128, "Player %d WINS!", p->player_id);
-                    setShowEndDialog(1);
-                    gameState = GAME_ENDED;
-                } else {
-                    snprintf(lastResult, 128, "Player %d Eliminated.", p->player_id);
-                }
-                break;
-            }
-        }
-        pthread_mutex_unlock(&gameStateMutex);
-        if (buffer) free(buffer);
+static void on_id_assign(Sh13Client *c, const Payload_ID_Assign *p, void *user) {
+    printf("[Client] Assigned ID: %d\n", p->playerId);
+}
 
-        usleep(1000);
+static void on_rules(Sh13Client *c, const RuleSet *rules, void *user) {
+    printf("[Client] Rules: %s (%d players, %d cards)\n", rules->name, rules->nbPlayers, rules->nbCards);
+}
+
+static void on_player_list(Sh13Client *c, const Payload_Player_List *p, void *user) {
+    if (p->id == sh13_client_state(c)->myClientId) {
+        printf("[Client] Lobby Update: Player %d is %s\n", p->id, p->name);
     }
+}
+
+static void on_game_over(Sh13Client *c, const Payload_Game_Over *p, void *user) {
+    if (p->is_winner) setShowEndDialog(1);
+}
+
+// A whole read applied: the screen reflects the new state in one frame
+static void on_batch(Sh13Client *c, void *user) {
+    publish_state();
+    gui_request_redraw();
+}
+
+static void on_disconnect(Sh13Client *c, void *user) {
+    printf("Disconnected from server.\n");
+    publish_state();
+    gui_request_redraw();
+}
+
+/**
+ * @brief Network thread: dispatch server frames until the connection ends
+ */
+static void* listenToServer(void *arg) {
+    sh13_client_run(session);
     return NULL;
 }
 
@@ -231,58 +163,35 @@ void connectToServer(const char *ip, int port) {
         isFirstConnect = 0;
     }
 
-    struct sockaddr_in addr;
-    socketClient = socket(AF_INET, SOCK_STREAM, 0);
-    if (socketClient < 0) {
-        perror("socket");
+    static const Sh13Callbacks callbacks = {
+        .onIdAssign = on_id_assign,
+        .onRules = on_rules,
+        .onPlayerList = on_player_list,
+        .onGameOver = on_game_over,
+        .onBatch = on_batch,
+        .onDisconnect = on_disconnect,
+    };
+    session = sh13_client_new(&callbacks, NULL);
+
+    // "unix:/path" endpoints use the server's Unix-domain socket
+    if (!session || sh13_client_connect(session, ip, port) < 0) {
+        perror("connect");
         exit(1);
     }
 
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr.s_addr = inet_addr(ip);
-
-    if (connect(socketClient, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        perror("connect");
-        exit(1);
+    if (strncmp(ip, ENDPOINT_UNIX_PREFIX, strlen(ENDPOINT_UNIX_PREFIX)) == 0) {
+        printf("✅ Connected to server: %s\n", ip);
+    } else {
+        printf("✅ Connected to server: %s:%d\n", ip, port);
     }
 
-    printf("✅ Connected to server: %s:%d\n", ip, port);
+    // Classic rules until the server sends its own
+    publish_state();
 
     pthread_t tid;
     pthread_create(&tid, NULL, listenToServer, NULL);
 }
 
-int getIsGameEnded() {
-    return gameState == GAME_ENDED;
-}
-
-const char* getPlayerName(int index) {
-    const char *name = "";
-    pthread_mutex_lock(&playerDataMutex);
-    if (index >= 0 && index < 4) {
-        name = playerNames[index];
-    }
-    pthread_mutex_unlock(&playerDataMutex);
-    return name;
-}
-
-int getPlayerCount() {
-    int count;
-    pthread_mutex_lock(&playerDataMutex);
-    count = playerCount;
-    pthread_mutex_unlock(&playerDataMutex);
-    return count;
-}
-
-int getIsGameStarted() {
-    int status;
-    pthread_mutex_lock(&gameStateMutex);
-    status = (gameState == GAME_STARTED);
-    pthread_mutex_unlock(&gameStateMutex);
-    return status;
-}
-
 int isUsernameSet() {
     return username[0] != '\0';
 }
@@ -290,47 +199,3 @@ int isUsernameSet() {
 int getClientPort() {
     return gClientPort;
 }
-
-int getTableValue(int playerId, int objectId) {
-    if (playerId >= 0 && playerId < 4 && objectId >= 0 && objectId < 8) {
-        return objectTable[playerId][objectId];
-    }
-    return 0;
-}
-
-int isPlayerAlive(int playerId) {
-    if (playerId >= 0 && playerId < 4) {
-        return playerAlive[playerId];
-    }
-    return 0;
-}
-
-int getCurrentPlayer() {
-    return isTurn() ? myClientId : -1;
-}
-
-void updateCurrentTurn(int id) {
-    pthread_mutex_lock(&gameStateMutex);
-    currentTurnPlayerId = id;
-    pthread_mutex_unlock(&gameStateMutex);
-}
-
-int getCurrentTurnPlayer() {
-    int id;
-    pthread_mutex_lock(&gameStateMutex);
-    id = currentTurnPlayerId;
-    pthread_mutex_unlock(&gameStateMutex);
-    return id;
-}
-
-int getIsConnected() {
-    int connected;
-    pthread_mutex_lock(&gameStateMutex);
-    connected = (myClientId != -1); // If the ID is not -1, it means the connection is established.
-    pthread_mutex_unlock(&gameStateMutex);
-    return connected;
-}
-
-int getMyClientId() {
-    return myClientId;
-}
\ No newline at end of file
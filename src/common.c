@@ -2,9 +2,12 @@
 #include "../include/common.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 
 /**
@@ -65,4 +68,53 @@ void send_packet(int sockfd, uint8_t type, const void *payload, uint32_t payload
             perror("Failed to send payload");
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Open a stream connection to a server endpoint
+ *
+ * "unix:/path" connects to the server's Unix-domain socket (same host, no
+ * TCP stack); anything else is an IPv4 address used with the given port.
+ *
+ * @return Connected socket, or -1 on failure (errno set)
+ */
+int connect_endpoint(const char *endpoint, int port) {
+    int sock;
+
+    if (strncmp(endpoint, ENDPOINT_UNIX_PREFIX, strlen(ENDPOINT_UNIX_PREFIX)) == 0) {
+        const char *path = endpoint + strlen(ENDPOINT_UNIX_PREFIX);
+        struct sockaddr_un addr;
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) return -1;
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr(endpoint);
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    // Actions are tiny frames: do not hold them back waiting for an ACK
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return sock;
+}
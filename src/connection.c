@@ -0,0 +1,481 @@
+// connection.c
+#include "../include/connection.h"
+#include "../include/trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#define CONN_READ_CHUNK 4096
+
+ConnLimits connLimits = {
+    .outLowWatermark  = 16 * 1024,
+    .outHighWatermark = 64 * 1024,
+    .outLimit         = 256 * 1024,
+    .lowLimit         = 32 * 1024,
+    .slowPolicy       = SLOW_DISCONNECT,
+    .inMaxFrame       = 4096
+};
+
+typedef struct {
+    pthread_mutex_t lock;
+    int open;
+    int closing;        // Shut down by a worker, the reactor closes the fd
+    int readPaused;     // Input not read while the outbound backlog is high
+    // Inbound frame assembly
+    char *in;
+    size_t inLen, inCap;
+    // Outbound backlog: bytes [outHead, outLen) are still to be sent
+    char *out;
+    size_t outHead, outLen, outCap;
+    // Low lane: whole SEND_CHAT frames, moved to the backlog once it is empty
+    char *low;
+    size_t lowHead, lowLen, lowCap;
+} Connection;
+
+// Slow-consumer metrics
+static struct {
+    atomic_ulong readPauses;
+    atomic_ulong readResumes;
+    atomic_ulong spectatorDrops;
+    atomic_ulong spectatorDropBytes;
+    atomic_ulong slowDisconnects;
+    atomic_ulong peakBacklog;
+    atomic_ulong oversizeFrames;
+    atomic_ulong lowDrops;
+} connStats;
+
+static Connection *connTable[CONN_MAX_FD];
+static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
+static int connEpollFd = -1;
+static atomic_int openCount;
+
+void conn_init(int epollFd) {
+    connEpollFd = epollFd;
+}
+
+static Connection *conn_get(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return NULL;
+    return connTable[fd];
+}
+
+static size_t backlog(const Connection *c) {
+    return c->outLen - c->outHead;
+}
+
+// Interest set follows the connection state; caller holds c->lock
+static void update_events(int fd, Connection *c, int op) {
+    struct epoll_event ev;
+    ev.events = EPOLLET | EPOLLRDHUP;
+    if (!c->readPaused) ev.events |= EPOLLIN;
+    if (backlog(c) > 0) ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+    epoll_ctl(connEpollFd, op, fd, &ev);
+}
+
+/**
+ * @brief Register a freshly accepted (non-blocking) socket with the reactor
+ */
+int conn_open(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return -1;
+
+    pthread_mutex_lock(&tableLock);
+    if (!connTable[fd]) {
+        connTable[fd] = calloc(1, sizeof(Connection));
+        pthread_mutex_init(&connTable[fd]->lock, NULL);
+    }
+    pthread_mutex_unlock(&tableLock);
+
+    Connection *c = connTable[fd];
+    pthread_mutex_lock(&c->lock);
+    c->open = 1;
+    c->closing = 0;
+    c->readPaused = 0;
+    c->inLen = 0;
+    c->outHead = c->outLen = 0;
+    c->lowHead = c->lowLen = 0;
+    update_events(fd, c, EPOLL_CTL_ADD);
+    pthread_mutex_unlock(&c->lock);
+    atomic_fetch_add(&openCount, 1);
+    return 0;
+}
+
+/**
+ * @brief Unregister and close a connection (reactor thread only)
+ */
+void conn_close(int fd) {
+    Connection *c = conn_get(fd);
+    if (!c) return;
+    pthread_mutex_lock(&c->lock);
+    if (c->open) {
+        c->open = 0;
+        free(c->in);
+        free(c->out);
+        free(c->low);
+        c->in = c->out = c->low = NULL;
+        c->inLen = c->inCap = 0;
+        c->outHead = c->outLen = c->outCap = 0;
+        c->lowHead = c->lowLen = c->lowCap = 0;
+        epoll_ctl(connEpollFd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        atomic_fetch_sub(&openCount, 1);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+int conn_is_open(int fd) {
+    Connection *c = conn_get(fd);
+    return c && c->open && !c->closing;
+}
+
+// Ask the reactor to drop the connection without racing it on the fd number
+static void mark_closing(int fd, Connection *c) {
+    if (c->closing) return;
+    c->closing = 1;
+    shutdown(fd, SHUT_RDWR);
+}
+
+static int append_locked(Connection *c, const void *data, size_t len);
+
+/**
+ * @brief Move whole low-lane frames, up to CONN_LOW_CHUNK bytes, into the empty backlog
+ *
+ * A game frame queued afterwards waits behind at most that chunk.
+ */
+static int promote_low_locked(Connection *c) {
+    size_t end = c->lowHead;
+    while (end < c->lowLen) {
+        PacketHeader header;
+        memcpy(&header, c->low + end, sizeof(header));
+        size_t frameLen = sizeof(header) + ntohl(header.length);
+        if (end > c->lowHead && end + frameLen - c->lowHead > CONN_LOW_CHUNK) break;
+        end += frameLen;
+    }
+    if (append_locked(c, c->low + c->lowHead, end - c->lowHead) < 0) return -1;
+    c->lowHead = end;
+    if (c->lowHead == c->lowLen) c->lowHead = c->lowLen = 0;
+    return 0;
+}
+
+// Send as much of the backlog (then of the low lane) as the socket accepts; caller holds c->lock
+static int flush_locked(int fd, Connection *c) {
+    for (;;) {
+        size_t sent = 0;
+        while (backlog(c) > 0) {
+            ssize_t n = send(fd, c->out + c->outHead, backlog(c), MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return -1;
+            }
+            c->outHead += n;
+            sent += n;
+        }
+        if (backlog(c) > 0) return 0;
+        if (sent > 0) TRACE_POINT2(send_done, TRACE_SEND_DONE, fd, (int64_t)sent);
+        c->outHead = c->outLen = 0;
+        if (c->lowLen == c->lowHead) return 0;
+        if (promote_low_locked(c) < 0) return -1;
+    }
+}
+
+// Queue a whole frame on the low lane, or drop it when the lane is full
+static int append_low_locked(Connection *c, const PacketHeader *header, const void *payload, uint32_t len) {
+    size_t frameLen = sizeof(*header) + len;
+    if (c->lowLen - c->lowHead + frameLen > connLimits.lowLimit) return -1;
+    if (c->lowHead > 0 && c->lowLen + frameLen > c->lowCap) {
+        memmove(c->low, c->low + c->lowHead, c->lowLen - c->lowHead);
+        c->lowLen -= c->lowHead;
+        c->lowHead = 0;
+    }
+    if (c->lowLen + frameLen > c->lowCap) {
+        size_t cap = c->lowCap ? c->lowCap : 1024;
+        while (cap < c->lowLen + frameLen) cap *= 2;
+        char *grown = realloc(c->low, cap);
+        if (!grown) return -1;
+        c->low = grown;
+        c->lowCap = cap;
+    }
+    memcpy(c->low + c->lowLen, header, sizeof(*header));
+    if (len > 0) memcpy(c->low + c->lowLen + sizeof(*header), payload, len);
+    c->lowLen += frameLen;
+    return 0;
+}
+
+static int append_locked(Connection *c, const void *data, size_t len) {
+    if (c->outHead > 0 && c->outLen + len > c->outCap) {
+        memmove(c->out, c->out + c->outHead, backlog(c));
+        c->outLen -= c->outHead;
+        c->outHead = 0;
+    }
+    if (c->outLen + len > c->outCap) {
+        size_t cap = c->outCap ? c->outCap : 1024;
+        while (cap < c->outLen + len) cap *= 2;
+        char *grown = realloc(c->out, cap);
+        if (!grown) return -1;
+        c->out = grown;
+        c->outCap = cap;
+    }
+    memcpy(c->out + c->outLen, data, len);
+    c->outLen += len;
+    return 0;
+}
+
+// Hand every complete buffered frame to onFrame; caller holds c->lock
+static int dispatch_locked(int fd, Connection *c, FrameHandler onFrame) {
+    size_t off = 0;
+    int rc = 0;
+    while (c->inLen - off >= sizeof(PacketHeader)) {
+        PacketHeader header;
+        memcpy(&header, c->in + off, sizeof(header));
+        uint32_t len = ntohl(header.length);
+        // Refuse before buffering: the length is whatever the client claims
+        if (len > connLimits.inMaxFrame) {
+            atomic_fetch_add(&connStats.oversizeFrames, 1);
+            rc = -1;
+            break;
+        }
+        if (c->inLen - off - sizeof(header) < len) break;
+        if (onFrame(fd, &header, len ? c->in + off + sizeof(header) : NULL) < 0) {
+            rc = -1;
+            break;
+        }
+        off += sizeof(header) + len;
+    }
+    if (off > 0) {
+        memmove(c->in, c->in + off, c->inLen - off);
+        c->inLen -= off;
+    }
+    return rc;
+}
+
+/**
+ * @brief Read everything available and hand each complete frame to onFrame
+ *
+ * Frames are dispatched after every read, so the inbound buffer stays
+ * within one maximal frame plus one read chunk whatever the client sends.
+ *
+ * @return 0 while the connection stays open, -1 if it must be closed
+ */
+int conn_read(int fd, FrameHandler onFrame) {
+    Connection *c = conn_get(fd);
+    if (!c || !c->open) return -1;
+
+    pthread_mutex_lock(&c->lock);
+    if (c->closing) {
+        pthread_mutex_unlock(&c->lock);
+        return -1;
+    }
+    if (c->readPaused) {
+        pthread_mutex_unlock(&c->lock);
+        return 0;
+    }
+
+    int closed = 0;
+    while (!closed) {
+        if (c->inCap - c->inLen < CONN_READ_CHUNK) {
+            size_t cap = c->inCap ? c->inCap * 2 : CONN_READ_CHUNK * 2;
+            char *grown = realloc(c->in, cap);
+            if (!grown) { closed = 1; break; }
+            c->in = grown;
+            c->inCap = cap;
+        }
+        ssize_t n = recv(fd, c->in + c->inLen, c->inCap - c->inLen, 0);
+        if (n > 0) {
+            c->inLen += n;
+            if (dispatch_locked(fd, c, onFrame) < 0) closed = 1;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closed = 1; // EOF or error
+    }
+    // Frames restored by a hot upgrade have not been seen yet
+    if (!closed && dispatch_locked(fd, c, onFrame) < 0) closed = 1;
+    pthread_mutex_unlock(&c->lock);
+    return closed ? -1 : 0;
+}
+
+/**
+ * @brief EPOLLOUT: flush the backlog and resume reading once it has drained
+ */
+void conn_on_writable(int fd) {
+    Connection *c = conn_get(fd);
+    if (!c || !c->open) return;
+
+    pthread_mutex_lock(&c->lock);
+    if (flush_locked(fd, c) < 0) {
+        mark_closing(fd, c);
+    } else {
+        if (c->readPaused && backlog(c) <= connLimits.outLowWatermark) {
+            c->readPaused = 0;
+            atomic_fetch_add(&connStats.readResumes, 1);
+        }
+        update_events(fd, c, EPOLL_CTL_MOD);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+/**
+ * @brief Queue a TLV packet for a client without ever blocking
+ *
+ * The frame is written straight to the socket when nothing is pending,
+ * otherwise appended to the backlog. Above the high watermark the client's
+ * input is paused; above the limit the slow-consumer policy applies.
+ * SEND_CHAT frames go to the low lane instead and only leave once the
+ * game backlog is empty.
+ *
+ * @return 0 if queued or sent, -1 if dropped or the connection is gone
+ */
+int conn_send_packet(int fd, uint8_t type, const void *payload, uint32_t len, SendClass cls) {
+    Connection *c = conn_get(fd);
+    if (!c) return -1;
+
+    pthread_mutex_lock(&c->lock);
+    if (!c->open || c->closing) {
+        pthread_mutex_unlock(&c->lock);
+        return -1;
+    }
+
+    size_t pending = backlog(c);
+    if (cls == SEND_CHAT) {
+        PacketHeader header = { .type = type, .length = htonl(len) };
+        if (append_low_locked(c, &header, payload, len) < 0) {
+            atomic_fetch_add(&connStats.lowDrops, 1);
+            pthread_mutex_unlock(&c->lock);
+            return -1;
+        }
+        if (pending == 0) {
+            if (flush_locked(fd, c) < 0) {
+                mark_closing(fd, c);
+                pthread_mutex_unlock(&c->lock);
+                return -1;
+            }
+            if (backlog(c) > 0) update_events(fd, c, EPOLL_CTL_MOD);
+        }
+        pthread_mutex_unlock(&c->lock);
+        return 0;
+    }
+
+    size_t frameLen = sizeof(PacketHeader) + len;
+    if (pending + frameLen > connLimits.outLimit) {
+        int drop = connLimits.slowPolicy == SLOW_DROP_SPECTATOR && cls == SEND_SPECTATOR;
+        int hardCap = connLimits.slowPolicy == SLOW_DROP_SPECTATOR ? 2 * connLimits.outLimit : connLimits.outLimit;
+        if (drop) {
+            atomic_fetch_add(&connStats.spectatorDrops, 1);
+            atomic_fetch_add(&connStats.spectatorDropBytes, frameLen);
+            pthread_mutex_unlock(&c->lock);
+            return -1;
+        }
+        if (pending + frameLen > hardCap) {
+            atomic_fetch_add(&connStats.slowDisconnects, 1);
+            printf("[Server] Slow consumer on socket %d (%zu bytes pending), disconnecting.\n", fd, pending);
+            mark_closing(fd, c);
+            pthread_mutex_unlock(&c->lock);
+            return -1;
+        }
+    }
+
+    PacketHeader header;
+    header.type = type;
+    header.length = htonl(len);
+    int failed = append_locked(c, &header, sizeof(header)) < 0 ||
+                 (len > 0 && append_locked(c, payload, len) < 0);
+    if (!failed && pending == 0) failed = flush_locked(fd, c) < 0;
+    if (failed) {
+        mark_closing(fd, c);
+        pthread_mutex_unlock(&c->lock);
+        return -1;
+    }
+
+    size_t now = backlog(c);
+    if (now > atomic_load(&connStats.peakBacklog)) atomic_store(&connStats.peakBacklog, now);
+    if (!c->readPaused && now > connLimits.outHighWatermark) {
+        c->readPaused = 1;
+        atomic_fetch_add(&connStats.readPauses, 1);
+    }
+    if (now > 0 || pending > 0) update_events(fd, c, EPOLL_CTL_MOD);
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+}
+
+int conn_count(void) {
+    return atomic_load(&openCount);
+}
+
+int conn_list(int *fds, int max) {
+    int n = 0;
+    for (int fd = 0; fd < CONN_MAX_FD && n < max; fd++) {
+        if (connTable[fd] && connTable[fd]->open) fds[n++] = fd;
+    }
+    return n;
+}
+
+/**
+ * @brief Stop watching a connection, keeping its buffers (hot upgrade)
+ */
+void conn_detach(int fd) {
+    epoll_ctl(connEpollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void conn_attach(int fd) {
+    Connection *c = conn_get(fd);
+    if (!c || !c->open) return;
+    pthread_mutex_lock(&c->lock);
+    update_events(fd, c, EPOLL_CTL_ADD);
+    pthread_mutex_unlock(&c->lock);
+}
+
+/**
+ * @brief Expose the buffered bytes of a detached connection (hot upgrade)
+ *
+ * Only valid while no worker can touch the connection. The low lane is
+ * not handed over: chat still queued there is lost.
+ */
+int conn_get_buffers(int fd, const void **in, size_t *inLen, const void **out, size_t *outLen) {
+    Connection *c = conn_get(fd);
+    if (!c || !c->open) return -1;
+    *in = c->in;
+    *inLen = c->inLen;
+    *out = c->out + c->outHead;
+    *outLen = backlog(c);
+    return 0;
+}
+
+/**
+ * @brief Preload the buffers of an inherited connection (hot upgrade)
+ */
+int conn_restore_buffers(int fd, const void *in, size_t inLen, const void *out, size_t outLen) {
+    Connection *c = conn_get(fd);
+    if (!c || !c->open) return -1;
+
+    pthread_mutex_lock(&c->lock);
+    if (inLen > 0) {
+        c->in = malloc(inLen + CONN_READ_CHUNK);
+        c->inCap = inLen + CONN_READ_CHUNK;
+        memcpy(c->in, in, inLen);
+        c->inLen = inLen;
+    }
+    int rc = outLen > 0 ? append_locked(c, out, outLen) : 0;
+    if (backlog(c) > connLimits.outHighWatermark) c->readPaused = 1;
+    update_events(fd, c, EPOLL_CTL_MOD);
+    pthread_mutex_unlock(&c->lock);
+    return rc;
+}
+
+void conn_stats_print(FILE *out) {
+    fprintf(out, "[Metrics] connections=%d read_pauses=%lu read_resumes=%lu "
+                 "spectator_drops=%lu (%lu bytes) low_drops=%lu slow_disconnects=%lu peak_backlog=%lu oversize_frames=%lu\n",
+            conn_count(),
+            atomic_load(&connStats.readPauses), atomic_load(&connStats.readResumes),
+            atomic_load(&connStats.spectatorDrops), atomic_load(&connStats.spectatorDropBytes),
+            atomic_load(&connStats.lowDrops),
+            atomic_load(&connStats.slowDisconnects), atomic_load(&connStats.peakBacklog),
+            atomic_load(&connStats.oversizeFrames));
+    fflush(out);
+}
@@ -0,0 +1,142 @@
+// game.c
+#include "../include/game.h"
+#include <string.h>
+
+/**
+ * @brief Set up a game for a rule set; nothing is dealt yet
+ *
+ * @param seed Same seed, same deals: games are reproducible one by one
+ */
+void game_init(Game *g, const RuleSet *rules, uint64_t seed) {
+    memset(g, 0, sizeof(*g));
+    g->rules = rules;
+    g->rng = seed;
+    g->crimeCard = -1;
+    g->winner = -1;
+    for (int i = 0; i < MAX_PLAYERS; i++) g->alive[i] = 1;
+}
+
+/**
+ * @brief Uniform integer in [0, bound) from the game's own generator
+ *
+ * splitmix64 step, then a multiply-shift range reduction: no shared state,
+ * so parallel games never contend or disturb each other's sequence.
+ */
+uint32_t game_rand(Game *g, uint32_t bound) {
+    uint64_t z = (g->rng += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return (uint32_t)(((z >> 32) * (uint64_t)bound) >> 32);
+}
+
+void game_shuffle(Game *g) {
+    int nbCards = g->rules->nbCards;
+    for (int i = 0; i < nbCards; i++) g->deck[i] = i;
+    for (int i = nbCards - 1; i > 0; i--) {
+        int j = game_rand(g, i + 1);
+        int temp = g->deck[i];
+        g->deck[i] = g->deck[j];
+        g->deck[j] = temp;
+    }
+}
+
+/**
+ * @brief Sum the symbols of each player's hand into the table
+ *
+ * Always inlined so that calls with constant shapes get fully unrolled
+ * loops; the object loop always runs MAX_OBJECTS wide (unused objects
+ * count zero) and vectorizes.
+ */
+static inline __attribute__((always_inline)) void deal_table_shape(Game *g, int players, int hand) {
+    for (int player = 0; player < players; player++) {
+        for (int c = 0; c < hand; c++) {
+            const uint8_t *objects = g->rules->cardObjects[g->deck[player * hand + c]];
+            for (int obj = 0; obj < MAX_OBJECTS; obj++) g->table[player][obj] += objects[obj];
+        }
+    }
+}
+
+void game_deal(Game *g) {
+    const RuleSet *r = g->rules;
+
+    // Initialize all players' symbol counts to 0
+    memset(g->table, 0, sizeof(g->table));
+
+    // Specialized for the common tables, generic for custom rule sets
+    if (r->nbPlayers == 4 && r->handSize == 3) {
+        deal_table_shape(g, 4, 3);
+    } else if (r->nbPlayers == 3 && r->handSize == 4) {
+        deal_table_shape(g, 3, 4);
+    } else {
+        deal_table_shape(g, r->nbPlayers, r->handSize);
+    }
+}
+
+/**
+ * @brief Shuffle, deal and pick the culprit (the card left over)
+ */
+void game_start(Game *g) {
+    game_shuffle(g);
+    game_deal(g);
+    g->crimeCard = g->deck[g->rules->nbCards - 1];
+    for (int i = 0; i < g->rules->nbPlayers; i++) g->alive[i] = 1;
+    g->current = 0;
+    g->winner = -1;
+}
+
+const int *game_hand(const Game *g, int player) {
+    return &g->deck[player * g->rules->handSize];
+}
+
+/**
+ * @brief O: does any player still in the game hold this object?
+ */
+int game_observe(const Game *g, int object) {
+    for (int p = 0; p < g->rules->nbPlayers; p++) {
+        if (g->alive[p] && g->table[p][object] > 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief S: how many of this object a player holds
+ */
+int game_speculate(const Game *g, int target, int object) {
+    return g->table[target][object];
+}
+
+/**
+ * @brief G: a right guess wins, a wrong one eliminates the player
+ *
+ * @return 1 if the player won
+ */
+int game_guess(Game *g, int player, int card) {
+    if (card == g->crimeCard) {
+        g->winner = player;
+        return 1;
+    }
+    g->alive[player] = 0;
+    return 0;
+}
+
+/**
+ * @brief Pass the turn to the next player still in the game
+ *
+ * @return The new current seat
+ */
+int game_advance_turn(Game *g) {
+    int nbPlayers = g->rules->nbPlayers;
+    int attempts = 0;
+    do {
+        g->current = (g->current + 1) % nbPlayers;
+        attempts++;
+    } while (!g->alive[g->current] && attempts <= nbPlayers);
+    return g->current;
+}
+
+int game_alive_count(const Game *g) {
+    int n = 0;
+    for (int p = 0; p < g->rules->nbPlayers; p++) n += g->alive[p];
+    return n;
+}
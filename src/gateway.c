@@ -0,0 +1,732 @@
+// gateway.c
+#include "../include/gateway.h"
+#include "../include/hashring.h"
+#include "../include/sh13client.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+extern int send_all(int sockfd, const void *buffer, size_t length);
+
+typedef struct {
+    char name[128];             // As configured; empty: free slot
+    char host[112];
+    int port;
+    int listed;                 // In the configuration; 0: draining, freed after its last session
+    int up;                     // Directory fully read: on the ring
+    int inLobby;                // Its rooms were in the lobby at the last ring_update()
+    Sh13Client *feed;           // Directory feed (subscribed MSG_ROOM_LIST)
+    int feedFd;
+    uint64_t retryNs;
+    int total;                  // Rooms the backend hosts
+    Room_Info rooms[ROOM_DELTA_MAX];    // By the backend's own room id
+    int sessions;
+    unsigned long routed;
+} Backend;
+
+// One direction of a routed session: bytes parked in a pipe between splice() calls
+typedef struct {
+    int pipe[2];
+    size_t pending;             // In the pipe, not written out yet (the destination is full)
+} Pump;
+
+typedef struct {
+    int client, upstream;
+    int backend;                // -1 while in the lobby
+    int room;                   // Gateway room id from MSG_JOIN_ROOM, ROOM_ANY if none
+    int subscribed;             // Lobby deltas from the gateway
+    int clientEvents, upstreamEvents;   // Registered epoll interest
+    Pump up, down;              // Client to backend, backend to client
+    size_t inLen, outLen;
+    uint8_t in[GW_FRAME_MAX * 2];
+    uint8_t out[GW_OUT_MAX];    // Lobby frames not yet written to the client
+} Session;
+
+static Backend backends[GW_MAX_BACKENDS];
+static HashRing ring;                   // Live backends, for sessions no seat is found for
+static int nbRooms;                     // Lobby size: up to the last room of the last live backend
+static Session *sessionOf[GW_MAX_FD];   // By client and upstream fd
+static Backend *feedOf[GW_MAX_FD];
+static int epollFd = -1, listenFd = -1;
+static const GatewayConfig *config;
+static uint32_t deltaSeq;
+static uint32_t spreadSeq;              // Spreads sessions no seat is found for
+
+static volatile sig_atomic_t reloadRequested = 0;
+static volatile sig_atomic_t statsRequested = 0;
+static volatile sig_atomic_t stopRequested = 0;
+
+static struct {
+    int sessions, lobby, subscribers;
+    unsigned long routed, refused, pages, deltas, deltaDrops;
+    unsigned long long bytesUp, bytesDown;
+} stats;
+
+static void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int backend_live(const Backend *b) {
+    return b->name[0] && b->listed && b->up;
+}
+
+// Backend hosting a gateway room id (its slot's range), -1 if that backend is not live or has no such room
+static int owner_of(int id) {
+    if (id < 0 || id >= GW_ROOMS) return -1;
+    int b = id / ROOM_DELTA_MAX;
+    return backend_live(&backends[b]) && id % ROOM_DELTA_MAX < backends[b].total ? b : -1;
+}
+
+// A room as the lobby shows it: the backend's entry under the gateway id
+static Room_Info room_info(int id) {
+    int b = owner_of(id);
+    if (b < 0) return (Room_Info){ .id = id };
+    Room_Info info = backends[b].rooms[id % ROOM_DELTA_MAX];
+    info.id = id;
+    return info;
+}
+
+/* --- Lobby --- */
+
+static void watch(int fd, int *registered, int events) {
+    if (*registered == events) return;
+    struct epoll_event ev = { .events = events, .data.fd = fd };
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    *registered = events;
+}
+
+// Read only what the other side can take: a full pipe stops its source
+static void session_watch(Session *s) {
+    if (s->backend < 0) {
+        watch(s->client, &s->clientEvents, EPOLLIN | (s->outLen ? EPOLLOUT : 0));
+        return;
+    }
+    watch(s->client, &s->clientEvents,
+          (s->up.pending ? 0 : EPOLLIN) | (s->outLen || s->down.pending ? EPOLLOUT : 0));
+    watch(s->upstream, &s->upstreamEvents,
+          (s->down.pending || s->outLen ? 0 : EPOLLIN) | (s->up.pending ? EPOLLOUT : 0));
+}
+
+static int flush_out(Session *s) {
+    size_t off = 0;
+    while (off < s->outLen) {
+        ssize_t n = send(s->client, s->out + off, s->outLen - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        off += n;
+    }
+    memmove(s->out, s->out + off, s->outLen - off);
+    s->outLen -= off;
+    return 0;
+}
+
+// Queue a frame from the gateway itself; dropped when the client lags that far behind
+static int lobby_send(Session *s, uint8_t type, const void *payload, uint32_t len) {
+    if (s->outLen + sizeof(PacketHeader) + len > sizeof(s->out)) return -1;
+    PacketHeader header = { .type = type, .length = htonl(len) };
+    memcpy(s->out + s->outLen, &header, sizeof(header));
+    memcpy(s->out + s->outLen + sizeof(header), payload, len);
+    s->outLen += sizeof(header) + len;
+    return 0;
+}
+
+// Rooms that changed, to every client subscribed in the lobby
+static void publish(const Room_Info *rooms, int count) {
+    if (count == 0 || stats.subscribers == 0) return;
+    Payload_Room_Delta delta;
+    delta.seq = ++deltaSeq;
+    delta.count = count;
+    memcpy(delta.rooms, rooms, sizeof(Room_Info) * count);
+    uint32_t len = offsetof(Payload_Room_Delta, rooms) + sizeof(Room_Info) * count;
+
+    for (int fd = 0; fd < GW_MAX_FD; fd++) {
+        Session *s = sessionOf[fd];
+        if (!s || s->client != fd || !s->subscribed) continue;
+        if (lobby_send(s, MSG_ROOM_DELTA, &delta, len) < 0) {
+            stats.deltaDrops++;
+            continue;
+        }
+        stats.deltas++;
+        flush_out(s);           // A failure shows up as EPOLLERR on the next wait
+        session_watch(s);
+    }
+}
+
+static void lobby_list(Session *s, const Payload_Room_List *req) {
+    if (req->subscribe >= 0 && (req->subscribe != 0) != s->subscribed) {
+        s->subscribed = req->subscribe != 0;
+        stats.subscribers += s->subscribed ? 1 : -1;
+    }
+    Payload_Room_Page page;
+    memset(&page, 0, sizeof(page));
+    int first = req->first < 0 ? 0 : req->first;
+    int count = req->count < 0 ? 0 : req->count > ROOM_PAGE ? ROOM_PAGE : req->count;
+    page.total = nbRooms;
+    page.first = first;
+    for (int id = first; id < nbRooms && page.count < count; id++) page.rooms[page.count++] = room_info(id);
+    lobby_send(s, MSG_ROOM_PAGE, &page, sizeof(page));
+    stats.pages++;
+}
+
+// Fullest waiting room with a free seat, over every backend
+static int pick_waiting_room(void) {
+    int best = -1, bestPlayers = -1;
+    for (int id = 0; id < nbRooms; id++) {
+        if (owner_of(id) < 0) continue;
+        Room_Info info = room_info(id);
+        if (info.state == ROOM_WAITING && info.players < info.seats && info.players > bestPlayers) {
+            best = id;
+            bestPlayers = info.players;
+        }
+    }
+    return best;
+}
+
+/* --- Directory feeds --- */
+
+/**
+ * @brief Rebuild the ring and the lobby after a backend came, left or went down
+ *
+ * Each backend slot owns the gateway room ids [slot * ROOM_DELTA_MAX,
+ * slot * ROOM_DELTA_MAX + total): the rooms of a backend that joins are
+ * sent to the lobby, those of one that leaves are sent again without seats.
+ */
+static void ring_update(void) {
+    const char *names[GW_MAX_BACKENDS];
+    int live = 0;
+    nbRooms = 0;
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+        Backend *be = &backends[b];
+        names[b] = backend_live(be) ? be->name : NULL;
+        if (!names[b]) continue;
+        live++;
+        if (be->total > 0) nbRooms = b * ROOM_DELTA_MAX + be->total;
+    }
+    if (ring_build(&ring, names, GW_MAX_BACKENDS) < 0) {
+        fprintf(stderr, "[Gateway] Out of memory building the ring.\n");
+        live = 0;
+    }
+    if (!live) nbRooms = 0;
+
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+        Backend *be = &backends[b];
+        if (backend_live(be) == be->inLobby) continue;
+        be->inLobby = !be->inLobby;
+        Room_Info changed[ROOM_DELTA_MAX];
+        int nbChanged = 0;
+        for (int id = 0; id < be->total; id++) changed[nbChanged++] = room_info(b * ROOM_DELTA_MAX + id);
+        publish(changed, nbChanged);
+    }
+}
+
+// Entries from a backend's directory: keep them all, pass them on under their gateway ids once it is live
+static void feed_update(Backend *b, const Room_Info *rooms, int count) {
+    Room_Info owned[ROOM_DELTA_MAX];
+    int nbOwned = 0;
+    int base = (int)(b - backends) * ROOM_DELTA_MAX;
+    for (int i = 0; i < count; i++) {
+        int id = rooms[i].id;
+        if (id < 0 || id >= ROOM_DELTA_MAX) continue;
+        b->rooms[id] = rooms[i];
+        if (owner_of(base + id) >= 0) owned[nbOwned++] = room_info(base + id);
+    }
+    publish(owned, nbOwned);
+}
+
+static void on_feed_page(Sh13Client *c, const Payload_Room_Page *p, void *user) {
+    (void)c;
+    Backend *b = user;
+    b->total = p->total < 0 ? 0 : p->total > ROOM_DELTA_MAX ? ROOM_DELTA_MAX : p->total;
+    feed_update(b, p->rooms, p->count);
+    // The pages were asked in order: the last one completes the directory
+    if (!b->up && p->first + p->count >= b->total) {
+        b->up = 1;
+        printf("[Gateway] Backend %s is up (%d rooms).\n", b->name, b->total);
+        ring_update();
+    }
+}
+
+static void on_feed_delta(Sh13Client *c, const Payload_Room_Delta *p, void *user) {
+    (void)c;
+    feed_update(user, p->rooms, p->count);
+}
+
+static const Sh13Callbacks feedCallbacks = {
+    .onRoomPage = on_feed_page,
+    .onRoomDelta = on_feed_delta,
+};
+
+static void feed_open(Backend *b) {
+    b->retryNs = sh13_now_ns() + GW_RETRY_MS * 1000000ULL;
+    Sh13Client *c = sh13_client_new(&feedCallbacks, b);
+    if (!c) return;
+    if (sh13_client_connect(c, b->host, b->port) < 0 || sh13_client_fd(c) >= GW_MAX_FD) {
+        sh13_client_free(c);
+        return;
+    }
+    // The whole directory, then its deltas
+    for (int first = 0; first < ROOM_DELTA_MAX; first += ROOM_PAGE) {
+        sh13_client_room_list(c, first, ROOM_PAGE, first == 0 ? 1 : -1);
+    }
+    b->feed = c;
+    b->feedFd = sh13_client_fd(c);
+    set_nonblocking(b->feedFd);
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = b->feedFd };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, b->feedFd, &ev);
+    feedOf[b->feedFd] = b;
+}
+
+static void feed_close(Backend *b) {
+    if (!b->feed) return;
+    feedOf[b->feedFd] = NULL;       // Closed with the client, which leaves the epoll set
+    sh13_client_free(b->feed);
+    b->feed = NULL;
+    b->retryNs = sh13_now_ns() + GW_RETRY_MS * 1000000ULL;
+    if (b->up) {
+        b->up = 0;
+        ring_update();
+    }
+}
+
+static void feed_read(Backend *b) {
+    if (sh13_client_read(b->feed) < 0) {
+        printf("[Gateway] Lost backend %s, retrying every %d ms.\n", b->name, GW_RETRY_MS);
+        feed_close(b);
+    }
+}
+
+/* --- Backend list --- */
+
+// "host:port", or "unix:/path"
+static int parse_backend(Backend *b, const char *name) {
+    if (strlen(name) >= sizeof(b->name)) return -1;
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    if (strncmp(name, ENDPOINT_UNIX_PREFIX, strlen(ENDPOINT_UNIX_PREFIX)) == 0) {
+        snprintf(b->host, sizeof(b->host), "%s", name);
+        b->port = 0;
+        return 0;
+    }
+    const char *colon = strrchr(name, ':');
+    if (!colon || colon == name || (size_t)(colon - name) >= sizeof(b->host)) return -1;
+    memcpy(b->host, name, colon - name);
+    b->host[colon - name] = '\0';
+    b->port = atoi(colon + 1);
+    return b->port > 0 ? 0 : -1;
+}
+
+static void backend_free(Backend *b) {
+    feed_close(b);
+    memset(b, 0, sizeof(*b));
+}
+
+static Backend *backend_find(const char *name) {
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+        if (backends[b].name[0] && strcmp(backends[b].name, name) == 0) return &backends[b];
+    }
+    return NULL;
+}
+
+static void backend_add(const char *name) {
+    Backend *b = backend_find(name);
+    if (b) {
+        if (!b->listed) printf("[Gateway] Backend %s is listed again.\n", name);
+        b->listed = 1;
+        return;
+    }
+    for (int i = 0; i < GW_MAX_BACKENDS && !b; i++) if (!backends[i].name[0]) b = &backends[i];
+    if (!b) {
+        fprintf(stderr, "[Gateway] At most %d backends, ignored %s\n", GW_MAX_BACKENDS, name);
+        return;
+    }
+    if (parse_backend(b, name) < 0) {
+        fprintf(stderr, "[Gateway] Bad backend '%s' (HOST:PORT or unix:/path)\n", name);
+        memset(b, 0, sizeof(*b));
+        return;
+    }
+    b->listed = 1;
+    printf("[Gateway] Backend %s added.\n", name);
+    feed_open(b);
+    if (!b->feed) printf("[Gateway] Backend %s unreachable, retrying every %d ms.\n", name, GW_RETRY_MS);
+}
+
+/**
+ * @brief Bring the backends in line with --backend= and the backends file
+ *
+ * New backends join the ring once their directory is read. Removed ones
+ * leave it at once but keep their sessions until the last one ends.
+ */
+static void backends_load(void) {
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) backends[b].listed = 0;
+    for (int i = 0; i < config->nbBackends; i++) backend_add(config->backends[i]);
+
+    if (config->backendsFile) {
+        FILE *f = fopen(config->backendsFile, "r");
+        if (!f) {
+            perror("[Gateway] backends file");
+        } else {
+            char line[256];
+            while (fgets(line, sizeof(line), f)) {
+                char *p = line;
+                while (isspace((unsigned char)*p)) p++;
+                char *end = p + strlen(p);
+                while (end > p && isspace((unsigned char)end[-1])) *--end = '\0';
+                if (*p != '\0' && *p != '#') backend_add(p);
+            }
+            fclose(f);
+        }
+    }
+
+    // Out of the lobby first, then freed: a slot taken again starts with no room shown
+    ring_update();
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+        Backend *be = &backends[b];
+        if (!be->name[0] || be->listed) continue;
+        if (be->sessions == 0) {
+            printf("[Gateway] Backend %s removed.\n", be->name);
+            backend_free(be);
+        } else {
+            printf("[Gateway] Backend %s draining (%d sessions).\n", be->name, be->sessions);
+        }
+    }
+}
+
+/* --- Sessions --- */
+
+static void session_new(int fd) {
+    Session *s = calloc(1, sizeof(Session));
+    if (!s) {
+        close(fd);
+        return;
+    }
+    s->client = fd;
+    s->upstream = -1;
+    s->backend = -1;
+    s->room = ROOM_ANY;
+    s->up.pipe[0] = s->up.pipe[1] = s->down.pipe[0] = s->down.pipe[1] = -1;
+    s->clientEvents = EPOLLIN;
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    sessionOf[fd] = s;
+    stats.sessions++;
+    stats.lobby++;
+}
+
+static void session_close(Session *s) {
+    if (s->subscribed) stats.subscribers--;
+    if (s->backend < 0) {
+        stats.lobby--;
+    } else {
+        Backend *b = &backends[s->backend];
+        if (--b->sessions == 0 && !b->listed) {
+            printf("[Gateway] Backend %s drained.\n", b->name);
+            backend_free(b);
+        }
+    }
+    int fds[] = { s->client, s->upstream };
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] < 0) continue;
+        sessionOf[fds[i]] = NULL;
+        close(fds[i]);      // Also leaves the epoll set
+    }
+    int pipes[] = { s->up.pipe[0], s->up.pipe[1], s->down.pipe[0], s->down.pipe[1] };
+    for (int i = 0; i < 4; i++) if (pipes[i] >= 0) close(pipes[i]);
+    free(s);
+    stats.sessions--;
+}
+
+/**
+ * @brief Hand the session to the backend owning its room
+ *
+ * The backend is always sent MSG_JOIN_ROOM first: the chosen room under
+ * its own id, or ROOM_ANY when no seat is free anywhere (the session is
+ * then spread over the ring, and that backend seats it as soon as one of
+ * its rooms frees up). Then come the bytes the client sent from the
+ * routing frame on. Backends are on the same host or LAN: the connect is
+ * blocking.
+ */
+static int session_route(Session *s, const uint8_t *rest, size_t restLen) {
+    int room = s->room != ROOM_ANY ? s->room : pick_waiting_room();
+    int local = room % ROOM_DELTA_MAX;
+    if (room < 0) {
+        int spread = ring_lookup(&ring, ring_hash(&spreadSeq, sizeof(spreadSeq)));
+        spreadSeq++;
+        if (spread >= 0) room = spread * ROOM_DELTA_MAX;
+        local = ROOM_ANY;
+    }
+    int b = owner_of(room);
+    if (b < 0) {
+        printf("[Gateway] No backend for room %d, closing socket %d.\n", room, s->client);
+        stats.refused++;
+        return -1;
+    }
+
+    Backend *be = &backends[b];
+    int fd = connect_endpoint(be->host, be->port);
+    if (fd < 0 || fd >= GW_MAX_FD) {
+        fprintf(stderr, "[Gateway] Cannot reach backend %s: %s\n", be->name, strerror(errno));
+        if (fd >= 0) close(fd);
+        stats.refused++;
+        return -1;
+    }
+    s->upstream = fd;       // Closed with the session from now on
+    sessionOf[fd] = s;
+
+    uint8_t join[sizeof(PacketHeader) + sizeof(Payload_Join_Room)];
+    PacketHeader header = { .type = MSG_JOIN_ROOM, .length = htonl(sizeof(Payload_Join_Room)) };
+    Payload_Join_Room pkg = { .roomId = local };
+    memcpy(join, &header, sizeof(header));
+    memcpy(join + sizeof(header), &pkg, sizeof(pkg));
+    if (send_all(fd, join, sizeof(join)) < 0 || send_all(fd, rest, restLen) < 0 ||
+        pipe2(s->up.pipe, O_NONBLOCK | O_CLOEXEC) < 0 || pipe2(s->down.pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        perror("[Gateway] route");
+        stats.refused++;
+        return -1;
+    }
+    set_nonblocking(fd);
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    s->upstreamEvents = EPOLLIN;
+
+    // From here the backend answers everything, the lobby feed included
+    if (s->subscribed) {
+        s->subscribed = 0;
+        stats.subscribers--;
+    }
+    // Count the seat now: the backend's delta only comes at its next tick
+    if (local >= 0 && be->rooms[local].players < be->rooms[local].seats) be->rooms[local].players++;
+    s->backend = b;
+    s->inLen = 0;
+    stats.lobby--;
+    stats.routed++;
+    be->sessions++;
+    be->routed++;
+    return 0;
+}
+
+// Frames of a client not routed yet: lobby requests are answered here, anything else routes it
+static int lobby_read(Session *s) {
+    ssize_t n = recv(s->client, s->in + s->inLen, sizeof(s->in) - s->inLen, 0);
+    if (n == 0) return -1;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    s->inLen += n;
+
+    size_t off = 0;
+    while (s->inLen - off >= sizeof(PacketHeader)) {
+        PacketHeader header;
+        memcpy(&header, s->in + off, sizeof(header));
+        uint32_t len = ntohl(header.length);
+        if (len > GW_FRAME_MAX) return -1;
+        if (s->inLen - off < sizeof(header) + len) break;
+
+        const uint8_t *payload = s->in + off + sizeof(header);
+        if (header.type == MSG_ROOM_LIST) {
+            Payload_Room_List req;
+            if (len >= sizeof(req)) {
+                memcpy(&req, payload, sizeof(req));
+                lobby_list(s, &req);
+            }
+        } else if (header.type == MSG_JOIN_ROOM) {
+            Payload_Join_Room req;
+            if (len >= sizeof(req)) {
+                memcpy(&req, payload, sizeof(req));
+                s->room = req.roomId >= 0 && req.roomId < GW_ROOMS ? req.roomId : ROOM_ANY;
+            }
+        } else {
+            return session_route(s, s->in + off, s->inLen - off);
+        }
+        off += sizeof(header) + len;
+    }
+    memmove(s->in, s->in + off, s->inLen - off);
+    s->inLen -= off;
+    return flush_out(s);
+}
+
+static int pump_drain(Pump *p, int dst) {
+    while (p->pending > 0) {
+        ssize_t n = splice(p->pipe[0], NULL, dst, NULL, p->pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? 0 : -1;
+        }
+        p->pending -= n;
+    }
+    return 0;
+}
+
+static int pump_fill(Pump *p, int src, int dst, unsigned long long *bytes) {
+    ssize_t n = splice(src, NULL, p->pipe[1], NULL, GW_SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n == 0) return -1;
+    if (n < 0) return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    p->pending += n;
+    *bytes += n;
+    return pump_drain(p, dst);
+}
+
+static void session_event(Session *s, int fd, uint32_t events) {
+    int rc = 0;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        rc = -1;
+    } else if (fd == s->client) {
+        if (events & EPOLLOUT) rc = s->outLen ? flush_out(s) : pump_drain(&s->down, s->client);
+        if (rc == 0 && (events & EPOLLIN)) {
+            rc = s->backend < 0 ? lobby_read(s) : pump_fill(&s->up, s->client, s->upstream, &stats.bytesUp);
+        }
+    } else {
+        if (events & EPOLLOUT) rc = pump_drain(&s->up, s->upstream);
+        if (rc == 0 && (events & EPOLLIN)) rc = pump_fill(&s->down, s->upstream, s->client, &stats.bytesDown);
+    }
+    if (rc < 0) session_close(s);
+    else session_watch(s);
+}
+
+static void accept_pending(void) {
+    for (;;) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("[Gateway] accept");
+            return;
+        }
+        if (fd >= GW_MAX_FD) {
+            close(fd);
+            stats.refused++;
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        session_new(fd);
+    }
+}
+
+static int listen_tcp(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("[Gateway] socket");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = INADDR_ANY };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 128) < 0) {
+        perror("[Gateway] bind");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void on_reload_signal(int sig) {
+    (void)sig;
+    reloadRequested = 1;
+}
+
+static void on_stats_signal(int sig) {
+    (void)sig;
+    statsRequested = 1;
+}
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stopRequested = 1;
+}
+
+void gateway_stats_print(FILE *out) {
+    fprintf(out, "[Gateway] sessions=%d lobby=%d subscribers=%d routed=%lu refused=%lu pages=%lu deltas=%lu "
+                 "delta_drops=%lu bytes_up=%llu bytes_down=%llu rooms=%d\n",
+            stats.sessions, stats.lobby, stats.subscribers, stats.routed, stats.refused, stats.pages,
+            stats.deltas, stats.deltaDrops, stats.bytesUp, stats.bytesDown, nbRooms);
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+        const Backend *be = &backends[b];
+        if (!be->name[0]) continue;
+        fprintf(out, "[Gateway] backend %s: %s first_room=%d rooms=%d sessions=%d routed=%lu\n", be->name,
+                !be->listed ? "draining" : be->up ? "up" : "down", b * ROOM_DELTA_MAX, be->total,
+                be->sessions, be->routed);
+    }
+}
+
+/**
+ * @brief Serve clients until SIGINT/SIGTERM
+ *
+ * SIGHUP reads the backend list again, SIGUSR1 prints the counters.
+ */
+int gateway_run(const GatewayConfig *cfg) {
+    config = cfg;
+
+    // Two sockets and two pipes per session
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max < GW_MAX_FD ? rl.rlim_max : GW_MAX_FD;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_reload_signal;       // No SA_RESTART: epoll_wait must return EINTR
+    sigaction(SIGHUP, &sa, NULL);
+    sa.sa_handler = on_stats_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    listenFd = listen_tcp(cfg->port);
+    if (epollFd < 0 || listenFd < 0) return -1;
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = listenFd };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+
+    backends_load();
+    int configured = 0;
+    for (int b = 0; b < GW_MAX_BACKENDS; b++) configured += backends[b].name[0] != 0;
+    if (configured == 0) {
+        fprintf(stderr, "[Gateway] No backend configured.\n");
+        return -1;
+    }
+    printf("[Gateway] Listening on port %d, %d backend(s).\n", cfg->port, configured);
+
+    struct epoll_event events[256];
+    while (!stopRequested) {
+        int n = epoll_wait(epollFd, events, 256, GW_RETRY_MS);
+        if (reloadRequested) {
+            reloadRequested = 0;
+            printf("[Gateway] Reloading the backend list.\n");
+            backends_load();
+        }
+        if (statsRequested) {
+            statsRequested = 0;
+            gateway_stats_print(stdout);
+            fflush(stdout);
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) accept_pending();
+            else if (feedOf[fd]) feed_read(feedOf[fd]);
+            else if (sessionOf[fd]) session_event(sessionOf[fd], fd, events[i].events);
+        }
+
+        uint64_t now = sh13_now_ns();
+        for (int b = 0; b < GW_MAX_BACKENDS; b++) {
+            Backend *be = &backends[b];
+            if (be->name[0] && be->listed && !be->feed && now >= be->retryNs) feed_open(be);
+        }
+    }
+    printf("[Gateway] Stopping.\n");
+    return 0;
+}
@@ -2,11 +2,15 @@
 #include "../include/gui.h"
 #include "../include/client_logic.h"
 #include "../include/resources.h"
+#include "../include/rules.h"
+#include "../include/text_cache.h"
+#include "../include/perf_overlay.h"
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdatomic.h>
 
 // Window dimension constants
 #define WINDOW_WIDTH 1280    ///< Window width
@@ -52,9 +56,32 @@
 #define G_BTN_H       30   // Button height
 
 
+// Cards and icons are queued here and drawn from the atlas once per layer
+static SpriteBatch sprites;
+
+// A part of the screen that only changes with the rules, the table size or
+// the images loaded so far: rendered once into a target texture, then
+// composited each frame until its key changes
+typedef struct {
+    SDL_Texture *texture;
+    Uint32 key;         ///< Hash of what was painted into it, 0 = must repaint
+} StaticLayer;
+
+static StaticLayer chromeLayer;   ///< Object header, grid frames, button frames
+static StaticLayer roleLayer;     ///< Character table
+static int layersUnsupported = 0; ///< Renderer without target textures: draw directly
+
 static int showEndDialog = 0;     ///< Flag for showing end dialog
 static PopupState popupState = POPUP_NONE;  ///< Current popup state
 
+// Redraw on demand: the window is only repainted after something changed
+#define GUI_IDLE_TIMEOUT_MS 1000   ///< Longest sleep between two event checks
+static Uint32 redrawEventType = (Uint32)-1;   ///< User event posted by other threads
+static atomic_int redrawPosted;               ///< One pending redraw event at most
+
+// Client state being drawn, refreshed from the network thread's snapshot
+static ClientSnapshot view;
+
 // Tracking Mouse State
 static int mouseX = 0, mouseY = 0;
 static int hoverO = 0, hoverS = 0, hoverG = 0;
@@ -73,6 +100,9 @@ static int selectedGuessCard = -1;
 /**
  * @brief Render text at specified position
  * 
+ * Labels come from the text cache, so an unchanged string costs a single
+ * textured draw; only strings too long to cache are rasterized each time.
+ *
  * @param renderer SDL renderer
  * @param font Font object
  * @param text Text to render
@@ -83,6 +113,15 @@ static int selectedGuessCard = -1;
 void render_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y, SDL_Color color) {
     if (!text || strlen(text) == 0 || !font || !renderer) return;
 
+    int w, h;
+    SDL_Texture *cached = text_cache_get(renderer, font, text, color, &w, &h);
+    if (cached) {
+        SDL_Rect rect = {x, y, w, h};
+        SDL_RenderCopy(renderer, cached, NULL, &rect);
+        perf_count_draws(1);
+        return;
+    }
+
     SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, color);
     if (!surf) return;
     
@@ -91,6 +130,7 @@ void render_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x
         SDL_Rect rect = {x, y, surf->w, surf->h};
         SDL_RenderCopy(renderer, tex, NULL, &rect);
         SDL_DestroyTexture(tex);
+        perf_count_draws(1);
     }
     SDL_FreeSurface(surf);
 }
@@ -109,25 +149,188 @@ void render_icon(SDL_Renderer *renderer, SDL_Texture *tex, int x, int y, int siz
     SDL_Rect dst = {x, y, size, size};
     SDL_RenderCopy(renderer, tex, NULL, &dst);
 }
+
+/**
+ * @brief Copy the latest client snapshot if its version moved
+ *
+ * @return 1 if the view changed
+ */
+static int refresh_view(void) {
+    if (client_snapshot_version() == view.version) return 0;
+    client_snapshot(&view);
+    return 1;
+}
+
+static const char *object_name(int obj) {
+    if (obj >= 0 && obj < view.rules.nbObjects) return view.rules.objectNames[obj];
+    return "?";
+}
+
+/**
+ * @brief Atlas region of a card, NULL when the rule set's card has no image
+ *
+ * The images only match cards that carry their classic name at the same index.
+ */
+static const SDL_Rect *card_region(int card) {
+    const RuleSet *classic = rules_builtin("classic");
+    if (card < 0 || card >= ATLAS_CARDS || card >= view.rules.nbCards) return NULL;
+    if (strcmp(view.rules.cardNames[card], classic->cardNames[card]) != 0) return NULL;
+    return atlas_card(card);
+}
+
+/**
+ * @brief Atlas region of an object icon, NULL for objects the classic set lacks
+ */
+static const SDL_Rect *object_region(int obj) {
+    const RuleSet *classic = rules_builtin("classic");
+    if (obj < 0 || obj >= ATLAS_ICONS || obj >= view.rules.nbObjects) return NULL;
+    if (strcmp(view.rules.objectNames[obj], classic->objectNames[obj]) != 0) return NULL;
+    return atlas_icon(obj);
+}
+
+/**
+ * @brief Draw a card: its image, or a framed name for custom cards
+ *
+ * Images are only queued; the caller flushes the sprite batch.
+ */
+static void render_card(SDL_Renderer *renderer, TTF_Font *font, int card, SDL_Rect dst) {
+    const SDL_Rect *src = card_region(card);
+    if (src) {
+        sprite_batch_add(&sprites, renderer, src, &dst);
+        return;
+    }
+    sprite_batch_flush(&sprites, renderer); // Keep the overlap order of the hand
+    SDL_Color black = {0, 0, 0};
+    SDL_SetRenderDrawColor(renderer, 235, 225, 200, 255);
+    SDL_RenderFillRect(renderer, &dst);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &dst);
+    if (font && card >= 0 && card < view.rules.nbCards) {
+        render_text(renderer, font, view.rules.cardNames[card], dst.x + 8, dst.y + 8, black);
+    }
+}
+
+/**
+ * @brief Draw an object: its icon, or its initial for custom objects
+ *
+ * Icons are only queued; the caller flushes the sprite batch.
+ */
+static void render_object(SDL_Renderer *renderer, TTF_Font *font, int obj, int x, int y, int size) {
+    const SDL_Rect *src = object_region(obj);
+    if (src) {
+        SDL_Rect dst = {x, y, size, size};
+        sprite_batch_add(&sprites, renderer, src, &dst);
+        return;
+    }
+    SDL_Color black = {0, 0, 0};
+    char initial[2] = { object_name(obj)[0], '\0' };
+    SDL_Rect box = {x, y, size, size};
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &box);
+    if (font) render_text(renderer, font, initial, x + size / 3, y + size / 8, black);
+}
  
+static Uint32 hash_bytes(Uint32 h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+/**
+ * @brief Key of everything the static layers depend on
+ *
+ * Images still decoding are part of it: each upload repaints the layers
+ * once, replacing a text fallback with its icon.
+ */
+static Uint32 layer_key(int withPlayers) {
+    Uint32 h = hash_bytes(2166136261u, &view.rules, sizeof(view.rules));
+    int pending = assets_pending();
+    h = hash_bytes(h, &pending, sizeof(pending));
+    if (withPlayers) h = hash_bytes(h, &view.playerCount, sizeof(view.playerCount));
+    return h | 1;
+}
+
+static void layers_invalidate(void) {
+    chromeLayer.key = 0;
+    roleLayer.key = 0;
+}
+
+static void layers_destroy(void) {
+    StaticLayer *layers[] = { &chromeLayer, &roleLayer };
+    for (int i = 0; i < 2; i++) {
+        if (layers[i]->texture) SDL_DestroyTexture(layers[i]->texture);
+        layers[i]->texture = NULL;
+        layers[i]->key = 0;
+    }
+}
+
+/**
+ * @brief Composite a static layer, repainting it first if its key changed
+ *
+ * The layer holds premultiplied alpha (painted over transparent black), so
+ * it is composited with a matching blend mode.
+ */
+static void draw_static_layer(SDL_Renderer *renderer, TTF_Font *font, StaticLayer *layer, Uint32 key,
+                              void (*paint)(SDL_Renderer*, TTF_Font*)) {
+    if (!layer->texture && !layersUnsupported) {
+        if (SDL_RenderTargetSupported(renderer)) {
+            layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                               WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+        if (!layer->texture) {
+            fprintf(stderr, "[GUI] No target textures, static layers drawn every frame\n");
+            layersUnsupported = 1;
+        } else {
+            SDL_SetTextureBlendMode(layer->texture, SDL_ComposeCustomBlendMode(
+                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD));
+            layer->key = 0;
+        }
+    }
+    if (!layer->texture) {
+        paint(renderer, font);
+        return;
+    }
+
+    if (layer->key != key) {
+        SDL_SetRenderTarget(renderer, layer->texture);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        paint(renderer, font);
+        SDL_SetRenderTarget(renderer, NULL);
+        layer->key = key;
+    }
+    SDL_RenderCopy(renderer, layer->texture, NULL, NULL);
+    perf_count_draws(1);
+}
+
+// Textures the GUI keeps alive: cached strings, the atlas, the static layers
+static int live_textures(void) {
+    TextCacheStats stats;
+    text_cache_stats(&stats);
+    return stats.entries + (atlas != NULL) + (chromeLayer.texture != NULL) + (roleLayer.texture != NULL);
+}
+
 /**
  * @brief Render player's cards
  * 
  * @param renderer SDL renderer
- * @param cards Array of card textures
  * @param mycards Array of player's card indices
  * @param cardCount Number of cards
  */
-void render_cards(SDL_Renderer* renderer, SDL_Texture* cards[], int* mycards, int cardCount) {
-    if (!mycards || !cards || !renderer) return;
-    if (!mycards) return;
+void render_cards(SDL_Renderer* renderer, const int* mycards, int cardCount) {
+    if (!mycards || !renderer) return;
+    // Larger hands overlap so they still fit the window
+    int step = 230;
+    if (cardCount > 3) step = (WINDOW_HEIGHT - 100 - CARD_HEIGHT) / (cardCount - 1);
     for (int i = 0; i < cardCount; ++i) {
         int idx = mycards[i];
-        if (idx >= 0 && idx < 13 && cards[idx]) {
-            SDL_Rect dst = {940, 50 + i * 230, CARD_WIDTH, CARD_HEIGHT};
-            SDL_RenderCopy(renderer, cards[idx], NULL, &dst);
+        if (idx >= 0 && idx < view.rules.nbCards) {
+            SDL_Rect dst = {940, 50 + i * step, CARD_WIDTH, CARD_HEIGHT};
+            render_card(renderer, NULL, idx, dst);
         }
     }
+    sprite_batch_flush(&sprites, renderer);
 }
  
 /**
@@ -148,7 +351,7 @@ void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font) {
 
     // Show object selection (shared by O and S)
     render_text(renderer, font, "Objets:", 200, 120, black);
-    for (int i = 0; i < 8; ++i) {
+    for (int i = 0; i < view.rules.nbObjects; ++i) {
         SDL_Rect box = {200, 160 + i * 25, 200, 22};
         if (i == selectedObjectId) {
             SDL_SetRenderDrawColor(renderer, 0, 200, 0, 100);
@@ -158,15 +361,15 @@ void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font) {
         SDL_RenderDrawRect(renderer, &box);
 
         char label[64]; // Increased buffer size safety
-        snprintf(label, sizeof(label), "%d: %s", i + 1, nameobjets[i]);
+        snprintf(label, sizeof(label), "%d: %s", i + 1, object_name(i));
         render_text(renderer, font, label, 205, 155 + i * 25, black);
     }
 
     // Only show player selection for S action
     if (popupState == POPUP_S_SELECT_OBJ || popupState == POPUP_S_SELECT_PLAYER) {
         render_text(renderer, font, "Joueurs:", 420, 120, black);
-        int pc = getPlayerCount();
-        if (pc > 4) pc = 4; // Safety clamp
+        int pc = view.playerCount;
+        if (pc > view.rules.nbPlayers) pc = view.rules.nbPlayers; // Safety clamp
 
         for (int i = 0; i < pc; ++i) {
             SDL_Rect box = {420, 160 + i * 25, 180, 22};
@@ -178,7 +381,7 @@ void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font) {
             SDL_RenderDrawRect(renderer, &box);
 
             char label[64]; // Increased buffer size safety
-            snprintf(label, sizeof(label), "%d: %s", i + 1, getPlayerName(i));
+            snprintf(label, sizeof(label), "%d: %s", i + 1, view.playerNames[i]);
             render_text(renderer, font, label, 425, 155 + i * 25, black);
         }
     }
@@ -214,7 +417,7 @@ void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font) {
     SDL_Color black = {0, 0, 0};
     render_text(renderer, font, "Cliquez sur la carte que vous soupçonnez être le coupable :", 200, 130, black);
 
-    for (int i = 0; i < 13; ++i) {
+    for (int i = 0; i < view.rules.nbCards; ++i) {
         int row = i / COLUMNS_PER_ROW;
         int col = i % COLUMNS_PER_ROW;
         int x = CARD_START_X + col * (BG_CARD_WIDTH + COLUMN_SPACING);
@@ -225,8 +428,16 @@ void draw_selection_popup(SDL_Renderer* renderer, TTF_Font* font) {
             SDL_SetRenderDrawColor(renderer, 255, 255, 0, 150);
             SDL_RenderFillRect(renderer, &cardRect);
         }
-        SDL_RenderCopy(renderer, cards[i], NULL, &cardRect);
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        render_card(renderer, font, i, cardRect);
+    }
+    sprite_batch_flush(&sprites, renderer);
+
+    // Frames go over the card images
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    for (int i = 0; i < view.rules.nbCards; ++i) {
+        SDL_Rect cardRect = {CARD_START_X + (i % COLUMNS_PER_ROW) * (BG_CARD_WIDTH + COLUMN_SPACING),
+                             CARD_START_Y + (i / COLUMNS_PER_ROW) * (BG_CARD_HEIGHT + ROW_SPACING),
+                             BG_CARD_WIDTH, BG_CARD_HEIGHT};
         SDL_RenderDrawRect(renderer, &cardRect);
     }
 
@@ -286,6 +497,20 @@ void show_end_popup(SDL_Renderer* renderer, TTF_Font* font, const char* result)
 void setShowEndDialog(int value) {
      showEndDialog = value;
  }
+
+/**
+ * @brief Ask the GUI thread to repaint (callable from any thread)
+ *
+ * Bursts collapse into a single queued event until the GUI has seen it.
+ */
+void gui_request_redraw(void) {
+    if (redrawEventType == (Uint32)-1) return;
+    if (atomic_exchange(&redrawPosted, 1)) return;
+    SDL_Event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = redrawEventType;
+    if (SDL_PushEvent(&ev) < 0) atomic_store(&redrawPosted, 0);
+}
  
 /**
  * @brief Send action request to server
@@ -320,6 +545,7 @@ void send_action_request(char type, int objet, int cible) {
  */
 void run_gui() {
     // --- 1. Initialization Phase ---
+    Uint64 startupCounter = SDL_GetPerformanceCounter(); // Cold-start instrumentation
 
     // Initialize SDL Video subsystem
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -342,6 +568,9 @@ void run_gui() {
         return;
     }
 
+    // Decode icons and cards in the background while the window comes up
+    assets_start(gui_request_redraw);
+
     // Create the main window
     SDL_Window *window = SDL_CreateWindow("Sherlock 13 - Client", 
                                           SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -350,6 +579,7 @@ void run_gui() {
     if (!window) {
         fprintf(stderr, "[GUI Error] Window could not be created! SDL_Error: %s\n", SDL_GetError());
         // Cleanup and exit
+        unload_textures();
         TTF_Quit(); IMG_Quit(); SDL_Quit();
         return;
     }
@@ -358,6 +588,7 @@ void run_gui() {
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) {
         fprintf(stderr, "[GUI Error] Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
+        unload_textures();
         SDL_DestroyWindow(window);
         TTF_Quit(); IMG_Quit(); SDL_Quit();
         return;
@@ -368,6 +599,7 @@ void run_gui() {
     if (!font) {
         fprintf(stderr, "[GUI Error] Failed to load font! TTF_Error: %s\n", TTF_GetError());
         // Handle missing resource gracefully
+        unload_textures();
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         TTF_Quit(); IMG_Quit(); SDL_Quit();
@@ -382,8 +614,8 @@ void run_gui() {
     SDL_Color blue  = {0, 0, 255, 255};
     SDL_Color red   = {255, 0, 0, 255};
 
-    // Load texture resources (Icons and Cards)
-    load_all_textures(renderer);
+    double windowMs = (SDL_GetPerformanceCounter() - startupCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+    double firstFrameMs = 0;
 
     // --- 2. UI Element Definitions ---
 
@@ -400,17 +632,50 @@ void run_gui() {
     // Enable Text Input for the login screen
     SDL_StartTextInput();
 
+    // Network updates wake the loop through this event
+    redrawEventType = SDL_RegisterEvents(1);
+
+    // F3 overlay and SH13_PERF_CSV log
+    perf_init();
+    Uint32 lastFrameTicks = 0, lastPingTicks = 0;
+
     // Main loop control flag
     int running = 1;
+    int needsRedraw = 1; // Paint the first frame
     SDL_Event e;
     static int connectClicked = 0; // Prevent repeated clicks on the flag
 
     // --- 3. Main Event Loop ---
     while (running) {
         
-        // Handle all events in the queue
-        while (SDL_PollEvent(&e)) {
+        // Sleep until an event arrives unless a frame is already due, then drain the queue
+        int idleMs = perf_active() ? PERF_REFRESH_MS : GUI_IDLE_TIMEOUT_MS;
+        int haveEvent = needsRedraw ? SDL_PollEvent(&e) : SDL_WaitEventTimeout(&e, idleMs);
+        perf_frame_begin();
+
+        // Pick up the network state without locking; unchanged versions cost nothing
+        needsRedraw |= refresh_view();
+
+        for (; haveEvent; haveEvent = SDL_PollEvent(&e)) {
+            if (e.type == redrawEventType) {
+                atomic_store(&redrawPosted, 0);
+                continue;
+            }
+            // Anything but a plain mouse move changes what is on screen
+            if (e.type != SDL_MOUSEMOTION) needsRedraw = 1;
+
+            // Target textures may lose their content on a resize or a targets reset
+            if (e.type == SDL_RENDER_TARGETS_RESET ||
+                (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+                layers_invalidate();
+            }
             
+            // F3 shows or hides the performance overlay, on any screen
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                perf_overlay_toggle();
+                continue;
+            }
+
             // Global Quit Event (Clicking "X" on window)
             if (e.type == SDL_QUIT) {
                 running = 0;
@@ -419,7 +684,7 @@ void run_gui() {
             // ---------------------------------------------------------
             // SCENARIO A: User is NOT connected (Login Screen)
             // ---------------------------------------------------------
-            else if (!getIsConnected()) {
+            else if (!view.connected) {
                 
                 // Handle text input (Safe buffering)
                 if (e.type == SDL_TEXTINPUT) {
@@ -482,7 +747,7 @@ void run_gui() {
                 }
 
                 // Only process game logic clicks if the game has actively started
-                if (getIsGameStarted()) {
+                if (view.gameState == GAME_STARTED) {
                     
                     if (e.type == SDL_MOUSEBUTTONDOWN) {
                         int x = e.button.x;
@@ -494,7 +759,7 @@ void run_gui() {
 
                         // 1. Handle Main Game Board Buttons (O/S/G)
                         // Safety Check: Only allow actions if it is this client's turn AND no popup is open
-                        if (isTurn() && popupState == POPUP_NONE) {
+                        if (view.isMyTurn && popupState == POPUP_NONE) {
                             
                             // Check Action O (Observe)
                             if (x >= BUTTON_O_X && x <= BUTTON_O_X + BUTTON_WIDTH &&
@@ -520,7 +785,7 @@ void run_gui() {
                             if (popupState == POPUP_O || popupState == POPUP_S_SELECT_OBJ || popupState == POPUP_S_SELECT_PLAYER) {
                                 
                                 // Detect Object Selection (Icons list)
-                                for (int i = 0; i < 8; ++i) {
+                                for (int i = 0; i < view.rules.nbObjects; ++i) {
                                     SDL_Rect objBox = {200, 160 + i * 25, 200, 22};
                                     if (x >= objBox.x && x <= objBox.x + objBox.w &&
                                         y >= objBox.y && y <= objBox.y + objBox.h) {
@@ -529,7 +794,7 @@ void run_gui() {
                                 }
 
                                 // Detect Player Selection (Only for S action)
-                                int pc = getPlayerCount();
+                                int pc = view.playerCount;
                                 for (int i = 0; i < pc; ++i) {
                                     SDL_Rect playerBox = {420, 160 + i * 25, 180, 22};
                                     if (x >= playerBox.x && x <= playerBox.x + playerBox.w &&
@@ -544,7 +809,7 @@ void run_gui() {
                                     
                                     // Validation: Ensure required selections are made before sending
                                     if (popupState == POPUP_O) {
-                                        if (selectedObjectId >= 0 && selectedObjectId < 8) {
+                                        if (selectedObjectId >= 0 && selectedObjectId < view.rules.nbObjects) {
                                             send_action_request('O', selectedObjectId, 0);
                                             popupState = POPUP_NONE; // Close popup
                                         }
@@ -573,7 +838,7 @@ void run_gui() {
                             // --- Handling Selection Logic for G (Guessing) ---
                             else if (popupState == POPUP_G) {
                                 // Detect Card Selection
-                                for (int i = 0; i < 13; ++i) {
+                                for (int i = 0; i < view.rules.nbCards; ++i) {
                                     // Calculate grid position (must match draw_guess_popup logic)
                                     int row = i / COLUMNS_PER_ROW;
                                     int col = i % COLUMNS_PER_ROW;
@@ -590,7 +855,7 @@ void run_gui() {
                                 if (x >= okBtn.x && x <= okBtn.x + okBtn.w &&
                                     y >= okBtn.y && y <= okBtn.y + okBtn.h) {
                                     // Validation: Must have selected a card
-                                    if (selectedGuessCard >= 0 && selectedGuessCard < 13) {
+                                    if (selectedGuessCard >= 0 && selectedGuessCard < view.rules.nbCards) {
                                         send_action_request('G', selectedGuessCard, 0);
                                         popupState = POPUP_NONE;
                                     }
@@ -607,7 +872,7 @@ void run_gui() {
                         } // End of Popup handling
 
                         // 3. Handle Game Over "Quit" Button
-                        if (getIsGameEnded()) {
+                        if (view.gameState == GAME_ENDED) {
                              // Coordinates for the quit button inside show_end_popup
                              if (x >= 300 && x <= 400 && y >= 300 && y <= 330) {
                                  running = 0; // Exit Loop
@@ -617,6 +882,7 @@ void run_gui() {
 
                     // Mouse Motion Handling (Hover Effects)
                     if (e.type == SDL_MOUSEMOTION) {
+                        int hoverBefore = hoverO | (hoverS << 1) | (hoverG << 2);
                         mouseX = e.motion.x;
                         mouseY = e.motion.y;
                         
@@ -632,11 +898,34 @@ void run_gui() {
                             // Reset hover if popup is open
                             hoverO = 0; hoverS = 0; hoverG = 0;
                         }
+                        // Only a hover change needs a new frame
+                        if ((hoverO | (hoverS << 1) | (hoverG << 2)) != hoverBefore) needsRedraw = 1;
                     }
                 }
             }
         } // --- End of Event Polling ---
 
+        // A publish may have slipped in while its wake-up event was being consumed
+        needsRedraw |= refresh_view();
+
+        perf_phase_end(PERF_EVENTS);
+
+        // Images decoded since the last frame go into the atlas and show up now
+        if (assets_upload(renderer) > 0) needsRedraw = 1;
+
+        // While measuring: probe the round trip, keep the overlay's clock moving
+        Uint32 nowTicks = SDL_GetTicks();
+        if (perf_active() && view.connected && nowTicks - lastPingTicks >= PERF_PING_MS) {
+            sendPing();
+            lastPingTicks = nowTicks;
+        }
+        if (perf_overlay_visible() && nowTicks - lastFrameTicks >= PERF_REFRESH_MS) needsRedraw = 1;
+        perf_phase_end(PERF_UPDATE);
+
+        // Nothing changed: keep the current frame and go back to sleep
+        if (!needsRedraw) continue;
+        needsRedraw = 0;
+
         // --- 4. Rendering Phase ---
 
         // Clear the screen with white background
@@ -644,7 +933,7 @@ void run_gui() {
         SDL_RenderClear(renderer);
 
         // --- RENDER STATE 1: GAME IN PROGRESS ---
-        if (getIsGameStarted()) {
+        if (view.gameState == GAME_STARTED) {
             
             // Draw the main board (Players, Objects, Hand)
             draw_game_board(renderer, font);
@@ -660,31 +949,31 @@ void run_gui() {
             }
 
             // Draw Game Over Dialog if applicable
-            if (getIsGameEnded()) {
-                show_end_popup(renderer, font, getLastResult());
+            if (view.gameState == GAME_ENDED) {
+                show_end_popup(renderer, font, view.lastResult);
             }
         } 
         
         // --- RENDER STATE 2: CONNECTED BUT WAITING (LOBBY) ---
-        else if (getIsConnected()) {
+        else if (view.connected) {
             // Draw Lobby Title
             render_text(renderer, font, "Sherlock 13 - Lobby", 520, 100, black);
             render_text(renderer, font, "Connected to Server!", 530, 150, blue);
             
             // Draw Player Count
             char countMsg[64];
-            int currentCount = getPlayerCount();
-            snprintf(countMsg, sizeof(countMsg), "Players Joined: %d / 4", currentCount);
+            int currentCount = view.playerCount;
+            snprintf(countMsg, sizeof(countMsg), "Players Joined: %d / %d", currentCount, view.rules.nbPlayers);
             render_text(renderer, font, countMsg, 540, 200, black);
 
             // Draw Player List (Dynamic)
             int startY = 260;
             for (int i = 0; i < currentCount; i++) {
                 char playerRow[128];
-                const char* pname = getPlayerName(i);
+                const char* pname = view.playerNames[i];
                 
                 // Highlight myself
-                if (i == getMyClientId()) {
+                if (i == view.myClientId) {
                     snprintf(playerRow, sizeof(playerRow), "Player %d: %s (YOU)", i, pname);
                     render_text(renderer, font, playerRow, 500, startY + (i * 40), blue);
                 } else {
@@ -694,7 +983,7 @@ void run_gui() {
             }
 
             // Draw Waiting Animation Text
-            if (currentCount < 4) {
+            if (currentCount < view.rules.nbPlayers) {
                  render_text(renderer, font, "Waiting for more players...", 510, 500, gray);
             } else {
                  render_text(renderer, font, "Launching Game...", 550, 500, red);
@@ -728,15 +1017,30 @@ void run_gui() {
             render_text(renderer, font, serverInfo, 20, WINDOW_HEIGHT - 30, gray);
         }
 
-        // Swap buffers (Display frame)
+        perf_overlay_draw(renderer, font);
+        perf_phase_end(PERF_RENDER);
+
+        // Swap buffers (Display frame, paced by vsync)
         SDL_RenderPresent(renderer);
-        
-        // Small delay to reduce CPU usage
-        SDL_Delay(16); 
+        perf_phase_end(PERF_PRESENT);
+        lastFrameTicks = SDL_GetTicks();
+        PerfFrameInfo frameInfo = { .rttUs = view.rttUs, .lastMessageNs = view.lastMessageNs,
+                                    .textures = live_textures() };
+        perf_frame_end(&frameInfo);
+
+        if (firstFrameMs == 0) {
+            firstFrameMs = (SDL_GetPerformanceCounter() - startupCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+            printf("[Client] Startup: window+font %.1f ms, first interactive frame %.1f ms (%d images still decoding)\n",
+                   windowMs, firstFrameMs, assets_pending());
+        }
     }
 
     // --- 5. Cleanup Phase ---
+    redrawEventType = (Uint32)-1;
     SDL_StopTextInput();
+    text_cache_clear(); // Cached textures reference the font and the renderer
+    layers_destroy();
+    perf_shutdown();
     if (font) TTF_CloseFont(font);
     
     // Unload textures (Helper function)
@@ -750,9 +1054,59 @@ void run_gui() {
     SDL_Quit();
 }
  
+/**
+ * @brief Paint the board parts that only change with the rules or table size
+ *
+ * Object header icons, the player grid frames and the action button frames
+ * and labels. Drawn into the chrome layer.
+ */
+static void paint_board_chrome(SDL_Renderer* renderer, TTF_Font* font) {
+    SDL_Color black = {0, 0, 0};
+    int marginLeft = 100, marginTop = 70;
+    int cellSize = 35;
+    int playerCount = view.playerCount;
+    if (playerCount > view.rules.nbPlayers) playerCount = view.rules.nbPlayers; // Safety Clamp
+
+    // Top object icons
+    for (int i = 0; i < view.rules.nbObjects; ++i) {
+        render_object(renderer, font, i, marginLeft + i * 60, marginTop, 32);
+    }
+    sprite_batch_flush(&sprites, renderer);
+
+    // Player object matrix frames
+    int startY = marginTop + 70;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    for (int p = 0; p < playerCount; ++p) {
+        for (int o = 0; o < view.rules.nbObjects; ++o) {
+            SDL_Rect rect = {marginLeft + o * 60, startY + p * 40, cellSize, cellSize};
+            SDL_RenderDrawRect(renderer, &rect);
+        }
+    }
+
+    // OSG button frames and labels, filled underneath by render_osg_buttons
+    const char *labels[3] = {"Observe (O)", "Speculate (S)", "Guess (G)"};
+    SDL_Rect buttons[3] = {
+        {BUTTON_O_X, BUTTON_O_Y, BUTTON_WIDTH, BUTTON_HEIGHT},
+        {BUTTON_S_X, BUTTON_S_Y, BUTTON_WIDTH, BUTTON_HEIGHT},
+        {BUTTON_G_X, BUTTON_G_Y, BUTTON_WIDTH, BUTTON_HEIGHT}
+    };
+    int labelX[3] = {13, 9, 22};
+    for (int i = 0; i < 3; ++i) {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderDrawRect(renderer, &buttons[i]);
+        render_text(renderer, font, labels[i], buttons[i].x + labelX[i], buttons[i].y + 10, black);
+    }
+
+    // Show logo at bottom
+    render_text(renderer, font, "SHERLOCK 13", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT - 30, black);
+}
+
 /**
  * @brief Draw main game board
  * 
+ * The static chrome comes from its layer; only counts, names, cell values,
+ * cards and status lines are drawn each frame.
+ *
  * @param renderer SDL renderer
  * @param font Font object
  */
@@ -763,22 +1117,20 @@ void draw_game_board(SDL_Renderer* renderer, TTF_Font* font) {
 
     // Layout parameters
     int marginLeft = 100, marginTop = 70;
-    int cellSize = 35;
-    int playerCount = getPlayerCount();
-    if (playerCount > 4) playerCount = 4; // Safety Clamp
+    int playerCount = view.playerCount;
+    if (playerCount > view.rules.nbPlayers) playerCount = view.rules.nbPlayers; // Safety Clamp
+
+    int currentPlayer = (view.isMyTurn ? view.myClientId : -1);
 
-    int currentPlayer = getCurrentPlayer();
+    // Button fills go under the labels of the chrome layer
+    render_osg_buttons(renderer, font);
+    draw_static_layer(renderer, font, &chromeLayer, layer_key(1), paint_board_chrome);
 
-    // Top object icons and counts
-    for (int i = 0; i < 8; ++i) {
-        render_icon(renderer, icons[i], marginLeft + i * 60, marginTop, 32);
+    // Object counts under the header icons
+    for (int i = 0; i < view.rules.nbObjects; ++i) {
         char countStr[16]; // Increased from 4 to 16 to prevent overflow
-        // Safety check for pointer
-        int* counts = getObjectCounts();
-        if (counts) {
-            snprintf(countStr, sizeof(countStr), "%d", counts[i]);
-            render_text(renderer, font, countStr, marginLeft + i * 60 + 10, marginTop + 35, black);
-        }
+        snprintf(countStr, sizeof(countStr), "%d", view.objectCounts[i]);
+        render_text(renderer, font, countStr, marginLeft + i * 60 + 10, marginTop + 35, black);
     }
 
     // Show current player name in top-left corner
@@ -792,122 +1144,98 @@ void draw_game_board(SDL_Renderer* renderer, TTF_Font* font) {
     for (int p = 0; p < playerCount; ++p) {
         // Set color based on player state
         SDL_Color color = black;
-        if (!isPlayerAlive(p)) color = gray;
+        if (!view.playerAlive[p]) color = gray;
         else if (p == currentPlayer) color = red;
 
         // Draw player name
-        render_text(renderer, font, getPlayerName(p), marginLeft - 80, startY + p * 40 + 5, color);
+        render_text(renderer, font, view.playerNames[p], marginLeft - 80, startY + p * 40 + 5, color);
 
-        // Draw player object matrix
-        for (int o = 0; o < 8; ++o) {
-            SDL_Rect rect = {marginLeft + o * 60, startY + p * 40, cellSize, cellSize};
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            SDL_RenderDrawRect(renderer, &rect);
-
-            // Show object value
+        // Show object values inside the frames of the chrome layer
+        for (int o = 0; o < view.rules.nbObjects; ++o) {
             char val[16]; // Increased buffer size for safety
-            snprintf(val, sizeof(val), "%d", getTableValue(p, o));
-            render_text(renderer, font, val, rect.x + 12, rect.y + 8, black);
+            snprintf(val, sizeof(val), "%d", view.objectTable[p][o]);
+            render_text(renderer, font, val, marginLeft + o * 60 + 12, startY + p * 40 + 8, black);
         }
     }
 
     // Show player's cards on the right
-    render_cards(renderer, cards, getMyCards(), 3);
- 
-    // OSG action buttons
-    render_osg_buttons(renderer, font);
+    render_cards(renderer, view.myCards, view.myCardCount);
  
     // Bottom display
     char currentUserid[128];    // Safe buffer
-    snprintf(currentUserid, sizeof(currentUserid), "Current ID: %s", getLastResult());
+    snprintf(currentUserid, sizeof(currentUserid), "Current ID: %s", view.lastResult);
     render_text(renderer, font, currentUserid, WINDOW_WIDTH / 2 - 200, WINDOW_HEIGHT - 60, red);
     // Show current player name at bottom
-    if (getIsGameStarted()) {
+    if (view.gameState == GAME_STARTED) {
         SDL_Color turnColor = {255, 0, 0}; // Highlight current player in red
         int currentPlayerId = -1;
-        currentPlayerId = getCurrentTurnPlayer();
+        currentPlayerId = view.currentTurnPlayer;
 
         // Show turn information with player name
         char turnText[128];
-        if (currentPlayerId >= 0) {
-            snprintf(turnText, sizeof(turnText), "Current Player: %s", getPlayerName(currentPlayerId));
+        if (currentPlayerId >= 0 && currentPlayerId < MAX_PLAYERS) {
+            snprintf(turnText, sizeof(turnText), "Current Player: %s", view.playerNames[currentPlayerId]);
         } else {
             strcpy(turnText, "Waiting for game start...");
         }
         render_text(renderer, font, turnText, WINDOW_WIDTH / 2 - 200, WINDOW_HEIGHT - 90, turnColor);
     }
-    // Show logo at bottom
-    render_text(renderer, font, "SHERLOCK 13", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT - 30, black);
 }
  
 /**
- * @brief Draw character information table
- * 
- * @param renderer SDL renderer
- * @param font Font object
+ * @brief Paint the character table (names and the objects of each card)
  */
-void draw_role_table(SDL_Renderer* renderer, TTF_Font* font) {
+static void paint_role_table(SDL_Renderer* renderer, TTF_Font* font) {
     SDL_Color black = {0, 0, 0};
      
-    // Character name array
-    const char* roleNames[13] = {
-        "Sebastian Moran", "Irene Adler", "Inspector Lestrade", "Inspector Gregson",
-        "Inspector Baynes", "Inspector Bradstreet", "Inspector Hopkins",
-        "Sherlock Holmes", "John Watson", "Mycroft Holmes", "Mrs. Hudson",
-        "Mary Morstan", "James Moriarty"
-    };
-     
-    // Character object matrix
-    int roleObjects[13][8] = {
-        {0,0,0,1,0,0,0,1}, {1,0,0,0,1,0,0,0}, {0,1,0,0,1,0,1,0},
-        {0,1,1,0,0,0,1,0}, {0,0,1,1,0,0,0,1}, {1,0,0,0,0,1,1,0},
-        {1,1,0,0,0,1,0,0}, {0,0,1,0,1,0,1,0}, {1,1,0,0,0,0,1,0},
-        {0,0,0,0,1,1,0,1}, {1,0,1,0,0,0,0,1}, {0,1,1,0,0,1,0,0},
-        {0,0,0,1,1,0,1,0}
-    };
+    // Characters and their objects come from the active rule set
+    int nbCards = view.rules.nbCards;
+    int perColumn = (nbCards + 1) / 2;
+    int rowHeight = perColumn > 7 ? 245 / perColumn : 35;
  
     // Draw character table
     int startX = 20, startY = 400;
-    for (int i = 0; i < 13; ++i) {
+    for (int i = 0; i < nbCards; ++i) {
+        int second = i >= perColumn;
+        int rowY = startY + (i % perColumn) * rowHeight;
         // Draw character name (display in two columns)
-        render_text(renderer, font, roleNames[i], startX + ((i < 7) ? 0 : 450), startY + (i % 7) * 35, black);
+        render_text(renderer, font, view.rules.cardNames[i], startX + (second ? 450 : 0), rowY, black);
          
         // Draw objects owned by character
-        for (int j = 0; j < 8; ++j) {
-            if (roleObjects[i][j]) {
-                int x = startX + ((i < 7) ? 200 : 630) + j * 26;
-                render_icon(renderer, icons[j], x, startY + (i % 7) * 35, 30);
+        for (int j = 0; j < view.rules.nbObjects; ++j) {
+            if (view.rules.cardObjects[i][j]) {
+                int x = startX + (second ? 630 : 200) + j * 26;
+                render_object(renderer, font, j, x, rowY, 30);
             }
         }
     }
+    sprite_batch_flush(&sprites, renderer);
 }
 
- // Button rendering function
-void render_osg_buttons(SDL_Renderer* renderer, TTF_Font* font) {
-    const char *labels[3] = {"Observe (O)", "Speculate (S)", "Guess (G)"};
-    SDL_Color black = {0, 0, 0, 255};
+/**
+ * @brief Draw character information table
+ * 
+ * The table only changes with the rules, so it is composited from its layer.
+ *
+ * @param renderer SDL renderer
+ * @param font Font object
+ */
+void draw_role_table(SDL_Renderer* renderer, TTF_Font* font) {
+    draw_static_layer(renderer, font, &roleLayer, layer_key(0), paint_role_table);
+}
 
-    // O button
-    SDL_Rect btnO = {BUTTON_O_X, BUTTON_O_Y, BUTTON_WIDTH, BUTTON_HEIGHT};
+ // Button fills: the only part of the buttons that changes (hover)
+void render_osg_buttons(SDL_Renderer* renderer, TTF_Font* font) {
+    // Inset by one pixel so the frames of the chrome layer stay visible
+    SDL_Rect btnO = {BUTTON_O_X + 1, BUTTON_O_Y + 1, BUTTON_WIDTH - 2, BUTTON_HEIGHT - 2};
     SDL_SetRenderDrawColor(renderer, hoverO ? 255 : 200, hoverO ? 220 : 200, hoverO ? 0 : 200, 255);
     SDL_RenderFillRect(renderer, &btnO);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderDrawRect(renderer, &btnO);
-    render_text(renderer, font, labels[0], btnO.x + 13, btnO.y + 10, black);
 
-    // S button 
-    SDL_Rect btnS = {BUTTON_S_X, BUTTON_S_Y, BUTTON_WIDTH, BUTTON_HEIGHT};
+    SDL_Rect btnS = {BUTTON_S_X + 1, BUTTON_S_Y + 1, BUTTON_WIDTH - 2, BUTTON_HEIGHT - 2};
     SDL_SetRenderDrawColor(renderer, hoverS ? 0 : 200, hoverS ? 220 : 200, hoverS ? 255 : 200, 255);
     SDL_RenderFillRect(renderer, &btnS);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); 
-    SDL_RenderDrawRect(renderer, &btnS);
-    render_text(renderer, font, labels[1], btnS.x + 9, btnS.y + 10, black);
 
-    // G button
-    SDL_Rect btnG = {BUTTON_G_X, BUTTON_G_Y, BUTTON_WIDTH, BUTTON_HEIGHT};
+    SDL_Rect btnG = {BUTTON_G_X + 1, BUTTON_G_Y + 1, BUTTON_WIDTH - 2, BUTTON_HEIGHT - 2};
     SDL_SetRenderDrawColor(renderer, hoverG ? 255 : 200, hoverG ? 0 : 200, hoverG ? 0 : 200, 255);
     SDL_RenderFillRect(renderer, &btnG);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderDrawRect(renderer, &btnG);
-    render_text(renderer, font, labels[2], btnG.x + 22, btnG.y + 10, black);
 }
@@ -0,0 +1,74 @@
+// hashring.c
+#include "../include/hashring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief FNV-1a, then murmur3's finalizer so close keys land far apart
+ */
+uint32_t ring_hash(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static int cmp_point(const void *a, const void *b) {
+    const RingPoint *x = a, *y = b;
+    if (x->point != y->point) return x->point < y->point ? -1 : 1;
+    return x->node - y->node;      // Same point: the order must not depend on qsort
+}
+
+/**
+ * @brief Place nodes on the ring; node i is names[i], skipped when NULL
+ *
+ * @return Nodes placed, or -1 if out of memory (the ring is left empty)
+ */
+int ring_build(HashRing *ring, const char *const *names, int count) {
+    ring_free(ring);
+    int placed = 0;
+    for (int i = 0; i < count; i++) placed += names[i] != NULL;
+    if (placed == 0) return 0;
+
+    ring->points = malloc(sizeof(RingPoint) * placed * RING_VNODES);
+    if (!ring->points) return -1;
+    for (int i = 0; i < count; i++) {
+        if (!names[i]) continue;
+        for (int v = 0; v < RING_VNODES; v++) {
+            char key[160];
+            int len = snprintf(key, sizeof(key), "%s#%d", names[i], v);
+            ring->points[ring->nbPoints++] = (RingPoint){ ring_hash(key, (size_t)len), i };
+        }
+    }
+    qsort(ring->points, ring->nbPoints, sizeof(RingPoint), cmp_point);
+    return placed;
+}
+
+/**
+ * @brief Node owning a key, or -1 on an empty ring
+ */
+int ring_lookup(const HashRing *ring, uint32_t key) {
+    if (ring->nbPoints == 0) return -1;
+    int lo = 0, hi = ring->nbPoints;       // First point >= key, wrapping to the start
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ring->points[mid].point < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return ring->points[lo == ring->nbPoints ? 0 : lo].node;
+}
+
+void ring_free(HashRing *ring) {
+    free(ring->points);
+    ring->points = NULL;
+    ring->nbPoints = 0;
+}
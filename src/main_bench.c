@@ -0,0 +1,237 @@
+// main_bench.c
+#include "../include/sh13client.h"
+#include "../include/strategy.h"
+#include "../include/rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+/* sh13-bench: drives a running server through full games over real
+ * sockets. Every session is a bot (a tournament strategy fed by what the
+ * server broadcasts); when its game ends it disconnects and a fresh one
+ * takes the seat, so the server keeps --tables tables busy until --games
+ * games are over. Used as the workload of `make pgo` and `make compare`. */
+
+#define BENCH_MAX_SESSIONS (64 * MAX_PLAYERS)
+#define BENCH_IDLE_TIMEOUT_NS 5000000000ULL    // A session silent this long is replaced
+#define BENCH_MAX_SAMPLES (1 << 20)
+#define BENCH_SEAT_RETRY_NS 20000000ULL        // No seat yet (tables still being reset): ask again
+
+typedef struct {
+    Sh13Client *c;
+    RuleSet rules;          // Knowledge points here
+    Knowledge k;
+    int dealt;
+    int alive;              // Players still in the game, as seen by this session
+    int turns;
+    uint64_t rng;
+    uint64_t sentNs;        // Action in flight, 0 if none
+    uint64_t lastNs;        // Last frame received (or connection time)
+    uint64_t connectNs;     // Last MSG_CONNECT sent
+} Session;
+
+static struct {
+    const char *endpoint;
+    int port;
+    int tables;
+    long games;
+    int maxTurns;
+    const Strategy *strategy;
+} bench = { "127.0.0.1", DEFAULT_PORT, 8, 1000, 200, NULL };
+
+static Session sessions[BENCH_MAX_SESSIONS];
+static int nbSessions;
+static long gamesDone, gamesAborted, actions;     // Aborted: draws, stalls and --max-turns
+static uint32_t *rttUs;
+static long nbRtt;
+static uint64_t seedCounter = 1;
+
+static void record_rtt(Session *s) {
+    if (!s->sentNs) return;
+    if (nbRtt < BENCH_MAX_SAMPLES) rttUs[nbRtt++] = (uint32_t)((sh13_now_ns() - s->sentNs) / 1000);
+    s->sentNs = 0;
+}
+
+static void play(Session *s) {
+    BotAction a = {0};
+    bench.strategy->choose(&s->k, &s->rng, &a);
+    s->sentNs = sh13_now_ns();
+    actions++;
+    if (a.kind == BOT_OBSERVE) sh13_client_observe(s->c, a.object);
+    else if (a.kind == BOT_SPECULATE) sh13_client_speculate(s->c, a.target, a.object);
+    else sh13_client_guess(s->c, a.card);
+}
+
+// The game is over for this session: seat 0 counts it, then the session leaves
+static void finish(Session *s, int won) {
+    if (sh13_client_state(s->c)->myClientId == 0) {
+        if (won) gamesDone++;
+        else gamesAborted++;
+    }
+    sh13_client_free(s->c);
+    s->c = NULL;
+}
+
+static void on_distribute(Sh13Client *c, const Payload_Distribute *p, void *user) {
+    Session *s = user;
+    int hand[MAX_HAND];
+    for (int i = 0; i < MAX_HAND; i++) hand[i] = p->Cards[i];
+    s->rules = sh13_client_state(c)->rules;
+    knowledge_init(&s->k, &s->rules, sh13_client_state(c)->myClientId, hand);
+    s->dealt = 1;
+    s->alive = s->rules.nbPlayers;
+}
+
+static void on_turn(Sh13Client *c, const Payload_Turn *p, void *user) {
+    Session *s = user;
+    if (!s->dealt) return;
+    s->turns++;
+    if (p->player_id == sh13_client_state(c)->myClientId && s->k.alive[p->player_id]) play(s);
+}
+
+static void on_verify(Sh13Client *c, const Payload_Verify *p, void *user) {
+    Session *s = user;
+    if (!s->dealt) return;
+    if (p->target_player_id < 0) knowledge_observe(&s->k, p->object_id, p->result_val);
+    else knowledge_speculate(&s->k, p->target_player_id, p->object_id, p->result_val);
+    record_rtt(s);
+}
+
+static void on_game_over(Sh13Client *c, const Payload_Game_Over *p, void *user) {
+    Session *s = user;
+    record_rtt(s);
+    if (p->is_winner) {
+        s->dealt = -1;      // Finished, leaves after this read
+        return;
+    }
+    if (p->player_id >= 0 && p->player_id < MAX_PLAYERS && s->dealt) {
+        knowledge_eliminated(&s->k, p->player_id);
+        if (--s->alive == 0) s->dealt = -2;    // Nobody left to guess
+    }
+}
+
+static const Sh13Callbacks callbacks = {
+    .onDistribute = on_distribute,
+    .onTurn = on_turn,
+    .onVerify = on_verify,
+    .onGameOver = on_game_over,
+};
+
+static int send_connect(Session *s) {
+    char name[32];
+    snprintf(name, sizeof(name), "bench%ld", (long)(s - sessions));
+    s->connectNs = sh13_now_ns();
+    return sh13_client_send_connect(s->c, name, 0);
+}
+
+static int open_session(Session *s) {
+    memset(s, 0, sizeof(*s));
+    s->rng = seedCounter++ * 0x9E3779B97F4A7C15ULL;
+    s->lastNs = sh13_now_ns();
+    s->c = sh13_client_new(&callbacks, s);
+    if (!s->c || sh13_client_connect(s->c, bench.endpoint, bench.port) < 0) {
+        if (s->c) sh13_client_free(s->c);
+        s->c = NULL;
+        return -1;
+    }
+    return send_connect(s);
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--endpoint=HOST|unix:/path] [--port=N] [--tables=N] [--games=N]\n"
+                    "          [--players=N] [--max-turns=N] [--strategy=NAME]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int players = 4;
+    const char *strategy = "greedy";
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--endpoint=", 11) == 0) bench.endpoint = arg + 11;
+        else if (strncmp(arg, "--port=", 7) == 0) bench.port = atoi(arg + 7);
+        else if (strncmp(arg, "--tables=", 9) == 0) bench.tables = atoi(arg + 9);
+        else if (strncmp(arg, "--games=", 8) == 0) bench.games = atol(arg + 8);
+        else if (strncmp(arg, "--players=", 10) == 0) players = atoi(arg + 10);
+        else if (strncmp(arg, "--max-turns=", 12) == 0) bench.maxTurns = atoi(arg + 12);
+        else if (strncmp(arg, "--strategy=", 11) == 0) strategy = arg + 11;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    bench.strategy = strategy_find(strategy);
+    if (!bench.strategy) {
+        fprintf(stderr, "[Bench] Unknown strategy '%s'\n", strategy);
+        return 1;
+    }
+    if (players < 2 || players > MAX_PLAYERS) players = 4;
+    nbSessions = bench.tables * players;
+    if (nbSessions < 1 || nbSessions > BENCH_MAX_SESSIONS) {
+        fprintf(stderr, "[Bench] --tables x --players must be 1..%d\n", BENCH_MAX_SESSIONS);
+        return 1;
+    }
+    rttUs = malloc(sizeof(uint32_t) * BENCH_MAX_SAMPLES);
+
+    printf("[Bench] %d table(s) of %d on %s:%d, %ld games, strategy %s\n",
+           bench.tables, players, bench.endpoint, bench.port, bench.games, bench.strategy->name);
+    for (int i = 0; i < nbSessions; i++) {
+        if (open_session(&sessions[i]) < 0) {
+            fprintf(stderr, "[Bench] Cannot reach the server.\n");
+            return 1;
+        }
+    }
+
+    struct pollfd *fds = calloc(nbSessions, sizeof(struct pollfd));
+    uint64_t startNs = sh13_now_ns();
+    while (gamesDone + gamesAborted < bench.games) {
+        for (int i = 0; i < nbSessions; i++) {
+            fds[i].fd = sessions[i].c ? sh13_client_fd(sessions[i].c) : -1;
+            fds[i].events = POLLIN;
+        }
+        if (poll(fds, nbSessions, 10) < 0) break;
+
+        uint64_t now = sh13_now_ns();
+        for (int i = 0; i < nbSessions; i++) {
+            Session *s = &sessions[i];
+            if (s->c && (fds[i].revents & POLLIN)) {
+                if (sh13_client_read(s->c) < 0) {
+                    sh13_client_free(s->c);
+                    s->c = NULL;
+                } else {
+                    s->lastNs = now;
+                }
+            }
+            // The server ignores a login when every table is busy
+            if (s->c && sh13_client_state(s->c)->myClientId < 0 && now - s->connectNs > BENCH_SEAT_RETRY_NS) {
+                s->lastNs = now;
+                send_connect(s);
+            }
+            // Ended, stalled or too long: leave the table
+            if (s->c && (s->dealt < 0 || now - s->lastNs > BENCH_IDLE_TIMEOUT_NS || s->turns > bench.maxTurns)) {
+                finish(s, s->dealt == -1);
+            }
+            // A fresh bot takes the seat right away
+            if (!s->c && open_session(s) < 0) goto out;
+        }
+    }
+out:;
+    double secs = (sh13_now_ns() - startNs) / 1e9;
+    qsort(rttUs, nbRtt, sizeof(uint32_t), cmp_u32);
+    uint32_t p50 = nbRtt ? rttUs[nbRtt / 2] : 0;
+    uint32_t p99 = nbRtt ? rttUs[nbRtt * 99 / 100] : 0;
+    printf("[Bench] %ld games (%ld aborted) in %.2f s: %.0f games/s, %.0f actions/s, action RTT p50=%uus p99=%uus\n",
+           gamesDone, gamesAborted, secs, gamesDone / secs, actions / secs, p50, p99);
+
+    for (int i = 0; i < nbSessions; i++) {
+        if (sessions[i].c) sh13_client_free(sessions[i].c);
+    }
+    free(fds);
+    free(rttUs);
+    return gamesDone > 0 ? 0 : 1;
+}
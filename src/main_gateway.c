@@ -0,0 +1,35 @@
+// main_gateway.c
+#include "../include/gateway.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [port] --backend=HOST:PORT|unix:/path [--backend=...] [--backends=FILE]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    GatewayConfig cfg = { .port = DEFAULT_PORT };
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--backend=", 10) == 0) {
+            if (cfg.nbBackends == GW_MAX_BACKENDS) {
+                fprintf(stderr, "[Gateway] At most %d backends\n", GW_MAX_BACKENDS);
+                return 1;
+            }
+            cfg.backends[cfg.nbBackends++] = arg + 10;
+        } else if (strncmp(arg, "--backends=", 11) == 0) {
+            cfg.backendsFile = arg + 11;
+        } else if (arg[0] != '-' && atoi(arg) > 0) {
+            cfg.port = atoi(arg);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (cfg.nbBackends == 0 && !cfg.backendsFile) {
+        usage(argv[0]);
+        return 1;
+    }
+    return gateway_run(&cfg) < 0 ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+// main_migrate.c
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define REPLY_TIMEOUT_MS 5000      // Longest wait for the source's answer to one MSG_MIGRATE
+
+// External helpers from common.c
+extern int send_all(int sockfd, const void *buffer, size_t length);
+extern int recv_all(int sockfd, void *buffer, size_t length);
+
+static const char *status_text(int status) {
+    switch (status) {
+        case MIGRATE_OK:          return "ok";
+        case MIGRATE_BAD_ROOM:    return "no such room";
+        case MIGRATE_EMPTY:       return "nobody seated";
+        case MIGRATE_REFUSED:     return "refused by the target (migrate-secret or rules)";
+        case MIGRATE_NO_ROOM:     return "no empty room on the target";
+        case MIGRATE_UNREACHABLE: return "target unreachable or too slow";
+        case MIGRATE_BUSY:        return "players of a previous migration still coming back";
+        default:                  return "?";
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s unix:/SOURCE/SOCKET ROOM|all HOST:PORT|unix:/path\n", prog);
+}
+
+// One MSG_MIGRATE on the source's admin connection; -1 if the source went away or did not answer
+static int migrate_one(int sock, int roomId, const char *endpoint, int port, Payload_Migrate_Result *res) {
+    struct {
+        PacketHeader header;
+        Payload_Migrate pkg;
+    } __attribute__((packed)) frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.header.type = MSG_MIGRATE;
+    frame.header.length = htonl(sizeof(frame.pkg));
+    frame.pkg.roomId = roomId;
+    frame.pkg.port = port;
+    snprintf(frame.pkg.endpoint, sizeof(frame.pkg.endpoint), "%s", endpoint);
+    if (send_all(sock, &frame, sizeof(frame)) < 0) return -1;
+
+    PacketHeader header;
+    if (recv_all(sock, &header, sizeof(header)) < 0 || header.type != MSG_MIGRATE_RESULT ||
+        ntohl(header.length) != sizeof(*res)) return -1;
+    return recv_all(sock, res, sizeof(*res));
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 || strncmp(argv[1], ENDPOINT_UNIX_PREFIX, strlen(ENDPOINT_UNIX_PREFIX)) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    int all = strcmp(argv[2], "all") == 0;
+    int first = all ? 0 : atoi(argv[2]);
+
+    // The target as the players will reach it: "unix:/path" or "HOST:PORT"
+    char endpoint[ENDPOINT_MAX];
+    int port = 0;
+    snprintf(endpoint, sizeof(endpoint), "%s", argv[3]);
+    if (strncmp(endpoint, ENDPOINT_UNIX_PREFIX, strlen(ENDPOINT_UNIX_PREFIX)) != 0) {
+        char *colon = strrchr(endpoint, ':');
+        if (!colon || (port = atoi(colon + 1)) <= 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        *colon = '\0';
+    }
+
+    int sock = connect_endpoint(argv[1], 0);
+    if (sock < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    struct timeval tv = { REPLY_TIMEOUT_MS / 1000, (REPLY_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // "all" drains the source: every room with players, until the room ids run out
+    int moved = 0, failed = 0;
+    for (int roomId = first;; roomId++) {
+        Payload_Migrate_Result res;
+        if (migrate_one(sock, roomId, endpoint, port, &res) < 0) {
+            fprintf(stderr, "[Migrate] Room %d: no answer from %s.\n", roomId, argv[1]);
+            close(sock);
+            return 1;
+        }
+        if (res.status == MIGRATE_OK) {
+            printf("[Migrate] Room %d -> room %d on %s, table held %.1f ms.\n", roomId, res.roomId, argv[3],
+                   res.pauseUs / 1000.0);
+            moved++;
+        } else if (!all || (res.status != MIGRATE_EMPTY && res.status != MIGRATE_BAD_ROOM)) {
+            printf("[Migrate] Room %d: %s.\n", roomId, status_text(res.status));
+            failed++;
+        }
+        if (!all || res.status == MIGRATE_BAD_ROOM) break;
+    }
+    if (all) printf("[Migrate] %d room(s) moved, %d failed.\n", moved, failed);
+    close(sock);
+    return failed ? 1 : 0;
+}
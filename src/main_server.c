@@ -1,16 +1,45 @@
 // main_serveur.c
 #include "../include/server_logic.h"
+#include "../include/server_config.h"
+#include "../include/upgrade.h"
+#include "../include/rules.h"
+#include "../include/ratings.h"
+#include "../include/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 int main(int argc, char *argv[]) {
-    int port = (argc >= 2) ? atoi(argv[1]) : DEFAULT_PORT;
-    printf("Starting server on port %d...\n", port);
+    // Usage: ./serveur [port] [--config=FILE] [--key=value ...] (see README)
+    config_defaults(&serverConfig);
+    if (config_parse_args(&serverConfig, argc, argv) < 0) return 1;
+    connLimits = serverConfig.conn;
+    admissionLimits = serverConfig.admission;
+    if (rules_load(&activeRules, serverConfig.rules) < 0) return 1;
 
-    melangerDeck();
-    createTable();
-    start_server_listener(port);
+    upgrade_init(argc, argv);
+    printf("Starting server on port %d...\n", serverConfig.port);
+    config_print(&serverConfig);
+    printf("[Config] rules=%s players=%d cards=%d hand=%d objects=%d rooms=%d\n", activeRules.name,
+           activeRules.nbPlayers, activeRules.nbCards, activeRules.handSize, activeRules.nbObjects,
+           serverConfig.rooms);
+
+    if (ratings_open(serverConfig.ratingsLog) < 0) return 1;
+    if (serverConfig.traceFile[0] != '\0') {
+        // The binary taken over by a hot upgrade records to its own file
+        char path[300];
+        if (getenv(UPGRADE_ENV_FD) != NULL) {
+            snprintf(path, sizeof(path), "%s.%d", serverConfig.traceFile, (int)getpid());
+        } else {
+            snprintf(path, sizeof(path), "%s", serverConfig.traceFile);
+        }
+        if (trace_open(path) < 0) return 1;
+    }
+
+    rooms_init(serverConfig.rooms);
+    start_server_listener(serverConfig.port);
 
     return 0;
 }
@@ -0,0 +1,230 @@
+// main_solver.c
+#include "../include/solver.h"
+#include "../include/game.h"
+#include "../include/rules.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SOLVER_MAX_DEPTH 8
+#define SOLVER_MAX_STRATEGIES 8
+
+static RuleSet rules;
+static TransTable tt;
+static int depth = 3;
+static long deals = 20;
+static uint64_t seed = 13;
+static int nbStrategies;
+static const Strategy *strategies[SOLVER_MAX_STRATEGIES];
+
+// Sums over the sampled deals, per depth: [0] optimal, [1 + i] strategy i
+static double sums[SOLVER_MAX_DEPTH + 1][1 + SOLVER_MAX_STRATEGIES];
+static long worldsSum;
+static SolverCounters counters;
+static atomic_long nextDeal;
+static pthread_mutex_t sumsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *action_name(const RuleSet *r, const BotAction *a, char *buf, size_t len) {
+    if (a->kind == BOT_GUESS) snprintf(buf, len, "G %s", r->cardNames[a->card]);
+    else if (a->kind == BOT_OBSERVE) snprintf(buf, len, "O %s", r->objectNames[a->object]);
+    else snprintf(buf, len, "S seat %d %s", a->target, r->objectNames[a->object]);
+    return buf;
+}
+
+// Deals are shared out one at a time; each thread solves its own
+static void *deal_worker(void *arg) {
+    (void)arg;
+    SolverCounters local = {0};
+    for (;;) {
+        long i = atomic_fetch_add(&nextDeal, 1);
+        if (i >= deals) break;
+        Game g;
+        game_init(&g, &rules, seed ^ (uint64_t)i * 0x9e3779b97f4a7c15ull);
+        game_start(&g);
+        Solver s;
+        if (solver_init(&s, &rules, game_hand(&g, 0), &tt) < 0) break;
+
+        double row[SOLVER_MAX_DEPTH + 1][1 + SOLVER_MAX_STRATEGIES];
+        for (int d = 1; d <= depth; d++) {
+            row[d][0] = solver_value(&s, d, &local);
+            for (int k = 0; k < nbStrategies; k++) row[d][1 + k] = solver_policy_value(&s, strategies[k], d, i);
+        }
+        pthread_mutex_lock(&sumsLock);
+        worldsSum += s.ws.nbWorlds;
+        for (int d = 1; d <= depth; d++) {
+            for (int k = 0; k <= nbStrategies; k++) sums[d][k] += row[d][k];
+        }
+        pthread_mutex_unlock(&sumsLock);
+        solver_free(&s);
+    }
+    pthread_mutex_lock(&sumsLock);
+    counters.nodes += local.nodes;
+    counters.hits += local.hits;
+    counters.stores += local.stores;
+    pthread_mutex_unlock(&sumsLock);
+    return NULL;
+}
+
+static int parse_hand(const char *spec, int *hand) {
+    int n = 0;
+    for (const char *p = spec; *p && n < MAX_HAND;) {
+        char *end;
+        long card = strtol(p, &end, 10);
+        if (end == p || card < 0 || card >= rules.nbCards) return -1;
+        hand[n++] = card;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return -1;
+    }
+    return n;
+}
+
+/**
+ * @brief Time the world kernel: each sampled deal replays the S answers of
+ * the real table against the full world set, once per instruction set
+ */
+static void bench_filters(void) {
+    printf("[Solver] World filtering, rules=%s, %ld deals\n", rules.name, deals);
+    for (int isa = WORLDS_SCALAR; isa <= WORLDS_AVX2; isa++) {
+        worlds_set_isa(isa);
+        if ((int)worlds_isa() != isa) continue;
+        long filters = 0, worlds = 0;
+        double elapsed = 0;
+        for (long i = 0; i < deals; i++) {
+            Game g;
+            game_init(&g, &rules, seed ^ (uint64_t)i * 0x9e3779b97f4a7c15ull);
+            game_start(&g);
+            WorldSet ws;
+            if (worlds_build(&ws, &rules, game_hand(&g, 0)) < 0) return;
+            worlds += ws.nbWorlds;
+            for (int rep = 0; rep < 100; rep++) {
+                worlds_reset(&ws);
+                double t0 = now_s();
+                for (int o = 0; o < rules.nbObjects; o++) {
+                    for (int p = 1; p < rules.nbPlayers; p++) {
+                        int count = game_speculate(&g, p, o);
+                        worlds_filter_count(&ws, p, o, count, count);
+                        filters++;
+                    }
+                }
+                elapsed += now_s() - t0;
+            }
+            worlds_free(&ws);
+        }
+        printf("  %-6s %8.3f us per MSG_VERIFY over %.0f worlds\n", worlds_isa_name(isa),
+               elapsed * 1e6 / filters, (double)worlds / deals);
+    }
+    worlds_set_isa(WORLDS_AVX2);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--rules=NAME|FILE] [--depth=N] [--threads=N] [--tt-mb=N]\n"
+            "          [--hand=c1,c2,...] | [--deals=N] [--seed=N] [--strategies=a,b,...] | [--bench]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *rulesName = "classic";
+    const char *handSpec = NULL;
+    int bench = 0;
+    const char *strategyList = "random,greedy,bold";
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int ttMb = 256;
+    if (threads < 1) threads = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--rules=", 8) == 0) rulesName = arg + 8;
+        else if (strncmp(arg, "--depth=", 8) == 0) depth = atoi(arg + 8);
+        else if (strncmp(arg, "--threads=", 10) == 0) threads = atoi(arg + 10);
+        else if (strncmp(arg, "--tt-mb=", 8) == 0) ttMb = atoi(arg + 8);
+        else if (strncmp(arg, "--hand=", 7) == 0) handSpec = arg + 7;
+        else if (strncmp(arg, "--deals=", 8) == 0) deals = atol(arg + 8);
+        else if (strncmp(arg, "--seed=", 7) == 0) seed = strtoull(arg + 7, NULL, 10);
+        else if (strncmp(arg, "--strategies=", 13) == 0) strategyList = arg + 13;
+        else if (strcmp(arg, "--bench") == 0) bench = 1;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (depth < 1 || depth > SOLVER_MAX_DEPTH || threads < 1 || ttMb < 1 || deals < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (rules_load(&rules, rulesName) < 0) return 1;
+    if (tt_init(&tt, ttMb) < 0) {
+        fprintf(stderr, "[Solver] Cannot allocate %d MB of transposition table\n", ttMb);
+        return 1;
+    }
+
+    char buf[256];
+    strncpy(buf, strategyList, sizeof(buf) - 1);
+    for (char *save = NULL, *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const Strategy *st = strategy_find(name);
+        if (!st || nbStrategies == SOLVER_MAX_STRATEGIES) {
+            fprintf(stderr, "[Solver] Bad strategy '%s'\n", name);
+            return 1;
+        }
+        strategies[nbStrategies++] = st;
+    }
+
+    if (bench) {
+        bench_filters();
+        tt_free(&tt);
+        return 0;
+    }
+
+    double t0 = now_s();
+    if (handSpec) {
+        // One information set: value of every first move
+        int hand[MAX_HAND];
+        if (parse_hand(handSpec, hand) != rules.handSize) {
+            fprintf(stderr, "[Solver] --hand needs %d distinct cards of 0-%d\n", rules.handSize, rules.nbCards - 1);
+            return 1;
+        }
+        Solver s;
+        if (solver_init(&s, &rules, hand, &tt) < 0) return 1;
+        SolverAction actions[MAX_CARDS + MAX_OBJECTS * MAX_PLAYERS];
+        int n = solver_root_actions(&s, depth, threads, actions, sizeof(actions) / sizeof(actions[0]), &counters);
+        printf("[Solver] rules=%s depth=%d worlds=%d\n", rules.name, depth, s.ws.nbWorlds);
+        for (int i = 0; i < n; i++) {
+            char name[64];
+            action_name(&rules, &actions[i].action, name, sizeof(name));
+            if (actions[i].value < 0) printf("  %-24s      -  (same answer in every world)\n", name);
+            else printf("  %-24s %6.2f%%\n", name, 100 * actions[i].value);
+        }
+        solver_free(&s);
+    } else {
+        // Sampled deals: optimal race value against the bots', per depth
+        pthread_t tids[256];
+        int started = 0;
+        for (int t = 1; t < threads && t < 256; t++) {
+            if (pthread_create(&tids[started], NULL, deal_worker, NULL) == 0) started++;
+        }
+        deal_worker(NULL);
+        for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+
+        printf("[Solver] rules=%s deals=%ld worlds/deal=%.0f\n", rules.name, deals, (double)worldsSum / deals);
+        printf("  P(culprit named within d own turns)\n  %-5s %8s", "d", "optimal");
+        for (int k = 0; k < nbStrategies; k++) printf(" %8s", strategies[k]->name);
+        printf("\n");
+        for (int d = 1; d <= depth; d++) {
+            printf("  %-5d", d);
+            for (int k = 0; k <= nbStrategies; k++) printf(" %7.2f%%", 100 * sums[d][k] / deals);
+            printf("\n");
+        }
+    }
+    printf("[Solver] %.2f s, %ld nodes, %ld table hits, %ld stores, %ld threads\n",
+           now_s() - t0, counters.nodes, counters.hits, counters.stores, threads);
+    tt_free(&tt);
+    return 0;
+}
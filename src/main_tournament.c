@@ -0,0 +1,100 @@
+// main_tournament.c
+#include "../include/tournament.h"
+#include "../include/rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void usage(const char *prog) {
+    int count;
+    const Strategy *list = strategy_list(&count);
+    fprintf(stderr,
+            "Usage: %s [--games=N] [--threads=N] [--rules=NAME|FILE] [--format=round-robin|swiss]\n"
+            "          [--rounds=N] [--seed=N] [--max-turns=N] [--strategies=a,b,...]\n"
+            "Strategies:\n", prog);
+    for (int i = 0; i < count; i++) fprintf(stderr, "  %-8s %s\n", list[i].name, list[i].description);
+}
+
+static int parse_strategies(TournamentConfig *cfg, const char *spec) {
+    char buf[256];
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    cfg->nbStrategies = 0;
+    for (char *save = NULL, *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const Strategy *s = strategy_find(name);
+        if (!s) {
+            fprintf(stderr, "[Tournament] Unknown strategy '%s'\n", name);
+            return -1;
+        }
+        if (cfg->nbStrategies == TOURNAMENT_MAX_STRATEGIES) {
+            fprintf(stderr, "[Tournament] At most %d strategies\n", TOURNAMENT_MAX_STRATEGIES);
+            return -1;
+        }
+        cfg->strategies[cfg->nbStrategies++] = s;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static RuleSet rules;
+    const char *rulesName = "classic";
+    const char *strategies = "random,greedy,bold";
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    TournamentConfig cfg = {
+        .format = FORMAT_ROUND_ROBIN,
+        .games = 100000,
+        .rounds = 5,
+        .threads = threads > 0 ? threads : 1,
+        .maxTurns = 200,
+        .seed = 13,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--games=", 8) == 0) cfg.games = atol(arg + 8);
+        else if (strncmp(arg, "--threads=", 10) == 0) cfg.threads = atoi(arg + 10);
+        else if (strncmp(arg, "--rules=", 8) == 0) rulesName = arg + 8;
+        else if (strncmp(arg, "--rounds=", 9) == 0) cfg.rounds = atoi(arg + 9);
+        else if (strncmp(arg, "--seed=", 7) == 0) cfg.seed = strtoull(arg + 7, NULL, 10);
+        else if (strncmp(arg, "--max-turns=", 12) == 0) cfg.maxTurns = atoi(arg + 12);
+        else if (strncmp(arg, "--strategies=", 13) == 0) strategies = arg + 13;
+        else if (strcmp(arg, "--format=round-robin") == 0) cfg.format = FORMAT_ROUND_ROBIN;
+        else if (strcmp(arg, "--format=swiss") == 0) cfg.format = FORMAT_SWISS;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (rules_load(&rules, rulesName) < 0) return 1;
+    cfg.rules = &rules;
+    if (parse_strategies(&cfg, strategies) < 0) return 1;
+    if (cfg.nbStrategies < 2 || cfg.games < 1 || cfg.threads < 1 || cfg.maxTurns < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("[Tournament] %ld games, %s, rules=%s (%d players), %d threads, seed=%llu\n",
+           cfg.games, cfg.format == FORMAT_SWISS ? "swiss" : "round-robin", rules.name,
+           rules.nbPlayers, cfg.threads, (unsigned long long)cfg.seed);
+
+    TournamentResult res;
+    if (tournament_run(&cfg, &res) < 0) {
+        fprintf(stderr, "[Tournament] Run failed\n");
+        return 1;
+    }
+
+    printf("%-3s %-8s %10s %9s %8s %17s %7s\n", "#", "strategy", "seats", "wins", "rate", "95% CI", "elo");
+    for (int i = 0; i < cfg.nbStrategies; i++) {
+        double lo, hi;
+        wilson_interval(res.wins[i], res.played[i], &lo, &hi);
+        printf("%-3d %-8s %10ld %9ld %7.2f%% [%6.2f%%, %6.2f%%] %7.0f\n", i, cfg.strategies[i]->name,
+               res.played[i], res.wins[i], res.played[i] ? 100.0 * res.wins[i] / res.played[i] : 0,
+               100 * lo, 100 * hi, res.elo[i]);
+    }
+    printf("[Tournament] %ld games (%ld draws), %.1f turns/game, %.2f s, %.0f games/s, %ld steals\n",
+           res.games, res.draws, res.games ? (double)res.turns / res.games : 0, res.seconds,
+           res.seconds > 0 ? res.games / res.seconds : 0, res.steals);
+    return 0;
+}
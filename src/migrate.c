@@ -0,0 +1,192 @@
+// migrate.c
+#include "../include/migrate.h"
+#include "../include/rules.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/random.h>
+
+static uint32_t chat_line_size(const Chat_Line *line) {
+    return offsetof(Chat_Line, text) + strnlen(line->text, CHAT_MAX_TEXT) + 1;
+}
+
+/**
+ * @brief Pack a table into `buf`; caller holds r->lock and has set r->resumeToken
+ *
+ * The newest chat lines that fit in `cap` go along, the older ones stay behind.
+ *
+ * @return Bytes written, or 0 if `cap` cannot even hold the game
+ */
+uint32_t migrate_pack(const Room *r, void *buf, uint32_t cap) {
+    if (cap < sizeof(MigrateRoom)) return 0;
+    MigrateRoom *m = buf;
+    memset(m, 0, sizeof(*m));
+    m->nbClients = r->nbClients;
+    m->nbPlayers = r->nbPlayers;
+    m->joueurCourant = r->game.current;
+    m->crimeCard = r->game.crimeCard;
+    m->gameStarted = r->gameStarted;
+    m->finished = r->finished;
+    for (int i = 0; i < MAX_CARDS; i++) m->deck[i] = (int8_t)r->game.deck[i];
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        for (int o = 0; o < MAX_OBJECTS; o++) m->tableCartes[p][o] = (int8_t)r->game.table[p][o];
+        m->playerAlive[p] = (int8_t)r->game.alive[p];
+    }
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        snprintf(m->names[i], sizeof(m->names[i]), "%.31s", r->tcpClients[i].name);
+        m->resumeToken[i] = r->resumeToken[i];
+    }
+    m->chatSeq = r->chatSeq;
+
+    // Newest lines first until the frame is full, then written oldest first
+    uint32_t count = r->chatSeq < CHAT_HISTORY ? r->chatSeq : CHAT_HISTORY;
+    uint32_t room = cap - sizeof(MigrateRoom), lines = 0;
+    while (lines < count) {
+        uint32_t size = chat_line_size(&r->chat[(r->chatSeq - 1 - lines) % CHAT_HISTORY]);
+        if (size > room) break;
+        room -= size;
+        lines++;
+    }
+    m->chatLines = (uint8_t)lines;
+    char *p = (char *)buf + sizeof(MigrateRoom);
+    for (uint32_t i = 0; i < lines; i++) {
+        const Chat_Line *line = &r->chat[(r->chatSeq - lines + i) % CHAT_HISTORY];
+        uint32_t size = chat_line_size(line);
+        memcpy(p, line, size);
+        p[size - 1] = '\0';
+        p += size;
+    }
+    return (uint32_t)(p - (char *)buf);
+}
+
+/**
+ * @brief Load a packed table into an empty room; caller holds r->lock
+ *
+ * Every seat starts without a connection: the players come back through
+ * MSG_RESUME with the tokens the record carries.
+ *
+ * @return 0, or -1 if the record does not fit the active rules
+ */
+int migrate_unpack(Room *r, const void *buf, uint32_t len) {
+    MigrateRoom m;
+    if (len < sizeof(m)) return -1;
+    memcpy(&m, buf, sizeof(m));
+    if (m.nbPlayers != activeRules.nbPlayers || m.nbClients < 0 || m.nbClients > m.nbPlayers ||
+        m.joueurCourant < 0 || m.joueurCourant >= m.nbPlayers || m.chatLines > CHAT_HISTORY) return -1;
+
+    room_reset(r);
+    r->nbClients = m.nbClients;
+    r->game.current = m.joueurCourant;
+    r->game.crimeCard = m.crimeCard;
+    r->game.winner = -1;
+    r->gameStarted = m.gameStarted;
+    r->finished = m.finished;
+    for (int i = 0; i < MAX_CARDS; i++) r->game.deck[i] = m.deck[i];
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        for (int o = 0; o < MAX_OBJECTS; o++) r->game.table[p][o] = m.tableCartes[p][o];
+        r->game.alive[p] = m.playerAlive[p];
+    }
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        snprintf(r->tcpClients[i].name, sizeof(r->tcpClients[i].name), "%.31s", m.names[i]);
+        r->resumeToken[i] = i < m.nbClients ? m.resumeToken[i] : 0;
+    }
+
+    const char *p = (const char *)buf + sizeof(m), *end = (const char *)buf + len;
+    for (int i = 0; i < m.chatLines; i++) {
+        Chat_Line line;
+        memset(&line, 0, sizeof(line));
+        size_t head = offsetof(Chat_Line, text);
+        if ((size_t)(end - p) <= head) break;
+        size_t size = head + strnlen(p + head, end - p - head) + 1;
+        if (size > sizeof(line) || size > (size_t)(end - p)) break;
+        memcpy(&line, p, size);
+        line.name[sizeof(line.name) - 1] = '\0';
+        r->chat[line.seq % CHAT_HISTORY] = line;
+        p += size;
+    }
+    r->chatSeq = m.chatSeq;
+    return 0;
+}
+
+/**
+ * @brief Unguessable, non-zero seat token
+ */
+uint64_t migrate_token(void) {
+    uint64_t token = 0;
+    if (getrandom(&token, sizeof(token), 0) != sizeof(token)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        token = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+    }
+    return token ? token : 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Send (or receive) all of `buf` on a non-blocking socket, waiting in poll() for what is left until `deadlineNs`
+static int move_until(int sock, void *buf, size_t len, int sending, uint64_t deadlineNs) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = sending ? send(sock, p, len, MSG_NOSIGNAL) : recv(sock, p, len, 0);
+        if (n > 0) {
+            p += n;
+            len -= n;
+            continue;
+        }
+        if (n == 0 && !sending) return -1;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+
+        uint64_t now = now_ns();
+        if (now >= deadlineNs) return -1;
+        struct pollfd pfd = { .fd = sock, .events = sending ? POLLOUT : POLLIN };
+        if (poll(&pfd, 1, (int)((deadlineNs - now + 999999) / 1000000)) < 0 && errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Open a non-blocking connection to the target server
+ *
+ * Done before the table is held: only the transfer itself counts in the pause.
+ *
+ * @return Connected socket, or -1
+ */
+int migrate_connect(const char *endpoint, int port) {
+    int sock = connect_endpoint(endpoint, port);
+    if (sock < 0) return -1;
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return sock;
+}
+
+/**
+ * @brief Send a MSG_ROOM_IMPORT payload and wait for the target's answer
+ *
+ * The whole exchange gets MIGRATE_TIMEOUT_MS, however the target spreads
+ * it over partial sends and reads.
+ *
+ * @return 0 with `result` filled, -1 if the target did not answer in time
+ */
+int migrate_transfer(int sock, const void *payload, uint32_t len, Payload_Migrate_Result *result) {
+    uint64_t deadlineNs = now_ns() + MIGRATE_TIMEOUT_MS * 1000000ULL;
+    char frame[sizeof(PacketHeader) + ROOM_IMPORT_MAX];
+    PacketHeader header = { .type = MSG_ROOM_IMPORT, .length = htonl(len) };
+    if (len > ROOM_IMPORT_MAX) return -1;
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), payload, len);
+    if (move_until(sock, frame, sizeof(header) + len, 1, deadlineNs) < 0) return -1;
+
+    if (move_until(sock, &header, sizeof(header), 0, deadlineNs) < 0 || header.type != MSG_MIGRATE_RESULT ||
+        ntohl(header.length) != sizeof(*result)) return -1;
+    return move_until(sock, result, sizeof(*result), 0, deadlineNs);
+}
@@ -0,0 +1,167 @@
+// perf_overlay.c
+#include "../include/perf_overlay.h"
+#include "../include/gui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PERF_MAX_WINDOW_NS 1000000000ull   // Worst frame is tracked per second
+
+static struct {
+    int visible;
+    FILE *csv;
+    uint64_t startNs;
+    uint64_t frameStartNs, markNs;
+    double phaseMs[PERF_PHASES];        // Frame being measured
+    int draws;
+
+    // Last completed frame, shown by the overlay
+    double lastPhaseMs[PERF_PHASES];
+    double lastFrameMs, avgFrameMs;
+    double maxFrameMs, windowMaxMs;
+    uint64_t windowStartNs;
+    int lastDraws;
+    PerfFrameInfo info;
+    unsigned long frames;
+} perf;
+
+static uint64_t perf_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Start measuring; opens the CSV log named by SH13_PERF_CSV, if any
+ */
+void perf_init(void) {
+    perf.startNs = perf_now_ns();
+    perf.info.rttUs = -1;
+    const char *path = getenv("SH13_PERF_CSV");
+    if (!path || !*path) return;
+    perf.csv = fopen(path, "w");
+    if (!perf.csv) {
+        perror("[Client] SH13_PERF_CSV");
+        return;
+    }
+    fprintf(perf.csv, "time_ms,frame_ms,events_ms,update_ms,render_ms,present_ms,draws,textures,rtt_ms,since_server_ms\n");
+    printf("[Client] Logging frame timings to %s\n", path);
+}
+
+void perf_shutdown(void) {
+    if (perf.csv) fclose(perf.csv);
+    perf.csv = NULL;
+}
+
+// Something wants the numbers: the overlay or the CSV log
+int perf_active(void) {
+    return perf.visible || perf.csv != NULL;
+}
+
+int perf_overlay_visible(void) {
+    return perf.visible;
+}
+
+void perf_overlay_toggle(void) {
+    perf.visible = !perf.visible;
+}
+
+void perf_frame_begin(void) {
+    perf.frameStartNs = perf.markNs = perf_now_ns();
+    for (int i = 0; i < PERF_PHASES; i++) perf.phaseMs[i] = 0;
+    perf.draws = 0;
+}
+
+/**
+ * @brief Close a phase: the time since the previous mark is charged to it
+ */
+void perf_phase_end(PerfPhase phase) {
+    uint64_t now = perf_now_ns();
+    perf.phaseMs[phase] += (now - perf.markNs) / 1e6;
+    perf.markNs = now;
+}
+
+void perf_count_draws(int n) {
+    perf.draws += n;
+}
+
+static double since_server_ms(const PerfFrameInfo *info, uint64_t now) {
+    if (!info->lastMessageNs || info->lastMessageNs > now) return -1;
+    return (now - info->lastMessageNs) / 1e6;
+}
+
+/**
+ * @brief Keep the finished frame for the overlay and log it
+ */
+void perf_frame_end(const PerfFrameInfo *info) {
+    uint64_t now = perf_now_ns();
+    double frameMs = (now - perf.frameStartNs) / 1e6;
+
+    for (int i = 0; i < PERF_PHASES; i++) perf.lastPhaseMs[i] = perf.phaseMs[i];
+    perf.lastFrameMs = frameMs;
+    perf.avgFrameMs = perf.frames ? perf.avgFrameMs * 0.9 + frameMs * 0.1 : frameMs;
+    if (now - perf.windowStartNs >= PERF_MAX_WINDOW_NS) {
+        perf.maxFrameMs = perf.windowMaxMs > frameMs ? perf.windowMaxMs : frameMs;
+        perf.windowMaxMs = 0;
+        perf.windowStartNs = now;
+    }
+    if (frameMs > perf.windowMaxMs) perf.windowMaxMs = frameMs;
+    perf.lastDraws = perf.draws;
+    perf.info = *info;
+    perf.frames++;
+
+    if (perf.csv) {
+        fprintf(perf.csv, "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%.3f,%.3f\n",
+                (now - perf.startNs) / 1e6, frameMs,
+                perf.phaseMs[PERF_EVENTS], perf.phaseMs[PERF_UPDATE],
+                perf.phaseMs[PERF_RENDER], perf.phaseMs[PERF_PRESENT],
+                perf.draws, info->textures, info->rttUs < 0 ? -1.0 : info->rttUs / 1000.0,
+                since_server_ms(info, now));
+    }
+}
+
+/**
+ * @brief Draw the overlay in the top-right corner (numbers of the last frame)
+ *
+ * Lines are rasterized directly: they change every frame and would only
+ * churn the text cache.
+ */
+void perf_overlay_draw(SDL_Renderer *renderer, TTF_Font *font) {
+    if (!perf.visible || !font) return;
+
+    char lines[4][96];
+    snprintf(lines[0], sizeof(lines[0]), "frame %.2f ms  avg %.2f  max %.2f",
+             perf.lastFrameMs, perf.avgFrameMs, perf.maxFrameMs);
+    snprintf(lines[1], sizeof(lines[1]), "events %.2f  update %.2f  render %.2f  present %.2f",
+             perf.lastPhaseMs[PERF_EVENTS], perf.lastPhaseMs[PERF_UPDATE],
+             perf.lastPhaseMs[PERF_RENDER], perf.lastPhaseMs[PERF_PRESENT]);
+    snprintf(lines[2], sizeof(lines[2]), "draws %d  textures %d", perf.lastDraws, perf.info.textures);
+    double since = since_server_ms(&perf.info, perf_now_ns());
+    char rtt[32], server[32];
+    if (perf.info.rttUs < 0) snprintf(rtt, sizeof(rtt), "-");
+    else snprintf(rtt, sizeof(rtt), "%.2f ms", perf.info.rttUs / 1000.0);
+    if (since < 0) snprintf(server, sizeof(server), "-");
+    else snprintf(server, sizeof(server), "%.0f ms ago", since);
+    snprintf(lines[3], sizeof(lines[3]), "server %s  rtt %s", server, rtt);
+
+    SDL_Rect box = {WINDOW_WIDTH - 560, 0, 560, 4 * 22 + 10};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &box);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    perf_count_draws(1);
+
+    SDL_Color white = {255, 255, 255, 255};
+    for (int i = 0; i < 4; i++) {
+        SDL_Surface *surf = TTF_RenderUTF8_Blended(font, lines[i], white);
+        if (!surf) continue;
+        SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surf);
+        if (tex) {
+            SDL_Rect dst = {box.x + 8, box.y + 5 + i * 22, surf->w, surf->h};
+            SDL_RenderCopy(renderer, tex, NULL, &dst);
+            SDL_DestroyTexture(tex);
+            perf_count_draws(1);
+        }
+        SDL_FreeSurface(surf);
+    }
+}
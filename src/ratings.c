@@ -0,0 +1,472 @@
+// ratings.c
+#include "../include/ratings.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RATINGS_MAGIC "SH13RAT1"
+#define HASH_INITIAL 1024
+
+// One log record: a player's profile after a change (the last one wins)
+typedef struct {
+    char name[32];
+    double rating;
+    int32_t games;
+    int32_t wins;
+    int64_t time;
+} __attribute__((packed)) RatingRecord;
+
+typedef struct Profile {
+    char name[32];
+    double rating;
+    int games, wins;
+    uint32_t priority;          // Treap heap key, random
+    int size;                   // Profiles in this subtree
+    struct Profile *left, *right;
+} Profile;
+
+typedef struct GameResult {
+    char names[MAX_PLAYERS][32];
+    int nbPlayers;
+    int winner;
+    struct GameResult *next;
+} GameResult;
+
+static struct {
+    int fd;
+    pthread_rwlock_t lock;      // Index: hash table and treap
+    Profile **table;
+    size_t tableSize;
+    int count;
+    Profile *root;
+    uint32_t rng;
+
+    pthread_mutex_t queueLock;
+    pthread_cond_t queueCond;
+    GameResult *head, *tail;
+    int depth;
+    int stop;
+    int running;
+    pthread_t thread;
+
+    long games, dropped, records;
+} ratings = {
+    .fd = -1,
+    .lock = PTHREAD_RWLOCK_INITIALIZER,
+    .queueLock = PTHREAD_MUTEX_INITIALIZER,
+    .queueCond = PTHREAD_COND_INITIALIZER,
+    .rng = 2463534242u,
+};
+
+/* --- Order-statistic treap: best rating first, then by name --- */
+
+static int ranks_before(const Profile *a, const Profile *b) {
+    if (a->rating != b->rating) return a->rating > b->rating;
+    return strcmp(a->name, b->name) < 0;
+}
+
+static int size_of(const Profile *t) {
+    return t ? t->size : 0;
+}
+
+static void update_size(Profile *t) {
+    t->size = 1 + size_of(t->left) + size_of(t->right);
+}
+
+static Profile *merge(Profile *a, Profile *b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->priority > b->priority) {
+        a->right = merge(a->right, b);
+        update_size(a);
+        return a;
+    }
+    b->left = merge(a, b->left);
+    update_size(b);
+    return b;
+}
+
+// Left: profiles ranking before `key`, right: the others
+static void split(Profile *t, const Profile *key, Profile **left, Profile **right) {
+    if (!t) {
+        *left = *right = NULL;
+        return;
+    }
+    if (ranks_before(t, key)) {
+        split(t->right, key, &t->right, right);
+        *left = t;
+    } else {
+        split(t->left, key, left, &t->left);
+        *right = t;
+    }
+    update_size(t);
+}
+
+static void treap_insert(Profile *p) {
+    Profile *left, *right;
+    p->left = p->right = NULL;
+    p->size = 1;
+    split(ratings.root, p, &left, &right);
+    ratings.root = merge(merge(left, p), right);
+}
+
+static Profile *erase(Profile *t, const Profile *p) {
+    if (!t) return NULL;
+    if (t == p) return merge(t->left, t->right);
+    if (ranks_before(p, t)) t->left = erase(t->left, p);
+    else t->right = erase(t->right, p);
+    update_size(t);
+    return t;
+}
+
+// 0-based rank of a profile in the tree
+static int rank_of(const Profile *p) {
+    int rank = 0;
+    for (const Profile *t = ratings.root; t;) {
+        if (t == p) return rank + size_of(t->left);
+        if (ranks_before(p, t)) {
+            t = t->left;
+        } else {
+            rank += size_of(t->left) + 1;
+            t = t->right;
+        }
+    }
+    return -1;
+}
+
+static const Profile *select_rank(int k) {
+    const Profile *t = ratings.root;
+    while (t) {
+        int left = size_of(t->left);
+        if (k < left) {
+            t = t->left;
+        } else if (k == left) {
+            return t;
+        } else {
+            k -= left + 1;
+            t = t->right;
+        }
+    }
+    return NULL;
+}
+
+/* --- Name index --- */
+
+static uint64_t hash_name(const char *name) {
+    uint64_t h = 1469598103934665603ull;
+    for (; *name; name++) h = (h ^ (uint8_t)*name) * 1099511628211ull;
+    return h;
+}
+
+static Profile **find_slot(Profile **table, size_t size, const char *name) {
+    size_t i = hash_name(name) & (size - 1);
+    while (table[i] && strcmp(table[i]->name, name) != 0) i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static int grow_table(void) {
+    size_t size = ratings.tableSize ? ratings.tableSize * 2 : HASH_INITIAL;
+    Profile **table = calloc(size, sizeof(Profile *));
+    if (!table) return -1;
+    for (size_t i = 0; i < ratings.tableSize; i++) {
+        if (ratings.table[i]) *find_slot(table, size, ratings.table[i]->name) = ratings.table[i];
+    }
+    free(ratings.table);
+    ratings.table = table;
+    ratings.tableSize = size;
+    return 0;
+}
+
+static Profile *find_profile(const char *name) {
+    if (!ratings.table) return NULL;
+    return *find_slot(ratings.table, ratings.tableSize, name);
+}
+
+// Profile of a name, created at the initial rating (writer side, lock held)
+static Profile *get_profile(const char *name) {
+    Profile *p = find_profile(name);
+    if (p) return p;
+    if ((size_t)(ratings.count + 1) * 2 > ratings.tableSize && grow_table() < 0) return NULL;
+    p = calloc(1, sizeof(Profile));
+    if (!p) return NULL;
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->rating = RATING_INITIAL;
+    ratings.rng ^= ratings.rng << 13;
+    ratings.rng ^= ratings.rng >> 17;
+    ratings.rng ^= ratings.rng << 5;
+    p->priority = ratings.rng;
+    *find_slot(ratings.table, ratings.tableSize, p->name) = p;
+    ratings.count++;
+    treap_insert(p);
+    return p;
+}
+
+// Move a profile to its new place in the ranking
+static void set_profile(Profile *p, double rating, int games, int wins) {
+    ratings.root = erase(ratings.root, p);
+    p->rating = rating;
+    p->games = games;
+    p->wins = wins;
+    treap_insert(p);
+}
+
+/* --- Log --- */
+
+/**
+ * @brief Replay the log into the index; a torn last record is cut off
+ */
+static int replay_log(int fd) {
+    char magic[8];
+    ssize_t n = read(fd, magic, sizeof(magic));
+    if (n == 0) return write(fd, RATINGS_MAGIC, 8) == 8 ? 0 : -1;
+    if (n != 8 || memcmp(magic, RATINGS_MAGIC, 8) != 0) {
+        fprintf(stderr, "[Ratings] Not a ratings log\n");
+        return -1;
+    }
+
+    RatingRecord batch[256];
+    off_t good = 8;
+    for (;;) {
+        n = read(fd, batch, sizeof(batch));
+        if (n <= 0) break;
+        int full = n / sizeof(RatingRecord);
+        for (int i = 0; i < full; i++) {
+            batch[i].name[sizeof(batch[i].name) - 1] = '\0';
+            Profile *p = get_profile(batch[i].name);
+            if (p) set_profile(p, batch[i].rating, batch[i].games, batch[i].wins);
+        }
+        good += (off_t)full * sizeof(RatingRecord);
+        ratings.records += full;
+        if (n % sizeof(RatingRecord)) break;
+    }
+    if (ftruncate(fd, good) < 0) return -1;
+    return 0;
+}
+
+/* --- Writer thread --- */
+
+/**
+ * @brief Elo for a table: the winner beat every other player, each pair
+ * weighted 1/(n-1) so a game moves ratings as much as a duel does
+ *
+ * @return Records to append
+ */
+static int apply_result(const GameResult *r, RatingRecord *out) {
+    Profile *players[MAX_PLAYERS];
+    double before[MAX_PLAYERS], delta[MAX_PLAYERS] = {0};
+    int n = r->nbPlayers;
+    for (int i = 0; i < n; i++) {
+        players[i] = get_profile(r->names[i]);
+        if (!players[i]) return 0;
+        before[i] = players[i]->rating;
+    }
+    if (r->winner >= 0) {
+        double k = RATING_K / (n - 1);
+        for (int i = 0; i < n; i++) {
+            if (i == r->winner) continue;
+            double expected = 1.0 / (1.0 + pow(10.0, (before[i] - before[r->winner]) / 400.0));
+            delta[r->winner] += k * (1.0 - expected);
+            delta[i] -= k * (1.0 - expected);
+        }
+    }
+    int64_t now = time(NULL);
+    for (int i = 0; i < n; i++) {
+        Profile *p = players[i];
+        set_profile(p, before[i] + delta[i], p->games + 1, p->wins + (i == r->winner));
+        RatingRecord *rec = &out[i];
+        memset(rec, 0, sizeof(*rec));
+        memcpy(rec->name, p->name, sizeof(rec->name));
+        rec->rating = p->rating;
+        rec->games = p->games;
+        rec->wins = p->wins;
+        rec->time = now;
+    }
+    return n;
+}
+
+static void *ratings_writer(void *arg) {
+    (void)arg;
+    RatingRecord *records = malloc(sizeof(RatingRecord) * MAX_PLAYERS * 64);
+    for (;;) {
+        pthread_mutex_lock(&ratings.queueLock);
+        while (!ratings.head && !ratings.stop) pthread_cond_wait(&ratings.queueCond, &ratings.queueLock);
+        GameResult *batch = ratings.head;
+        ratings.head = ratings.tail = NULL;
+        ratings.depth = 0;
+        int stop = ratings.stop;
+        pthread_mutex_unlock(&ratings.queueLock);
+        if (!batch && stop) break;
+
+        // Up to 64 games per lock hold and per write()
+        while (batch) {
+            int nrec = 0;
+            pthread_rwlock_wrlock(&ratings.lock);
+            for (int g = 0; g < 64 && batch; g++) {
+                GameResult *r = batch;
+                batch = r->next;
+                if (records) nrec += apply_result(r, records + nrec);
+                ratings.games++;
+                free(r);
+            }
+            pthread_rwlock_unlock(&ratings.lock);
+
+            size_t len = nrec * sizeof(RatingRecord);
+            if (ratings.fd >= 0 && len && write(ratings.fd, records, len) != (ssize_t)len) {
+                perror("[Ratings] Log write");
+            }
+            ratings.records += nrec;
+        }
+    }
+    free(records);
+    return NULL;
+}
+
+/* --- API --- */
+
+/**
+ * @brief Load the log (created if missing) and start the writer thread
+ *
+ * @param path Log file; NULL or empty keeps ratings in memory only
+ */
+int ratings_open(const char *path) {
+    if (path && *path) {
+        ratings.fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (ratings.fd < 0) {
+            perror(path);
+            return -1;
+        }
+        pthread_rwlock_wrlock(&ratings.lock);
+        int rc = replay_log(ratings.fd);
+        pthread_rwlock_unlock(&ratings.lock);
+        if (rc < 0) {
+            close(ratings.fd);
+            ratings.fd = -1;
+            return -1;
+        }
+    }
+    if (pthread_create(&ratings.thread, NULL, ratings_writer, NULL) != 0) return -1;
+    ratings.running = 1;
+    atexit(ratings_close);
+    printf("[Ratings] %d players, %ld log records (%s)\n", ratings.count, ratings.records,
+           path && *path ? path : "memory only");
+    return 0;
+}
+
+/**
+ * @brief Write out the queued results and stop the writer
+ */
+void ratings_close(void) {
+    if (!ratings.running) return;
+    pthread_mutex_lock(&ratings.queueLock);
+    ratings.stop = 1;
+    pthread_cond_signal(&ratings.queueCond);
+    pthread_mutex_unlock(&ratings.queueLock);
+    pthread_join(ratings.thread, NULL);
+    ratings.running = 0;
+    if (ratings.fd >= 0) fsync(ratings.fd);
+}
+
+/**
+ * @brief Queue a finished game (winner: seat index, -1 for no winner)
+ *
+ * Called with the game lock held: only copies the names and signals.
+ */
+void ratings_game_over(const char (*names)[32], int nbPlayers, int winner) {
+    if (!ratings.running || nbPlayers < 2 || nbPlayers > MAX_PLAYERS) return;
+    GameResult *r = malloc(sizeof(GameResult));
+    if (!r) return;
+    for (int i = 0; i < nbPlayers; i++) {
+        memcpy(r->names[i], names[i], 32);
+        r->names[i][31] = '\0';
+    }
+    r->nbPlayers = nbPlayers;
+    r->winner = winner;
+    r->next = NULL;
+
+    pthread_mutex_lock(&ratings.queueLock);
+    if (ratings.depth >= RATINGS_QUEUE_MAX) {
+        ratings.dropped++;
+        pthread_mutex_unlock(&ratings.queueLock);
+        free(r);
+        return;
+    }
+    if (ratings.tail) ratings.tail->next = r;
+    else ratings.head = r;
+    ratings.tail = r;
+    ratings.depth++;
+    pthread_cond_signal(&ratings.queueCond);
+    pthread_mutex_unlock(&ratings.queueLock);
+}
+
+static void fill_entry(const Profile *p, int rank, Rank_Entry *e) {
+    memset(e, 0, sizeof(*e));
+    e->rank = rank + 1;
+    memcpy(e->name, p->name, sizeof(e->name));
+    e->rating = (int32_t)lround(p->rating);
+    e->games = p->games;
+    e->wins = p->wins;
+}
+
+/**
+ * @brief Rank and rating of a player
+ *
+ * @return 1 if the player is rated, 0 otherwise
+ */
+int ratings_lookup(const char *name, Rank_Entry *out) {
+    pthread_rwlock_rdlock(&ratings.lock);
+    const Profile *p = find_profile(name);
+    if (p) fill_entry(p, rank_of(p), out);
+    pthread_rwlock_unlock(&ratings.lock);
+    return p != NULL;
+}
+
+/**
+ * @brief Leaderboard entries from 0-based rank `first`
+ *
+ * @return Entries written
+ */
+int ratings_page(int first, int count, Rank_Entry *out) {
+    int n = 0;
+    pthread_rwlock_rdlock(&ratings.lock);
+    for (; n < count && first + n < ratings.count; n++) fill_entry(select_rank(first + n), first + n, &out[n]);
+    pthread_rwlock_unlock(&ratings.lock);
+    return n;
+}
+
+int ratings_count(void) {
+    pthread_rwlock_rdlock(&ratings.lock);
+    int n = ratings.count;
+    pthread_rwlock_unlock(&ratings.lock);
+    return n;
+}
+
+/**
+ * @brief Answer a MSG_RANK_QUERY
+ */
+void ratings_query(const Payload_Rank_Query *q, Payload_Rank_Reply *reply) {
+    memset(reply, 0, sizeof(*reply));
+    char name[32];
+    memcpy(name, q->name, sizeof(name));
+    name[sizeof(name) - 1] = '\0';
+
+    if (name[0]) {
+        reply->count = ratings_lookup(name, &reply->entries[0]);
+    } else {
+        int count = q->count < 1 || q->count > RANK_PAGE ? RANK_PAGE : q->count;
+        reply->count = q->first < 0 ? 0 : ratings_page(q->first, count, reply->entries);
+    }
+    reply->total = ratings_count();
+}
+
+void ratings_stats_print(FILE *out) {
+    pthread_mutex_lock(&ratings.queueLock);
+    int pending = ratings.depth;
+    pthread_mutex_unlock(&ratings.queueLock);
+    fprintf(out, "[Ratings] players=%d games=%ld records=%ld pending=%d dropped=%ld\n",
+            ratings_count(), ratings.games, ratings.records, pending, ratings.dropped);
+}
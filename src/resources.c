@@ -1,13 +1,92 @@
-
 #include "resources.h"
+#include "perf_overlay.h"
 #include <SDL_image.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+SDL_Texture* atlas;
+
+// Atlas layout: cards in rows of ATLAS_CARDS_PER_ROW, icons in a row below
+#define ATLAS_CARD_ROWS ((ATLAS_CARDS + ATLAS_CARDS_PER_ROW - 1) / ATLAS_CARDS_PER_ROW)
+#define ATLAS_ICON_SIZE 120
+#define ATLAS_WIDTH (ATLAS_CARDS_PER_ROW * ATLAS_CARD_W)
+#define ATLAS_HEIGHT (ATLAS_CARD_ROWS * ATLAS_CARD_H + ATLAS_ICON_SIZE)
+
+#define ASSET_COUNT (ATLAS_ICONS + ATLAS_CARDS)
+
+// Decode progress of one image; only the render thread moves it to ASSET_DONE
+enum { ASSET_PENDING, ASSET_DECODED, ASSET_MISSING, ASSET_DONE };
+
+typedef struct {
+    char path[64];
+    SDL_Rect slot;              // Where it goes in the atlas
+    SDL_Rect *region;           // Set to slot once uploaded
+    SDL_Surface *pixels;        // Decoded at slot size, RGBA32
+    atomic_int state;
+    uint64_t decodeNs;
+} AssetJob;
+
+static SDL_Rect iconRegions[ATLAS_ICONS];   // w == 0: image not (yet) available
+static SDL_Rect cardRegions[ATLAS_CARDS];
+
+static AssetJob jobs[ASSET_COUNT];
+static atomic_int nextJob;
+static int handledJobs;                     // Render thread only
+static pthread_t workers[ASSET_WORKERS_MAX];
+static int workerCount;
+static uint64_t startNs;
+static void (*notifyDecoded)(void);
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Decode one PNG and scale it to its atlas slot (worker thread)
+ */
+static void decode_job(AssetJob *job) {
+    uint64_t t0 = now_ns();
+    SDL_Surface* temp = IMG_Load(job->path);
+    SDL_Surface *pixels = NULL;
+    if (temp) {
+        pixels = SDL_CreateRGBSurfaceWithFormat(0, job->slot.w, job->slot.h, 32, SDL_PIXELFORMAT_RGBA32);
+        SDL_SetSurfaceBlendMode(temp, SDL_BLENDMODE_NONE); // Copy alpha as is
+        if (pixels && SDL_BlitScaled(temp, NULL, pixels, NULL) != 0) {
+            SDL_FreeSurface(pixels);
+            pixels = NULL;
+        }
+        SDL_FreeSurface(temp);
+    }
+    job->pixels = pixels;
+    job->decodeNs = now_ns() - t0;
+    atomic_store_explicit(&job->state, pixels ? ASSET_DECODED : ASSET_MISSING, memory_order_release);
+}
 
-SDL_Texture* icons[8];
-SDL_Texture* cards[13];
+static void *decode_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        int i = atomic_fetch_add(&nextJob, 1);
+        if (i >= ASSET_COUNT) break;
+        decode_job(&jobs[i]);
+        if (notifyDecoded) notifyDecoded();
+    }
+    return NULL;
+}
 
-void load_icons(SDL_Renderer* renderer) {
-    const char* iconFiles[8] = {
+/**
+ * @brief Start decoding every card and icon in the background
+ *
+ * Needs no renderer, so it can run while the window is being created.
+ *
+ * @param onDecoded Called from a worker after each image (may be NULL)
+ */
+void assets_start(void (*onDecoded)(void)) {
+    const char* iconFiles[ATLAS_ICONS] = {
         "img/SH13_pipe_120x120.png",
         "img/SH13_ampoule_120x120.png",
         "img/SH13_poing_120x120.png",
@@ -18,49 +97,171 @@ void load_icons(SDL_Renderer* renderer) {
         "img/SH13_crane_120x120.png"
     };
 
-    for (int i = 0; i < 8; ++i) {
-        SDL_Surface* temp = IMG_Load(iconFiles[i]);
-        if (!temp) {
-            fprintf(stderr, "Erreur de chargement (icon): %s\n", iconFiles[i]);
-            icons[i] = NULL;
-            continue;
-        }
-        icons[i] = SDL_CreateTextureFromSurface(renderer, temp);
-        SDL_FreeSurface(temp);
+    // Cards first: they are the largest decodes
+    for (int i = 0; i < ATLAS_CARDS; ++i) {
+        AssetJob *job = &jobs[i];
+        snprintf(job->path, sizeof(job->path), "img/SH13_%d.png", i);
+        job->slot = (SDL_Rect){(i % ATLAS_CARDS_PER_ROW) * ATLAS_CARD_W, (i / ATLAS_CARDS_PER_ROW) * ATLAS_CARD_H,
+                               ATLAS_CARD_W, ATLAS_CARD_H};
+        job->region = &cardRegions[i];
+    }
+    for (int i = 0; i < ATLAS_ICONS; ++i) {
+        AssetJob *job = &jobs[ATLAS_CARDS + i];
+        snprintf(job->path, sizeof(job->path), "%s", iconFiles[i]);
+        job->slot = (SDL_Rect){i * ATLAS_ICON_SIZE, ATLAS_CARD_ROWS * ATLAS_CARD_H, ATLAS_ICON_SIZE, ATLAS_ICON_SIZE};
+        job->region = &iconRegions[i];
+    }
+    for (int i = 0; i < ASSET_COUNT; ++i) {
+        jobs[i].pixels = NULL;
+        atomic_init(&jobs[i].state, ASSET_PENDING);
     }
+    atomic_store(&nextJob, 0);
+    handledJobs = 0;
+    notifyDecoded = onDecoded;
+    startNs = now_ns();
+
+    int cpus = SDL_GetCPUCount();
+    int wanted = cpus < 1 ? 1 : (cpus > ASSET_WORKERS_MAX ? ASSET_WORKERS_MAX : cpus);
+    for (workerCount = 0; workerCount < wanted; workerCount++) {
+        if (pthread_create(&workers[workerCount], NULL, decode_worker, NULL) != 0) break;
+    }
+    if (workerCount == 0) decode_worker(NULL); // No thread available: decode inline
 }
 
-void load_cards(SDL_Renderer* renderer) {
-    for (int i = 0; i < 13; ++i) {
-        char path[64];
-        snprintf(path, sizeof(path), "img/SH13_%d.png", i);
-        SDL_Surface* temp = IMG_Load(path);
-        if (!temp) {
-            fprintf(stderr, "Erreur de chargement (carte): %s\n", path);
-            cards[i] = NULL;
+/**
+ * @brief Upload the images decoded since the last call (render thread)
+ *
+ * Never waits for a decoder. Missing files are reported here, once.
+ *
+ * @return Number of images that became available or were found missing
+ */
+int assets_upload(SDL_Renderer* renderer) {
+    if (handledJobs == ASSET_COUNT) return 0;
+    if (!atlas) {
+        atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, ATLAS_HEIGHT);
+        if (!atlas) {
+            fprintf(stderr, "Erreur de création de l'atlas: %s\n", SDL_GetError());
+            return 0;
+        }
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    }
+
+    int changed = 0;
+    for (int i = 0; i < ASSET_COUNT; ++i) {
+        AssetJob *job = &jobs[i];
+        int state = atomic_load_explicit(&job->state, memory_order_acquire);
+        if (state == ASSET_DECODED) {
+            if (SDL_UpdateTexture(atlas, &job->slot, job->pixels->pixels, job->pixels->pitch) == 0) {
+                *job->region = job->slot;
+            } else {
+                fprintf(stderr, "Erreur d'envoi de l'image: %s\n", job->path);
+            }
+            SDL_FreeSurface(job->pixels);
+            job->pixels = NULL;
+        } else if (state == ASSET_MISSING) {
+            fprintf(stderr, "Erreur de chargement: %s\n", job->path);
+        } else {
             continue;
         }
-        cards[i] = SDL_CreateTextureFromSurface(renderer, temp);
-        SDL_FreeSurface(temp);
+        atomic_store_explicit(&job->state, ASSET_DONE, memory_order_relaxed);
+        handledJobs++;
+        changed++;
     }
+
+    if (handledJobs == ASSET_COUNT) {
+        uint64_t decodeNs = 0;
+        int loaded = 0;
+        for (int i = 0; i < ASSET_COUNT; ++i) {
+            decodeNs += jobs[i].decodeNs;
+            if (jobs[i].region->w) loaded++;
+        }
+        printf("[Client] Assets: %d/%d loaded in %.1f ms on %d workers (%.1f ms of decoding)\n",
+               loaded, ASSET_COUNT, (now_ns() - startNs) / 1e6, workerCount, decodeNs / 1e6);
+    }
+    return changed;
 }
 
-void load_all_textures(SDL_Renderer* renderer) {
-    load_icons(renderer);
-    load_cards(renderer);
+/**
+ * @brief Number of images not yet uploaded or reported missing
+ */
+int assets_pending(void) {
+    return ASSET_COUNT - handledJobs;
 }
 
+/**
+ * @brief Release the atlas, after the decoders still running have finished
+ */
 void unload_textures() {
-    for (int i = 0; i < 8; ++i) {
-        if (icons[i]) {
-            SDL_DestroyTexture(icons[i]);
-            icons[i] = NULL;
+    for (int i = 0; i < workerCount; ++i) pthread_join(workers[i], NULL);
+    workerCount = 0;
+    for (int i = 0; i < ASSET_COUNT; ++i) {
+        if (jobs[i].pixels) {
+            SDL_FreeSurface(jobs[i].pixels);
+            jobs[i].pixels = NULL;
         }
     }
-    for (int i = 0; i < 13; ++i) {
-        if (cards[i]) {
-            SDL_DestroyTexture(cards[i]);
-            cards[i] = NULL;
-        }
+    if (atlas) {
+        SDL_DestroyTexture(atlas);
+        atlas = NULL;
+    }
+    for (int i = 0; i < ATLAS_ICONS; ++i) iconRegions[i].w = 0;
+    for (int i = 0; i < ATLAS_CARDS; ++i) cardRegions[i].w = 0;
+}
+
+/**
+ * @brief Atlas region of an object icon, NULL if it is not available
+ */
+const SDL_Rect *atlas_icon(int i) {
+    if (!atlas || i < 0 || i >= ATLAS_ICONS || iconRegions[i].w == 0) return NULL;
+    return &iconRegions[i];
+}
+
+/**
+ * @brief Atlas region of a card image, NULL if it is not available
+ */
+const SDL_Rect *atlas_card(int i) {
+    if (!atlas || i < 0 || i >= ATLAS_CARDS || cardRegions[i].w == 0) return NULL;
+    return &cardRegions[i];
+}
+
+/**
+ * @brief Queue one atlas region drawn at dst
+ *
+ * Nothing reaches the renderer until the batch is flushed (or full), so
+ * anything that must appear above or below the sprites is ordered by
+ * flushing at the right time.
+ */
+void sprite_batch_add(SpriteBatch *batch, SDL_Renderer *renderer, const SDL_Rect *src, const SDL_Rect *dst) {
+    if (!src || !dst) return;
+    if (batch->count == SPRITE_BATCH_MAX) sprite_batch_flush(batch, renderer);
+
+    float u0 = (float)src->x / ATLAS_WIDTH, u1 = (float)(src->x + src->w) / ATLAS_WIDTH;
+    float v0 = (float)src->y / ATLAS_HEIGHT, v1 = (float)(src->y + src->h) / ATLAS_HEIGHT;
+    float x0 = dst->x, x1 = dst->x + dst->w;
+    float y0 = dst->y, y1 = dst->y + dst->h;
+    SDL_Color white = {255, 255, 255, 255};
+
+    int base = batch->count * 4;
+    SDL_Vertex *v = &batch->vertices[base];
+    v[0] = (SDL_Vertex){ {x0, y0}, white, {u0, v0} };
+    v[1] = (SDL_Vertex){ {x1, y0}, white, {u1, v0} };
+    v[2] = (SDL_Vertex){ {x1, y1}, white, {u1, v1} };
+    v[3] = (SDL_Vertex){ {x0, y1}, white, {u0, v1} };
+
+    int *idx = &batch->indices[batch->count * 6];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+    batch->count++;
+}
+
+/**
+ * @brief Draw every queued quad in a single call
+ */
+void sprite_batch_flush(SpriteBatch *batch, SDL_Renderer *renderer) {
+    if (batch->count == 0) return;
+    if (atlas) {
+        SDL_RenderGeometry(renderer, atlas, batch->vertices, batch->count * 4, batch->indices, batch->count * 6);
+        perf_count_draws(1);
     }
+    batch->count = 0;
 }
@@ -0,0 +1,492 @@
+// rooms.c
+#include "../include/rooms.h"
+#include "../include/connection.h"
+#include "../include/rules.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <time.h>
+
+#define ROOM_CLAIMED -1     // connRoom value while a worker is seating the connection
+
+Room rooms[MAX_ROOMS];
+int nbRooms = 0;
+
+// Directory entry of each room: players | seats << 8 | state << 16
+static atomic_uint directory[MAX_ROOMS];
+static atomic_ullong dirtyRooms;                // Rooms changed since the last delta, one bit each
+static atomic_ullong resumingRooms;             // Migrated rooms awaiting their players, one bit each
+
+// Connection -> room: 0 none, ROOM_CLAIMED while seating, id + 1 once seated
+static atomic_int connRoom[CONN_MAX_FD];
+static atomic_int connPreferred[CONN_MAX_FD];   // MSG_JOIN_ROOM choice, id + 1 (0 = any)
+
+// Lobby subscribers, one bit per fd
+static atomic_ullong subscribers[CONN_MAX_FD / 64];
+
+// Delta publisher
+static pthread_mutex_t publishLock = PTHREAD_MUTEX_INITIALIZER;  // Held for a whole round
+static atomic_int publishPaused;
+static int publishIntervalMs = ROOM_DELTA_INTERVAL_MS;
+static uint32_t publishSeq;
+
+static struct {
+    atomic_int subscribed;
+    atomic_ulong pages;
+    atomic_ulong deltas;
+    atomic_ulong deltaFrames;
+    atomic_ulong deltaDrops;
+} dirStats;
+
+static int room_state(const Room *r) {
+    if (r->finished) return ROOM_FINISHED;
+    return r->gameStarted ? ROOM_PLAYING : ROOM_WAITING;
+}
+
+static void unpack_entry(int id, Room_Info *info) {
+    unsigned e = atomic_load_explicit(&directory[id], memory_order_acquire);
+    info->id = id;
+    info->players = e & 0xff;
+    info->seats = (e >> 8) & 0xff;
+    info->state = (e >> 16) & 0xff;
+}
+
+/**
+ * @brief Mirror a room in the directory and queue it for the next delta
+ *
+ * Caller holds r->lock (or owns the room, at startup).
+ */
+void room_publish(Room *r) {
+    unsigned players = 0;
+    for (int i = 0; i < r->nbClients; i++) players += r->clientSockets[i] >= 0;
+    unsigned e = players | (unsigned)r->nbPlayers << 8 | (unsigned)room_state(r) << 16;
+    if (atomic_exchange_explicit(&directory[r->id], e, memory_order_release) != e) {
+        atomic_fetch_or(&dirtyRooms, 1ULL << r->id);
+    }
+}
+
+/**
+ * @brief Empty a room for a new table; caller holds r->lock
+ */
+void room_reset(Room *r) {
+    r->nbClients = 0;
+    r->nbPlayers = activeRules.nbPlayers;
+    r->gameStarted = 0;
+    r->finished = 0;
+    memset(r->tcpClients, 0, sizeof(r->tcpClients));
+    for (int i = 0; i < MAX_CLIENTS; i++) r->clientSockets[i] = -1;
+    memset(r->chatBucket, 0, sizeof(r->chatBucket));
+    r->chatSeq = 0;
+    memset(r->resumeToken, 0, sizeof(r->resumeToken));
+    r->resumeUntilNs = 0;
+    atomic_fetch_and(&resumingRooms, ~(1ULL << r->id));
+    r->game.rules = &activeRules;
+    room_publish(r);
+}
+
+/**
+ * @brief Create the rooms, each with its own generator, all under the active rules
+ */
+void rooms_init(int count) {
+    if (count < 1) count = 1;
+    if (count > MAX_ROOMS) count = MAX_ROOMS;
+    nbRooms = count;
+    uint64_t seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+    for (int i = 0; i < nbRooms; i++) {
+        Room *r = &rooms[i];
+        r->id = i;
+        pthread_mutex_init(&r->lock, NULL);
+        game_init(&r->game, &activeRules, seed ^ (0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1)));
+        room_reset(r);
+        game_deal(&r->game);
+    }
+}
+
+/**
+ * @brief Room a connection is seated in, or NULL
+ */
+Room *room_of(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return NULL;
+    int v = atomic_load(&connRoom[fd]);
+    return v > 0 ? &rooms[v - 1] : NULL;
+}
+
+static int room_has_seat(const Room *r) {
+    return r->nbClients < r->nbPlayers && !r->gameStarted && !r->finished && !room_resuming(r);
+}
+
+// Fullest waiting room with a free seat, read from the directory: tables fill one at a time
+static int pick_waiting_room(void) {
+    int best = -1, bestPlayers = -1;
+    for (int i = 0; i < nbRooms; i++) {
+        Room_Info info;
+        unpack_entry(i, &info);
+        if (info.state == ROOM_WAITING && info.players < info.seats && info.players > bestPlayers) {
+            best = i;
+            bestPlayers = info.players;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Claim a connection for seating and lock a room with a free seat
+ *
+ * The room chosen with MSG_JOIN_ROOM is the only one tried; otherwise the
+ * fullest waiting room is, again if it filled up in the meantime.
+ * On success the caller seats the player, calls room_bind() and unlocks.
+ *
+ * @return The locked room, or NULL if the connection is already seated
+ *         (or being seated) or no seat is free
+ */
+Room *room_enter(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return NULL;
+    int none = 0;
+    if (!atomic_compare_exchange_strong(&connRoom[fd], &none, ROOM_CLAIMED)) return NULL;
+
+    int wanted = atomic_load(&connPreferred[fd]) - 1;
+    for (int attempt = 0; attempt < nbRooms; attempt++) {
+        int id = wanted >= 0 ? wanted : pick_waiting_room();
+        if (id < 0) break;
+        Room *r = &rooms[id];
+        pthread_mutex_lock(&r->lock);
+        if (room_has_seat(r)) return r;
+        pthread_mutex_unlock(&r->lock);
+        if (wanted >= 0) break;
+    }
+    int claimed = ROOM_CLAIMED;
+    atomic_compare_exchange_strong(&connRoom[fd], &claimed, 0);
+    return NULL;
+}
+
+/**
+ * @brief Turn a room_enter() claim into a seat; caller holds r->lock
+ *
+ * @return 0, or -1 if the connection closed meanwhile (do not seat it)
+ */
+int room_bind(int fd, Room *r) {
+    int claimed = ROOM_CLAIMED;
+    return atomic_compare_exchange_strong(&connRoom[fd], &claimed, r->id + 1) ? 0 : -1;
+}
+
+/**
+ * @brief Record a seat restored by a hot upgrade
+ */
+void room_attach(int fd, Room *r) {
+    if (fd >= 0 && fd < CONN_MAX_FD) atomic_store(&connRoom[fd], r->id + 1);
+}
+
+/**
+ * @brief Remember the room (or ROOM_ANY) a connection's MSG_CONNECT goes to
+ */
+void room_prefer(int fd, int roomId) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return;
+    if (roomId < 0 || roomId >= nbRooms) roomId = ROOM_ANY;
+    atomic_store(&connPreferred[fd], roomId + 1);
+}
+
+/**
+ * @brief Forget a closed connection (reactor thread)
+ *
+ * Its seat is marked empty; in a waiting room the others are told
+ * (MSG_PLAYER_LIST with no name), the seat goes to the next player and
+ * trailing empty seats are freed. A room whose players all left is reset.
+ */
+void room_disconnect(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return;
+    directory_subscribe(fd, 0);
+    atomic_store(&connPreferred[fd], 0);
+    int v = atomic_exchange(&connRoom[fd], 0);
+    if (v <= 0) return;
+
+    Room *r = &rooms[v - 1];
+    pthread_mutex_lock(&r->lock);
+    int live = 0, seat = -1;
+    for (int i = 0; i < r->nbClients; i++) {
+        if (r->clientSockets[i] == fd) {
+            r->clientSockets[i] = -1;
+            seat = i;
+        }
+        if (r->clientSockets[i] >= 0) live++;
+    }
+    if (room_resuming(r)) {
+        // Migrated table: the seats still on their way keep it
+    } else if (live == 0) {
+        printf("[Rooms] Room %d is empty again.\n", r->id);
+        room_reset(r);
+    } else if (!r->gameStarted && !r->finished) {
+        if (seat >= 0) {
+            Payload_Player_List gone = { .id = seat };
+            memset(&r->tcpClients[seat], 0, sizeof(r->tcpClients[seat]));
+            for (int i = 0; i < r->nbClients; i++) {
+                if (r->clientSockets[i] >= 0) conn_send_packet(r->clientSockets[i], MSG_PLAYER_LIST, &gone, sizeof(gone), SEND_GAME);
+            }
+        }
+        while (r->nbClients > 0 && r->clientSockets[r->nbClients - 1] < 0) r->nbClients--;
+        room_publish(r);
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+/* --- Migration --- */
+
+/**
+ * @brief Lock a room nobody uses, for a table migrated in
+ *
+ * Busy rooms are skipped rather than waited for: the sender holds its own
+ * table while it waits for the answer.
+ *
+ * @return The locked room, or NULL if none is free
+ */
+Room *room_take_empty(void) {
+    for (int i = 0; i < nbRooms; i++) {
+        Room *r = &rooms[i];
+        if (pthread_mutex_trylock(&r->lock) != 0) continue;
+        if (r->nbClients == 0 && !r->gameStarted && !r->finished && !room_resuming(r)) return r;
+        pthread_mutex_unlock(&r->lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Seat a connection back in a migrated room; caller holds r->lock
+ *
+ * @return 0, or -1 if the connection is already seated (or being seated) or closed
+ */
+int room_resume(int fd, Room *r) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return -1;
+    int none = 0;
+    if (!atomic_compare_exchange_strong(&connRoom[fd], &none, ROOM_CLAIMED)) return -1;
+    // Closed while MSG_RESUME waited in the queue: the reactor has already forgotten it
+    if (!conn_is_open(fd)) {
+        atomic_store(&connRoom[fd], 0);
+        return -1;
+    }
+    return room_bind(fd, r);
+}
+
+/**
+ * @brief Whether seats of a migrated table are still awaited; caller holds r->lock
+ */
+int room_resuming(const Room *r) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (r->resumeToken[i]) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Hold a migrated room until its seats with a token come back; caller holds r->lock
+ */
+void room_resume_wait(Room *r) {
+    r->resumeUntilNs = admission_now_ns() + (uint64_t)ROOM_RESUME_TIMEOUT_MS * 1000000ull;
+    atomic_fetch_or(&resumingRooms, 1ULL << r->id);
+    room_publish(r);
+}
+
+/**
+ * @brief Stop waiting for migrated seats and let the game go on; caller holds r->lock
+ *
+ * The turn is sent again to everyone back: a move made during the
+ * migration went to the old server, which dropped it.
+ */
+void room_resume_end(Room *r) {
+    memset(r->resumeToken, 0, sizeof(r->resumeToken));
+    r->resumeUntilNs = 0;
+    atomic_fetch_and(&resumingRooms, ~(1ULL << r->id));
+    int live = 0;
+    for (int i = 0; i < r->nbClients; i++) live += r->clientSockets[i] >= 0;
+    if (live == 0) {
+        printf("[Rooms] Room %d: nobody came back, empty again.\n", r->id);
+        room_reset(r);
+        return;
+    }
+    if (r->gameStarted) {
+        Payload_Turn turn = { .player_id = r->game.current };
+        for (int i = 0; i < r->nbClients; i++) {
+            if (r->clientSockets[i] >= 0) conn_send_packet(r->clientSockets[i], MSG_TURN, &turn, sizeof(turn), SEND_GAME);
+        }
+    }
+    room_publish(r);
+}
+
+/**
+ * @brief Unseat a connection whose table left for another server
+ *
+ * The connection stays open until the client follows MSG_REDIRECT; its
+ * frames no longer reach the room.
+ */
+void room_detach(int fd) {
+    if (fd >= 0 && fd < CONN_MAX_FD) atomic_store(&connRoom[fd], 0);
+}
+
+// Give up on migrated seats not taken back in time (publisher thread)
+static void expire_resumes(void) {
+    uint64_t pending = atomic_load(&resumingRooms);
+    uint64_t now = admission_now_ns();
+    while (pending) {
+        Room *r = &rooms[__builtin_ctzll(pending)];
+        pending &= pending - 1;
+        pthread_mutex_lock(&r->lock);
+        if (r->resumeUntilNs && now > r->resumeUntilNs && room_resuming(r)) {
+            int missing = 0;
+            for (int s = 0; s < MAX_CLIENTS; s++) missing += r->resumeToken[s] != 0;
+            printf("[Rooms] Room %d: %d migrated seat(s) not taken back in time.\n", r->id, missing);
+            room_resume_end(r);
+        }
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+/* --- Chat --- */
+
+/**
+ * @brief Store a chat line in the room's ring, overwriting the oldest; caller holds r->lock
+ *
+ * Control characters are blanked and the text is cut at CHAT_MAX_TEXT.
+ *
+ * @return The stored line, or NULL if nothing printable was left
+ */
+const Chat_Line *room_chat_append(Room *r, int playerId, const char *text, size_t len) {
+    // Cleaned aside: a rejected line must not touch the ring's oldest one
+    Chat_Line line;
+    size_t n = 0, printable = 0;
+    if (len > CHAT_MAX_TEXT) len = CHAT_MAX_TEXT;
+    for (; n < len && text[n] != '\0'; n++) {
+        unsigned char ch = text[n];
+        line.text[n] = (ch < 0x20 || ch == 0x7f) ? ' ' : ch;
+        if (line.text[n] != ' ') printable++;
+    }
+    if (printable == 0) return NULL;
+    line.text[n] = '\0';
+    line.seq = r->chatSeq;
+    line.playerId = playerId;
+    memcpy(line.name, r->tcpClients[playerId].name, sizeof(line.name) - 1);
+    line.name[sizeof(line.name) - 1] = '\0';
+
+    Chat_Line *slot = &r->chat[r->chatSeq++ % CHAT_HISTORY];
+    memcpy(slot, &line, offsetof(Chat_Line, text) + n + 1);
+    return slot;
+}
+
+/**
+ * @brief Copy the ring, oldest line first; caller holds r->lock
+ *
+ * @return Bytes of `history` to send
+ */
+uint32_t room_chat_history(const Room *r, Payload_Chat_History *history) {
+    uint32_t count = r->chatSeq < CHAT_HISTORY ? r->chatSeq : CHAT_HISTORY;
+    history->count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        history->lines[i] = r->chat[(r->chatSeq - count + i) % CHAT_HISTORY];
+    }
+    return offsetof(Payload_Chat_History, lines) + count * sizeof(Chat_Line);
+}
+
+/* --- Directory --- */
+
+/**
+ * @brief Fill a listing page from the directory, without any room lock
+ */
+void directory_page(int first, int count, Payload_Room_Page *page) {
+    memset(page, 0, sizeof(*page));
+    page->total = nbRooms;
+    if (first < 0) first = 0;
+    if (count < 0) count = 0;
+    if (count > ROOM_PAGE) count = ROOM_PAGE;
+    page->first = first;
+    for (int i = first; i < nbRooms && page->count < count; i++) unpack_entry(i, &page->rooms[page->count++]);
+    atomic_fetch_add(&dirStats.pages, 1);
+}
+
+void directory_subscribe(int fd, int on) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return;
+    unsigned long long bit = 1ULL << (fd % 64);
+    if (on) {
+        if (!(atomic_fetch_or(&subscribers[fd / 64], bit) & bit)) atomic_fetch_add(&dirStats.subscribed, 1);
+    } else {
+        if (atomic_fetch_and(&subscribers[fd / 64], ~bit) & bit) atomic_fetch_sub(&dirStats.subscribed, 1);
+    }
+}
+
+int directory_subscribed(int fd) {
+    if (fd < 0 || fd >= CONN_MAX_FD) return 0;
+    return (atomic_load(&subscribers[fd / 64]) >> (fd % 64)) & 1;
+}
+
+// One round: every room changed since the last one, sent once to every subscriber
+static void publish_round(void) {
+    uint64_t dirty = atomic_exchange(&dirtyRooms, 0);
+    if (!dirty || atomic_load(&dirStats.subscribed) == 0) return;
+
+    Payload_Room_Delta delta;
+    delta.seq = ++publishSeq;
+    delta.count = 0;
+    while (dirty) {
+        unpack_entry(__builtin_ctzll(dirty), &delta.rooms[delta.count++]);
+        dirty &= dirty - 1;
+    }
+    uint32_t len = offsetof(Payload_Room_Delta, rooms) + delta.count * sizeof(Room_Info);
+
+    for (int w = 0; w < CONN_MAX_FD / 64; w++) {
+        uint64_t bits = atomic_load(&subscribers[w]);
+        while (bits) {
+            int fd = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            // Spectator class: a slow lobby loses deltas (seq shows the gap), never its connection
+            if (conn_send_packet(fd, MSG_ROOM_DELTA, &delta, len, SEND_SPECTATOR) == 0) {
+                atomic_fetch_add(&dirStats.deltaFrames, 1);
+            } else {
+                atomic_fetch_add(&dirStats.deltaDrops, 1);
+            }
+        }
+    }
+    atomic_fetch_add(&dirStats.deltas, 1);
+}
+
+static void *publisher_thread(void *arg) {
+    (void)arg;
+    struct timespec period = { publishIntervalMs / 1000, (publishIntervalMs % 1000) * 1000000L };
+    for (;;) {
+        nanosleep(&period, NULL);
+        pthread_mutex_lock(&publishLock);
+        if (!atomic_load(&publishPaused)) publish_round();
+        pthread_mutex_unlock(&publishLock);
+        expire_resumes();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start the delta publisher; changes within a window go out together
+ */
+void directory_start(int intervalMs) {
+    pthread_t tid;
+    publishIntervalMs = intervalMs > 0 ? intervalMs : ROOM_DELTA_INTERVAL_MS;
+    if (pthread_create(&tid, NULL, publisher_thread, NULL) == 0) pthread_detach(tid);
+}
+
+/**
+ * @brief Hold back deltas (changes keep accumulating); returns once no round is running
+ */
+void directory_pause(int paused) {
+    pthread_mutex_lock(&publishLock);
+    atomic_store(&publishPaused, paused);
+    pthread_mutex_unlock(&publishLock);
+}
+
+void directory_stats_print(FILE *out) {
+    int count[3] = { 0, 0, 0 };
+    for (int i = 0; i < nbRooms; i++) {
+        Room_Info info;
+        unpack_entry(i, &info);
+        if (info.state <= ROOM_FINISHED) count[info.state]++;
+    }
+    fprintf(out, "[Metrics] rooms=%d waiting=%d playing=%d finished=%d subscribers=%d pages=%lu deltas=%lu "
+                 "delta_frames=%lu delta_drops=%lu\n",
+            nbRooms, count[ROOM_WAITING], count[ROOM_PLAYING], count[ROOM_FINISHED],
+            atomic_load(&dirStats.subscribed), atomic_load(&dirStats.pages), atomic_load(&dirStats.deltas),
+            atomic_load(&dirStats.deltaFrames), atomic_load(&dirStats.deltaDrops));
+}
@@ -0,0 +1,154 @@
+// rules.c
+#include "../include/rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Card -> objects of the original 13-card deck
+// Objects: 0 Pipe, 1 Ampoule, 2 Poing, 3 Insigne, 4 Cahier, 5 Collier, 6 Oeil, 7 Crâne
+#define CLASSIC_DECK \
+    .nbCards = 13, \
+    .nbObjects = 8, \
+    .objectNames = { "Pipe", "Ampoule", "Poing", "Insigne", "Cahier", "Collier", "Oeil", "Crâne" }, \
+    .cardNames = { \
+        "Sebastian Moran", "Irene Adler", "Inspector Lestrade", "Inspector Gregson", \
+        "Inspector Baynes", "Inspector Bradstreet", "Inspector Hopkins", \
+        "Sherlock Holmes", "John Watson", "Mycroft Holmes", "Mrs. Hudson", \
+        "Mary Morstan", "James Moriarty" \
+    }, \
+    .cardObjects = { \
+        {0,0,1,0,0,0,0,1}, /* Sebastian Moran: Poing, Crâne */ \
+        {0,1,0,0,0,1,0,1}, /* Irene Adler: Ampoule, Collier, Crâne */ \
+        {0,0,0,1,1,0,1,0}, /* Inspector Lestrade: Insigne, Cahier, Oeil */ \
+        {0,0,1,1,1,0,0,0}, /* Inspector Gregson: Poing, Insigne, Cahier */ \
+        {0,1,0,1,0,0,0,0}, /* Inspector Baynes: Ampoule, Insigne */ \
+        {0,0,1,1,0,0,0,0}, /* Inspector Bradstreet: Poing, Insigne */ \
+        {1,0,0,1,0,0,1,0}, /* Inspector Hopkins: Pipe, Insigne, Oeil */ \
+        {1,1,1,0,0,0,0,0}, /* Sherlock Holmes: Pipe, Ampoule, Poing */ \
+        {1,0,1,0,0,0,1,0}, /* John Watson: Pipe, Poing, Oeil */ \
+        {1,1,0,0,1,0,0,0}, /* Mycroft Holmes: Pipe, Ampoule, Cahier */ \
+        {1,0,0,0,0,1,0,0}, /* Mrs. Hudson: Pipe, Collier */ \
+        {0,0,0,0,1,1,0,0}, /* Mary Morstan: Cahier, Collier */ \
+        {0,1,0,0,0,0,0,1}  /* James Moriarty: Ampoule, Crâne */ \
+    }
+
+static const RuleSet builtinRules[] = {
+    { .name = "classic",    .nbPlayers = 4, .handSize = 3, CLASSIC_DECK },
+    { .name = "classic-3p", .nbPlayers = 3, .handSize = 4, CLASSIC_DECK },
+    { .name = "classic-2p", .nbPlayers = 2, .handSize = 6, CLASSIC_DECK },
+};
+
+RuleSet activeRules = { .name = "classic", .nbPlayers = 4, .handSize = 3, CLASSIC_DECK };
+
+const RuleSet *rules_builtin(const char *name) {
+    for (size_t i = 0; i < sizeof(builtinRules) / sizeof(builtinRules[0]); i++) {
+        if (strcmp(builtinRules[i].name, name) == 0) return &builtinRules[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check that a rule set can actually be dealt and played
+ */
+int rules_validate(const RuleSet *r) {
+    if (r->nbPlayers < 2 || r->nbPlayers > MAX_PLAYERS) return -1;
+    if (r->nbCards < 2 || r->nbCards > MAX_CARDS) return -1;
+    if (r->nbObjects < 1 || r->nbObjects > MAX_OBJECTS) return -1;
+    if (r->handSize < 1 || r->handSize > MAX_HAND) return -1;
+    if (r->nbPlayers * r->handSize + 1 != r->nbCards) return -1; // One culprit, the rest dealt evenly
+    return 0;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+static int object_index(const RuleSet *r, const char *name) {
+    for (int i = 0; i < r->nbObjects; i++) {
+        if (strcmp(r->objectNames[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Load a custom rule set
+ *
+ * Format (one setting per line, '#' comments):
+ *   name = my-event
+ *   players = 3
+ *   objects = Pipe, Ampoule, Poing
+ *   card = Sherlock Holmes: Pipe, Ampoule, Poing
+ * The hand size follows from the number of cards and players.
+ */
+int rules_load_file(RuleSet *r, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    memset(r, 0, sizeof(*r));
+    char line[512];
+    int lineNo = 0, rc = 0;
+    while (fgets(line, sizeof(line), f) && rc == 0) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *key = trim(line);
+        if (*key == '\0') continue;
+        char *eq = strchr(key, '=');
+        if (!eq) { rc = -1; break; }
+        *eq = '\0';
+        char *val = trim(eq + 1);
+        key = trim(key);
+
+        if (strcmp(key, "name") == 0) {
+            snprintf(r->name, sizeof(r->name), "%s", val);
+        } else if (strcmp(key, "players") == 0) {
+            r->nbPlayers = atoi(val);
+        } else if (strcmp(key, "objects") == 0) {
+            for (char *tok = strtok(val, ","); tok && rc == 0; tok = strtok(NULL, ",")) {
+                if (r->nbObjects >= MAX_OBJECTS) rc = -1;
+                else snprintf(r->objectNames[r->nbObjects++], sizeof(r->objectNames[0]), "%s", trim(tok));
+            }
+        } else if (strcmp(key, "card") == 0) {
+            char *colon = strchr(val, ':');
+            if (!colon || r->nbCards >= MAX_CARDS) { rc = -1; break; }
+            *colon = '\0';
+            int card = r->nbCards++;
+            snprintf(r->cardNames[card], sizeof(r->cardNames[0]), "%s", trim(val));
+            for (char *tok = strtok(colon + 1, ","); tok && rc == 0; tok = strtok(NULL, ",")) {
+                int obj = object_index(r, trim(tok));
+                if (obj < 0) rc = -1;
+                else r->cardObjects[card][obj]++;
+            }
+        } else {
+            rc = -1;
+        }
+    }
+    fclose(f);
+
+    if (rc == 0 && r->nbPlayers > 0) r->handSize = (r->nbCards - 1) / r->nbPlayers;
+    if (rc < 0 || rules_validate(r) < 0) {
+        fprintf(stderr, "%s:%d: invalid rule set\n", path, lineNo);
+        return -1;
+    }
+    if (r->name[0] == '\0') snprintf(r->name, sizeof(r->name), "custom");
+    return 0;
+}
+
+/**
+ * @brief Select a built-in rule set by name, or load one from a file
+ */
+int rules_load(RuleSet *r, const char *nameOrPath) {
+    const RuleSet *builtin = rules_builtin(nameOrPath);
+    if (builtin) {
+        *r = *builtin;
+        return 0;
+    }
+    return rules_load_file(r, nameOrPath);
+}
@@ -0,0 +1,269 @@
+// server_config.c
+#include "../include/server_config.h"
+#include "../include/rooms.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+ServerConfig serverConfig;
+
+/**
+ * @brief Fill in the defaults, sized from the cores this host actually has
+ */
+void config_defaults(ServerConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) cores = 1;
+
+    cfg->port = DEFAULT_PORT;
+    snprintf(cfg->rules, sizeof(cfg->rules), "classic");
+    snprintf(cfg->ratingsLog, sizeof(cfg->ratingsLog), "ratings.log");
+    cfg->rooms = 8;
+    cfg->roomDeltaMs = ROOM_DELTA_INTERVAL_MS;
+    cfg->chatRate = 1.0;
+    cfg->chatBurst = 5.0;
+    cfg->minThreads = 1;
+    cfg->maxThreads = (int)cores;
+    cfg->maxEvents = 64;
+    cfg->listenBacklog = 128;
+    cfg->reactorCpu = -1;
+    CPU_ZERO(&cfg->workerCpus);
+    cfg->conn = connLimits;
+    cfg->admission = admissionLimits;
+}
+
+/**
+ * @brief Parse a CPU list such as "0-3,6,8-9" into a set
+ */
+int config_parse_cpu_list(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if (end == p || lo < 0 || lo >= CPU_SETSIZE) return -1;
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            if (end == p + 1 || hi < lo || hi >= CPU_SETSIZE) return -1;
+            p = end;
+        }
+        for (long c = lo; c <= hi; c++) CPU_SET(c, set);
+        while (*p == ',' || isspace((unsigned char)*p)) p++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Collect the CPUs serving a NIC's interrupts
+ *
+ * Scans /proc/interrupts for IRQ lines naming the interface (e.g.
+ * "eth0-TxRx-0") and merges their /proc/irq/N/smp_affinity_list.
+ *
+ * @return Number of IRQs found, -1 if /proc/interrupts is unreadable
+ */
+int config_irq_cpus(const char *nic, cpu_set_t *set) {
+    CPU_ZERO(set);
+    FILE *f = fopen("/proc/interrupts", "r");
+    if (!f) return -1;
+
+    char line[4096];
+    int found = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!strstr(line, nic)) continue;
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (!isdigit((unsigned char)*p)) continue;
+        int irq = atoi(p);
+
+        char path[64], list[256];
+        snprintf(path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq);
+        FILE *a = fopen(path, "r");
+        if (!a) continue;
+        if (fgets(list, sizeof(list), a)) {
+            list[strcspn(list, "\n")] = '\0';
+            cpu_set_t irqSet;
+            if (config_parse_cpu_list(list, &irqSet) == 0) {
+                CPU_OR(set, set, &irqSet);
+                found++;
+            }
+        }
+        fclose(a);
+    }
+    fclose(f);
+    return found;
+}
+
+static int parse_bool(const char *val) {
+    return val == NULL || *val == '\0' || strcmp(val, "1") == 0 ||
+           strcmp(val, "yes") == 0 || strcmp(val, "true") == 0;
+}
+
+// Apply one "key" / "value" setting; shared by the file and the command line
+static int config_set(ServerConfig *cfg, const char *key, const char *val) {
+    if (strcmp(key, "port") == 0 && val) {
+        cfg->port = atoi(val);
+    } else if (strcmp(key, "unix") == 0 && val) {
+        snprintf(cfg->unixPath, sizeof(cfg->unixPath), "%s", val);
+    } else if (strcmp(key, "rules") == 0 && val) {
+        snprintf(cfg->rules, sizeof(cfg->rules), "%s", val);
+    } else if (strcmp(key, "ratings") == 0) {
+        snprintf(cfg->ratingsLog, sizeof(cfg->ratingsLog), "%s", val ? val : "");
+    } else if (strcmp(key, "rooms") == 0 && val) {
+        cfg->rooms = atoi(val);
+    } else if (strcmp(key, "room-delta-ms") == 0 && val) {
+        cfg->roomDeltaMs = atoi(val);
+    } else if (strcmp(key, "trace") == 0) {
+        snprintf(cfg->traceFile, sizeof(cfg->traceFile), "%s", val ? val : "");
+    } else if (strcmp(key, "migrate-secret") == 0) {
+        snprintf(cfg->migrateSecret, sizeof(cfg->migrateSecret), "%s", val ? val : "");
+    } else if (strcmp(key, "chat-rate") == 0 && val) {
+        cfg->chatRate = atof(val);
+    } else if (strcmp(key, "chat-burst") == 0 && val) {
+        cfg->chatBurst = atof(val);
+    } else if (strcmp(key, "chat-queue") == 0 && val) {
+        cfg->conn.lowLimit = strtoul(val, NULL, 10);
+    } else if (strcmp(key, "upgrade-listener-only") == 0) {
+        cfg->upgradeListenerOnly = parse_bool(val);
+    } else if (strcmp(key, "threads") == 0 && val) {
+        cfg->maxThreads = atoi(val);
+    } else if (strcmp(key, "min-threads") == 0 && val) {
+        cfg->minThreads = atoi(val);
+    } else if (strcmp(key, "max-events") == 0 && val) {
+        cfg->maxEvents = atoi(val);
+    } else if (strcmp(key, "backlog") == 0 && val) {
+        cfg->listenBacklog = atoi(val);
+    } else if (strcmp(key, "reactor-cpu") == 0 && val) {
+        cfg->reactorCpu = atoi(val);
+    } else if (strcmp(key, "worker-cpus") == 0 && val) {
+        if (config_parse_cpu_list(val, &cfg->workerCpus) < 0) return -1;
+    } else if (strcmp(key, "avoid-irq") == 0 && val) {
+        snprintf(cfg->avoidIrqOf, sizeof(cfg->avoidIrqOf), "%s", val);
+    } else if (strcmp(key, "out-limit") == 0 && val) {
+        // Watermarks follow the limit: pause input at 1/4, resume at 1/16
+        cfg->conn.outLimit = strtoul(val, NULL, 10);
+        cfg->conn.outHighWatermark = cfg->conn.outLimit / 4;
+        cfg->conn.outLowWatermark = cfg->conn.outLimit / 16;
+    } else if (strcmp(key, "slow-policy") == 0 && val) {
+        if (strcmp(val, "drop") == 0) cfg->conn.slowPolicy = SLOW_DROP_SPECTATOR;
+        else if (strcmp(val, "disconnect") == 0) cfg->conn.slowPolicy = SLOW_DISCONNECT;
+        else return -1;
+    } else if (strcmp(key, "max-frame") == 0 && val) {
+        cfg->conn.inMaxFrame = strtoul(val, NULL, 10);
+    } else if (strcmp(key, "conn-rate") == 0 && val) {
+        // Bursts follow the rates: two seconds' worth (four for one IP)
+        cfg->admission.connRate = atof(val);
+        cfg->admission.connBurst = 2 * cfg->admission.connRate;
+    } else if (strcmp(key, "ip-conn-rate") == 0 && val) {
+        cfg->admission.ipConnRate = atof(val);
+        cfg->admission.ipConnBurst = 4 * cfg->admission.ipConnRate;
+    } else if (strcmp(key, "frame-rate") == 0 && val) {
+        cfg->admission.frameRate = atof(val);
+        cfg->admission.frameBurst = 2 * cfg->admission.frameRate;
+    } else if (strcmp(key, "ip-frame-rate") == 0 && val) {
+        cfg->admission.ipFrameRate = atof(val);
+        cfg->admission.ipFrameBurst = 2 * cfg->admission.ipFrameRate;
+    } else if (strcmp(key, "flood-disconnect") == 0 && val) {
+        cfg->admission.floodDisconnect = atoi(val);
+    } else if (strcmp(key, "max-connections") == 0 && val) {
+        cfg->admission.maxConnections = atoi(val);
+    } else if (strcmp(key, "shed-queue-depth") == 0 && val) {
+        cfg->admission.shedQueueDepth = atoi(val);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+/**
+ * @brief Load "key = value" settings from a file
+ */
+int config_load_file(ServerConfig *cfg, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[512];
+    int lineNo = 0, rc = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *key = trim(line);
+        if (*key == '\0') continue;
+
+        char *val = NULL;
+        char *eq = strchr(key, '=');
+        if (eq) {
+            *eq = '\0';
+            val = trim(eq + 1);
+            key = trim(key);
+        }
+        if (config_set(cfg, key, val) < 0) {
+            fprintf(stderr, "%s:%d: invalid setting '%s'\n", path, lineNo, key);
+            rc = -1;
+        }
+    }
+    fclose(f);
+    return rc;
+}
+
+/**
+ * @brief Parse the command line: [port] [--config=FILE] [--key=value ...]
+ *
+ * The config file is loaded first wherever --config appears, so the other
+ * options always override it.
+ */
+int config_parse_args(ServerConfig *cfg, int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--config=", 9) == 0 && config_load_file(cfg, argv[i] + 9) < 0) return -1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--config=", 9) == 0) continue;
+        if (strncmp(argv[i], "--", 2) != 0) {
+            cfg->port = atoi(argv[i]); // Positional port, as before
+            continue;
+        }
+
+        char key[64];
+        const char *val = strchr(argv[i], '=');
+        size_t keyLen = val ? (size_t)(val - argv[i] - 2) : strlen(argv[i] + 2);
+        if (keyLen >= sizeof(key)) keyLen = sizeof(key) - 1;
+        memcpy(key, argv[i] + 2, keyLen);
+        key[keyLen] = '\0';
+        if (config_set(cfg, key, val ? val + 1 : NULL) < 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    if (cfg->maxThreads < 1) cfg->maxThreads = 1;
+    if (cfg->minThreads < 1) cfg->minThreads = 1;
+    if (cfg->minThreads > cfg->maxThreads) cfg->minThreads = cfg->maxThreads;
+    if (cfg->maxEvents < 1) cfg->maxEvents = 1;
+    if (cfg->listenBacklog < 1) cfg->listenBacklog = 1;
+    if (cfg->rooms < 1) cfg->rooms = 1;
+    if (cfg->rooms > MAX_ROOMS) cfg->rooms = MAX_ROOMS;
+    if (cfg->roomDeltaMs < 10) cfg->roomDeltaMs = 10;
+    if (cfg->admission.maxConnections > CONN_MAX_FD) cfg->admission.maxConnections = CONN_MAX_FD;
+    return 0;
+}
+
+void config_print(const ServerConfig *cfg) {
+    printf("[Config] workers=%d..%d max_events=%d backlog=%d reactor_cpu=%d worker_cpus=%d avoid_irq=%s\n",
+           cfg->minThreads, cfg->maxThreads, cfg->maxEvents, cfg->listenBacklog, cfg->reactorCpu,
+           CPU_COUNT(&cfg->workerCpus), cfg->avoidIrqOf[0] ? cfg->avoidIrqOf : "-");
+}
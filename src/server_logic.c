@@ -1,40 +1,46 @@
 // server_logic.c
 #include "../include/server_logic.h"
 #include "../include/common.h"
+#include "../include/upgrade.h"
+#include "../include/connection.h"
+#include "../include/server_config.h"
+#include "../include/rules.h"
+#include "../include/admission.h"
+#include "../include/game.h"
+#include "../include/ratings.h"
+#include "../include/rooms.h"
+#include "../include/trace.h"
+#include "../include/migrate.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/epoll.h> // Linux Epoll
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
 
-#define MAX_EVENTS 64
-#define THREAD_POOL_SIZE 4
+#define MAX_LISTENERS 4
+#define WORKER_IDLE_TIMEOUT_S 2
+#define UPGRADE_ACK_TIMEOUT_MS 5000
+#define UPGRADE_STATE_VERSION 6
 
-// Global Game State
-Client tcpClients[MAX_CLIENTS];
-int clientSockets[MAX_CLIENTS];
-int nbClients = 0;
-int nbPlayers = 4;
-int deck[13];
-int tableCartes[4][8];
-int joueurCourant = 0;
-int crimeCard = -1;
-int playerAlive[4] = {1, 1, 1, 1};
-int gameStarted = 0;
-
-// Synchronization
-pthread_mutex_t gameMutex = PTHREAD_MUTEX_INITIALIZER;
+// Game state lives in the rooms (see rooms.c), each behind its own lock
 
 // Thread Pool Task Queue
 typedef struct Task {
     int clientSock;
     PacketHeader header;
     void *payload;
+    uint64_t enqueuedNs;    // Only set while recording a trace
     struct Task *next;
 } Task;
 
@@ -42,109 +48,83 @@ typedef struct {
     Task *front, *rear;
     pthread_mutex_t lock;
     pthread_cond_t cond;
+    pthread_cond_t exited;  // Signalled when a worker leaves
     int stop;
+    int depth;              // Queued tasks
+    int live;               // Running workers
+    int idle;               // Workers waiting for a task
 } TaskQueue;
 
 TaskQueue taskQueue;
-pthread_t threadPool[THREAD_POOL_SIZE];
+static cpu_set_t workerCpus;
+
+// Hot Upgrade
+static volatile sig_atomic_t upgradeRequested = 0;
+static volatile sig_atomic_t statsRequested = 0;
+static volatile sig_atomic_t stopRequested = 0;    // SIGINT/SIGTERM
+static int draining = 0;                    // Listener handed off, exit once the last connection closes
+
+// Listening sockets: TCP, plus the optional Unix-domain socket
+static int listeners[MAX_LISTENERS];
+static int nbListeners = 0;
+
+// Game state carried across a hot upgrade (connections referenced by handoff index).
+// Followed by nbRooms UpgradeRoom records, then one UpgradeConnBuffers record
+// plus its bytes per handed-off connection.
+typedef struct {
+    uint32_t version;
+    int32_t nbRooms;
+    RuleSet rules;
+} __attribute__((packed)) UpgradeState;
+
+typedef struct {
+    int32_t nbClients;
+    int32_t nbPlayers;
+    int32_t joueurCourant;
+    int32_t crimeCard;
+    int32_t gameStarted;
+    int32_t finished;
+    int32_t deck[MAX_CARDS];
+    int32_t tableCartes[MAX_PLAYERS][MAX_OBJECTS];
+    int32_t playerAlive[MAX_PLAYERS];
+    int32_t clientConn[MAX_CLIENTS];
+    Client tcpClients[MAX_CLIENTS];
+    uint32_t chatSeq;
+    Chat_Line chat[CHAT_HISTORY];
+    uint64_t resumeToken[MAX_CLIENTS];      // Migrated seats not taken back yet
+} __attribute__((packed)) UpgradeRoom;
+
+typedef struct {
+    uint32_t inLen;     // Partial inbound frame bytes
+    uint32_t outLen;    // Outbound backlog not yet sent
+    uint32_t lobby;     // Subscribed to the room directory
+} __attribute__((packed)) UpgradeConnBuffers;
 
 /* --- Helper Prototypes --- */
-void send_packet(int sockfd, uint8_t type, const void *payload, uint32_t payload_len);
-int recv_all(int sockfd, void *buffer, size_t length);
 void handle_logic(int clientSock, uint8_t type, void *data, uint32_t len);
 
-/* --- Game Logic Helpers --- */
-void melangerDeck() {
-    for (int i = 0; i < 13; i++) deck[i] = i;
-    for (int i = 12; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int temp = deck[i];
-        deck[i] = deck[j];
-        deck[j] = temp;
-    }
-}
-
-void createTable() {
-    // Initialize all players' symbol counts to 0
-    memset(tableCartes, 0, sizeof(tableCartes));
-
-    // Iterate through each player's 3 cards, assigning symbols
-    for (int player = 0; player < 4; player++) {
-        int cards[3] = {deck[player*3], deck[player*3+1], deck[player*3+2]};
-        for (int c = 0; c < 3; c++) {
-            int card = cards[c];
-            switch (card) {
-                case 0: // Sebastian Moran
-                    tableCartes[player][7]++; // Crâne
-                    tableCartes[player][2]++; // Poing
-                    break;
-                case 1: // Irene Adler
-                    tableCartes[player][7]++; // Crâne
-                    tableCartes[player][1]++; // Ampoule
-                    tableCartes[player][5]++; // Collier
-                    break;
-                case 2: // Inspector Lestrade
-                    tableCartes[player][3]++; // Insigne
-                    tableCartes[player][6]++; // Oeil
-                    tableCartes[player][4]++; // Cahier
-                    break;
-                case 3: // Inspector Gregson
-                    tableCartes[player][3]++; // Insigne
-                    tableCartes[player][2]++; // Poing
-                    tableCartes[player][4]++; // Cahier
-                    break;
-                case 4: // Inspector Baynes
-                    tableCartes[player][3]++; // Insigne
-                    tableCartes[player][1]++; // Ampoule
-                    break;
-                case 5: // Inspector Bradstreet
-                    tableCartes[player][3]++; // Insigne
-                    tableCartes[player][2]++; // Poing
-                    break;
-                case 6: // Inspector Hopkins
-                    tableCartes[player][3]++; // Insigne
-                    tableCartes[player][0]++; // Pipe
-                    tableCartes[player][6]++; // Oeil
-                    break;
-                case 7: // Sherlock Holmes
-                    tableCartes[player][0]++; // Pipe
-                    tableCartes[player][1]++; // Ampoule
-                    tableCartes[player][2]++; // Poing
-                    break;
-                case 8: // John Watson
-                    tableCartes[player][0]++; // Pipe
-                    tableCartes[player][6]++; // Oeil
-                    tableCartes[player][2]++; // Poing
-                    break;
-                case 9: // Mycroft Holmes
-                    tableCartes[player][0]++; // Pipe
-                    tableCartes[player][1]++; // Ampoule
-                    tableCartes[player][4]++; // Cahier
-                    break;
-                case 10: // Mrs. Hudson
-                    tableCartes[player][0]++; // Pipe
-                    tableCartes[player][5]++; // Collier
-                    break;
-                case 11: // Mary Morstan
-                    tableCartes[player][4]++; // Cahier
-                    tableCartes[player][5]++; // Collier
-                    break;
-                case 12: // James Moriarty
-                    tableCartes[player][7]++; // Crâne
-                    tableCartes[player][1]++; // Ampoule
-                    break;
-            }
-        }
-    }
-}
-
 /* --- Thread Pool Implementation --- */
 
 void init_queue(TaskQueue *q) {
     q->front = q->rear = NULL;
     pthread_mutex_init(&q->lock, NULL);
     pthread_cond_init(&q->cond, NULL);
+    pthread_cond_init(&q->exited, NULL);
     q->stop = 0;
+    q->depth = 0;
+    q->live = 0;
+    q->idle = 0;
+}
+
+void *worker_thread(void *arg);
+
+// Caller holds q->lock
+static void spawn_worker(TaskQueue *q) {
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, worker_thread, NULL) == 0) {
+        pthread_detach(tid);
+        q->live++;
+    }
 }
 
 void enqueue_task(TaskQueue *q, int sock, PacketHeader h, void *p) {
@@ -152,12 +132,17 @@ void enqueue_task(TaskQueue *q, int sock, PacketHeader h, void *p) {
     t->clientSock = sock;
     t->header = h;
     t->payload = p;
+    t->enqueuedNs = TRACE_CLOCK();
     t->next = NULL;
 
     pthread_mutex_lock(&q->lock);
     if (q->rear) q->rear->next = t;
     else q->front = t;
     q->rear = t;
+    q->depth++;
+    TRACE_POINT2(enqueue, TRACE_ENQUEUE, sock, q->depth);
+    // Grow with the backlog: more queued tasks than idle workers
+    if (!q->stop && q->depth > q->idle && q->live < serverConfig.maxThreads) spawn_worker(q);
     pthread_cond_signal(&q->cond);
     pthread_mutex_unlock(&q->lock);
 }
@@ -166,31 +151,119 @@ Task dequeue_task(TaskQueue *q) {
     Task t;
     pthread_mutex_lock(&q->lock);
     while (q->front == NULL && !q->stop) {
-        pthread_cond_wait(&q->cond, &q->lock);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += WORKER_IDLE_TIMEOUT_S;
+        q->idle++;
+        int rc = pthread_cond_timedwait(&q->cond, &q->lock, &deadline);
+        q->idle--;
+        // Shrink back when the load is gone
+        if (rc == ETIMEDOUT && q->front == NULL && q->live > serverConfig.minThreads) break;
     }
-    if (q->stop) {
+    if (q->front == NULL) {
+        // Stopped and fully drained, or retired: tell the worker to exit
+        q->live--;
+        pthread_cond_broadcast(&q->exited);
         pthread_mutex_unlock(&q->lock);
-        exit(0);
+        t.clientSock = -1;
+        return t;
     }
     Task *temp = q->front;
     t = *temp;
     q->front = q->front->next;
     if (q->front == NULL) q->rear = NULL;
+    q->depth--;
     free(temp);
     pthread_mutex_unlock(&q->lock);
     return t;
 }
 
+/**
+ * @brief Restrict the calling thread to a CPU set (no-op for an empty set)
+ */
+static void pin_current_thread(const cpu_set_t *cpus) {
+    if (CPU_COUNT(cpus) == 0) return;
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), cpus);
+    if (rc != 0) fprintf(stderr, "[Server] CPU pinning failed: %s\n", strerror(rc));
+}
+
 void *worker_thread(void *arg) {
+    pin_current_thread(&workerCpus);
+    trace_thread_name("worker");
     while (1) {
         Task task = dequeue_task(&taskQueue);
+        if (task.clientSock < 0) break;
+        uint64_t startNs = TRACE_CLOCK();
+        TRACE_SDT2(dequeue, task.clientSock, task.header.type);
+        if (startNs && task.enqueuedNs) trace_span(TRACE_QUEUE_WAIT, task.enqueuedNs, startNs, task.clientSock, task.header.type);
+
         // Process Business Logic protected by Mutex inside handle_logic if needed
+        TRACE_SDT2(handle_entry, task.clientSock, task.header.type);
         handle_logic(task.clientSock, task.header.type, task.payload, ntohl(task.header.length));
+        TRACE_SDT2(handle_exit, task.clientSock, task.header.type);
+        if (startNs) trace_span(TRACE_HANDLE, startNs, trace_now_ns(), task.clientSock, task.header.type);
         if (task.payload) free(task.payload);
     }
     return NULL;
 }
 
+void start_thread_pool() {
+    pthread_mutex_lock(&taskQueue.lock);
+    taskQueue.stop = 0;
+    while (taskQueue.live < serverConfig.minThreads) spawn_worker(&taskQueue);
+    pthread_mutex_unlock(&taskQueue.lock);
+}
+
+/**
+ * @brief Stop the workers once every queued task has been processed
+ */
+void stop_thread_pool() {
+    pthread_mutex_lock(&taskQueue.lock);
+    taskQueue.stop = 1;
+    pthread_cond_broadcast(&taskQueue.cond);
+    while (taskQueue.live > 0) pthread_cond_wait(&taskQueue.exited, &taskQueue.lock);
+    pthread_mutex_unlock(&taskQueue.lock);
+}
+
+/**
+ * @brief Work out the reactor and worker CPU sets from the configuration
+ *
+ * CPUs serving the configured NIC's interrupts are removed from both, so
+ * server threads never compete with packet processing.
+ */
+static void setup_cpu_topology(cpu_set_t *reactorCpus) {
+    cpu_set_t irqCpus;
+    CPU_ZERO(&irqCpus);
+    CPU_ZERO(reactorCpus);
+    workerCpus = serverConfig.workerCpus;
+
+    if (serverConfig.avoidIrqOf[0] != '\0') {
+        int n = config_irq_cpus(serverConfig.avoidIrqOf, &irqCpus);
+        printf("[Server] %s: %d IRQ(s) on %d CPU(s) kept free of server threads.\n",
+               serverConfig.avoidIrqOf, n < 0 ? 0 : n, CPU_COUNT(&irqCpus));
+        if (CPU_COUNT(&workerCpus) == 0) {
+            // No explicit list: every online CPU except the IRQ ones
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long c = 0; c < cores && c < CPU_SETSIZE; c++) CPU_SET(c, &workerCpus);
+        }
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &irqCpus)) CPU_CLR(c, &workerCpus);
+        }
+        if (CPU_COUNT(&workerCpus) == 0) {
+            fprintf(stderr, "[Server] Every worker CPU serves %s IRQs, not pinning workers.\n", serverConfig.avoidIrqOf);
+        }
+    }
+
+    if (serverConfig.reactorCpu >= 0) {
+        if (CPU_ISSET(serverConfig.reactorCpu, &irqCpus)) {
+            fprintf(stderr, "[Server] Reactor CPU %d serves %s IRQs, not pinning the reactor.\n",
+                    serverConfig.reactorCpu, serverConfig.avoidIrqOf);
+        } else {
+            CPU_SET(serverConfig.reactorCpu, reactorCpus);
+        }
+    }
+}
+
 /* --- Core Network Logic (Epoll Main Loop) --- */
 
 void set_nonblocking(int sock) {
@@ -199,82 +272,506 @@ void set_nonblocking(int sock) {
     fcntl(sock, F_SETFL, opts | O_NONBLOCK);
 }
 
-void start_server_listener(int port) {
-    int listenSock, epollFd;
-    struct sockaddr_in addr;
-    struct epoll_event ev, events[MAX_EVENTS];
+static void close_connection(int fd) {
+    conn_close(fd);
+    admission_conn_close(fd);
+    room_disconnect(fd);
 
-    // 1. Init Thread Pool
-    init_queue(&taskQueue);
-    for (int i = 0; i < THREAD_POOL_SIZE; i++) {
-        pthread_create(&threadPool[i], NULL, worker_thread, NULL);
+    if (draining && conn_count() == 0) {
+        stop_thread_pool();
+        printf("[Server] Drained all connections, exiting.\n");
+        exit(0);
+    }
+}
+
+// Called by the reactor for every complete frame: police it, copy it out and push it to the pool
+static int on_frame(int fd, const PacketHeader *header, const void *data) {
+    uint32_t len = ntohl(header->length);
+    TRACE_POINT2(frame, TRACE_FRAME, fd, header->type);
+    AdmitResult verdict = admission_frame(fd, header->type, len);
+    if (verdict == ADMIT_CLOSE) {
+        printf("[Server] Dropping socket %d: bad or flooding frame (type 0x%02x, %u bytes).\n", fd, header->type, len);
+        return -1;
+    }
+    if (verdict == ADMIT_DROP) return 0;
+
+    void *payload = NULL;
+    if (len > 0) {
+        payload = malloc(len);
+        memcpy(payload, data, len);
+    }
+    enqueue_task(&taskQueue, fd, *header, payload);
+    return 0;
+}
+
+// Track an inherited or adopted connection under its peer's source IP
+static void admission_track(int fd) {
+    struct sockaddr_storage peer;
+    socklen_t peerLen = sizeof(peer);
+    if (getpeername(fd, (struct sockaddr *)&peer, &peerLen) < 0) peerLen = 0;
+    admission_conn_open(fd, peerLen ? (struct sockaddr *)&peer : NULL, peerLen);
+}
+
+/**
+ * @brief Accept every pending connection on a listener (edge-triggered)
+ *
+ * Each one goes through admission control first; refused sockets are
+ * closed at once, before any buffer or task is spent on them.
+ */
+static void accept_pending(int listenFd) {
+    for (;;) {
+        struct sockaddr_storage peer;
+        socklen_t peerLen = sizeof(peer);
+        int connSock = accept(listenFd, (struct sockaddr *)&peer, &peerLen);
+        if (connSock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+
+        pthread_mutex_lock(&taskQueue.lock);
+        int queueDepth = taskQueue.depth;
+        pthread_mutex_unlock(&taskQueue.lock);
+        if (!admission_accept(connSock, (struct sockaddr *)&peer, peerLen, conn_count(), queueDepth)) {
+            close(connSock);
+            continue;
+        }
+
+        set_nonblocking(connSock);
+        if (peer.ss_family == AF_INET) {
+            // Frames are already batched in the backlog: Nagle would only add
+            // a delayed-ACK stall (~40 ms) between VERIFY and the next TURN
+            int one = 1;
+            setsockopt(connSock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (conn_open(connSock) < 0) {
+            admission_conn_close(connSock);
+            close(connSock);
+            continue;
+        }
+        TRACE_POINT1(accept, TRACE_ACCEPT, connSock);
+        printf("[Server] New connection: Socket %d\n", connSock);
+    }
+}
+
+static void on_upgrade_signal(int sig) {
+    (void)sig;
+    upgradeRequested = 1;
+}
+
+static void on_stats_signal(int sig) {
+    (void)sig;
+    statsRequested = 1;
+}
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stopRequested = 1;
+}
+
+/* --- Hot Upgrade --- */
+
+static void export_upgrade_room(UpgradeRoom *ur, const Room *r, const int *connFds, int nconn) {
+    memset(ur, 0, sizeof(*ur));
+    ur->nbClients = r->nbClients;
+    ur->nbPlayers = r->nbPlayers;
+    ur->joueurCourant = r->game.current;
+    ur->crimeCard = r->game.crimeCard;
+    ur->gameStarted = r->gameStarted;
+    ur->finished = r->finished;
+    memcpy(ur->deck, r->game.deck, sizeof(ur->deck));
+    memcpy(ur->tableCartes, r->game.table, sizeof(ur->tableCartes));
+    memcpy(ur->playerAlive, r->game.alive, sizeof(ur->playerAlive));
+    memcpy(ur->tcpClients, r->tcpClients, sizeof(ur->tcpClients));
+    ur->chatSeq = r->chatSeq;
+    memcpy(ur->chat, r->chat, sizeof(ur->chat));
+    memcpy(ur->resumeToken, r->resumeToken, sizeof(ur->resumeToken));
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        ur->clientConn[i] = -1;
+        if (i >= r->nbClients) continue;
+        for (int c = 0; c < nconn; c++) {
+            if (connFds[c] == r->clientSockets[i]) ur->clientConn[i] = c;
+        }
+    }
+}
+
+static void import_upgrade_room(const UpgradeRoom *ur, Room *r, const int *connFds, int nconn) {
+    r->nbClients = ur->nbClients;
+    r->nbPlayers = ur->nbPlayers;
+    r->game.current = ur->joueurCourant;
+    r->game.crimeCard = ur->crimeCard;
+    r->gameStarted = ur->gameStarted;
+    r->finished = ur->finished;
+    memcpy(r->game.deck, ur->deck, sizeof(r->game.deck));
+    memcpy(r->game.table, ur->tableCartes, sizeof(r->game.table));
+    memcpy(r->game.alive, ur->playerAlive, sizeof(r->game.alive));
+    memcpy(r->tcpClients, ur->tcpClients, sizeof(r->tcpClients));
+    r->chatSeq = ur->chatSeq;
+    memcpy(r->chat, ur->chat, sizeof(r->chat));
+    r->game.rules = &activeRules;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        int c = ur->clientConn[i];
+        r->clientSockets[i] = (c >= 0 && c < nconn) ? connFds[c] : -1;
+        if (r->clientSockets[i] >= 0) room_attach(r->clientSockets[i], r);
+    }
+    memcpy(r->resumeToken, ur->resumeToken, sizeof(r->resumeToken));
+    if (room_resuming(r)) room_resume_wait(r);    // The wait starts over
+    room_publish(r);
+}
+
+/**
+ * @brief Serialize the game state followed by every connection's buffered bytes
+ */
+static void *build_upgrade_blob(const int *connFds, int nconn, size_t *blobLen) {
+    size_t total = sizeof(UpgradeState) + nbRooms * sizeof(UpgradeRoom);
+    for (int i = 0; i < nconn; i++) {
+        const void *in, *out;
+        size_t inLen = 0, outLen = 0;
+        conn_get_buffers(connFds[i], &in, &inLen, &out, &outLen);
+        total += sizeof(UpgradeConnBuffers) + inLen + outLen;
+    }
+
+    char *blob = malloc(total);
+    UpgradeState *st = (UpgradeState *)blob;
+    memset(st, 0, sizeof(*st));
+    st->version = UPGRADE_STATE_VERSION;
+    st->nbRooms = nbRooms;
+    st->rules = activeRules;
+    char *p = blob + sizeof(UpgradeState);
+    for (int r = 0; r < nbRooms; r++) {
+        pthread_mutex_lock(&rooms[r].lock);
+        export_upgrade_room((UpgradeRoom *)p, &rooms[r], connFds, nconn);
+        pthread_mutex_unlock(&rooms[r].lock);
+        p += sizeof(UpgradeRoom);
+    }
+
+    for (int i = 0; i < nconn; i++) {
+        const void *in = NULL, *out = NULL;
+        size_t inLen = 0, outLen = 0;
+        conn_get_buffers(connFds[i], &in, &inLen, &out, &outLen);
+        UpgradeConnBuffers rec = { .inLen = inLen, .outLen = outLen, .lobby = directory_subscribed(connFds[i]) };
+        memcpy(p, &rec, sizeof(rec));
+        p += sizeof(rec);
+        if (inLen) memcpy(p, in, inLen);
+        p += inLen;
+        if (outLen) memcpy(p, out, outLen);
+        p += outLen;
+    }
+    *blobLen = total;
+    return blob;
+}
+
+/**
+ * @brief New process: take over the listeners (and connections) from the old one
+ *
+ * Listening sockets are told apart from connections with SO_ACCEPTCONN;
+ * connections keep their handoff order, which the state blob refers to.
+ *
+ * @return 0 on success, -1 if the handoff failed
+ */
+static int adopt_upgrade(int channel) {
+    int *fds = NULL, nfds = 0;
+    void *blob = NULL;
+    size_t blobLen = 0;
+
+    if (upgrade_recv(channel, &fds, &nfds, &blob, &blobLen) < 0 || nfds < 1) {
+        fprintf(stderr, "[Server] Hot upgrade: failed to receive sockets.\n");
+        return -1;
+    }
+
+    int *connFds = malloc(sizeof(int) * nfds);
+    int nconn = 0;
+    for (int i = 0; i < nfds; i++) {
+        int accepting = 0;
+        socklen_t optLen = sizeof(accepting);
+        getsockopt(fds[i], SOL_SOCKET, SO_ACCEPTCONN, &accepting, &optLen);
+        if (accepting && nbListeners < MAX_LISTENERS) {
+            listeners[nbListeners++] = fds[i];
+        } else {
+            connFds[nconn++] = fds[i];
+            set_nonblocking(fds[i]);
+            admission_track(fds[i]);
+            conn_open(fds[i]);
+        }
+    }
+
+    const UpgradeState *st = blob;
+    if (blobLen >= sizeof(UpgradeState) && st->version == UPGRADE_STATE_VERSION &&
+        blobLen >= sizeof(UpgradeState) + st->nbRooms * sizeof(UpgradeRoom)) {
+        // The old process's rules and room count win over this one's configuration
+        activeRules = st->rules;
+        rooms_init(st->nbRooms);
+        const char *p = (const char *)blob + sizeof(UpgradeState);
+        int players = 0, started = 0;
+        for (int r = 0; r < nbRooms; r++, p += sizeof(UpgradeRoom)) {
+            pthread_mutex_lock(&rooms[r].lock);
+            import_upgrade_room((const UpgradeRoom *)p, &rooms[r], connFds, nconn);
+            players += rooms[r].nbClients;
+            started += rooms[r].gameStarted;
+            pthread_mutex_unlock(&rooms[r].lock);
+        }
+
+        const char *end = (const char *)blob + blobLen;
+        for (int i = 0; i < nconn && p + sizeof(UpgradeConnBuffers) <= end; i++) {
+            UpgradeConnBuffers rec;
+            memcpy(&rec, p, sizeof(rec));
+            p += sizeof(rec);
+            if (p + rec.inLen + rec.outLen > end) break;
+            conn_restore_buffers(connFds[i], p, rec.inLen, p + rec.inLen, rec.outLen);
+            if (rec.lobby) directory_subscribe(connFds[i], 1);
+            p += rec.inLen + rec.outLen;
+        }
+        printf("[Server] Hot upgrade: restored %d room(s) (%d players, %d game(s) started).\n", nbRooms, players, started);
+    } else if (blobLen > 0) {
+        printf("[Server] Hot upgrade: incompatible game state, starting a fresh game.\n");
+    }
+
+    upgrade_send_ack(channel);
+    printf("[Server] Hot upgrade: took over %d listener(s) and %d connection(s).\n", nbListeners, nconn);
+    free(connFds);
+    free(fds);
+    free(blob);
+    return nbListeners > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Old process: hand the sockets over to a freshly exec'd binary
+ *
+ * Reading stops first and the workers finish every queued task, so the
+ * exported state is consistent. If the new process does not confirm in
+ * time, everything is re-armed and this process keeps serving.
+ */
+static void perform_hot_upgrade(int epollFd) {
+    struct epoll_event ev;
+    int channel;
+
+    printf("[Server] Hot upgrade requested (%s).\n",
+           serverConfig.upgradeListenerOnly ? "listeners only" : "listeners + connections");
+    pid_t child = upgrade_spawn(&channel);
+    if (child < 0) return;
+
+    // 1. Stop reading
+    int nconn = 0;
+    int *fds = malloc(sizeof(int) * (conn_count() + nbListeners));
+    for (int i = 0; i < nbListeners; i++) {
+        fds[i] = listeners[i];
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, listeners[i], NULL);
+    }
+    int *connFds = fds + nbListeners;
+    if (!serverConfig.upgradeListenerOnly) {
+        nconn = conn_list(connFds, conn_count());
+        for (int i = 0; i < nconn; i++) conn_detach(connFds[i]);
+    }
+
+    // 2. Drain the task queue (and hold the lobby deltas back)
+    directory_pause(1);
+    stop_thread_pool();
+
+    // 3. Ship the sockets (and the game state and buffers with the connections)
+    size_t blobLen = 0;
+    void *blob = serverConfig.upgradeListenerOnly ? NULL : build_upgrade_blob(connFds, nconn, &blobLen);
+    int ok = upgrade_send(channel, fds, nbListeners + nconn, blob, blobLen) == 0 &&
+             upgrade_wait_ack(channel, UPGRADE_ACK_TIMEOUT_MS) == 0;
+    close(channel);
+    free(blob);
+
+    if (!ok) {
+        // Roll back: the new binary never took over
+        fprintf(stderr, "[Server] Hot upgrade failed, resuming service.\n");
+        kill(child, SIGKILL);      // SIGTERM only stops it once it reaches its event loop
+        waitpid(child, NULL, 0);
+        for (int i = 0; i < nbListeners; i++) {
+            ev.events = EPOLLIN | EPOLLET;
+            ev.data.fd = listeners[i];
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, listeners[i], &ev);
+        }
+        for (int i = 0; i < nconn; i++) conn_attach(connFds[i]);
+        free(fds);
+        start_thread_pool();
+        directory_pause(0);
+        return;
+    }
+    free(fds);
+
+    if (!serverConfig.upgradeListenerOnly) {
+        printf("[Server] Hot upgrade complete, handed off %d connection(s) to pid %d.\n", nconn, (int)child);
+        exit(0);
+    }
+
+    // Listeners only: keep serving the games in progress until they disconnect
+    for (int i = 0; i < nbListeners; i++) close(listeners[i]);
+    nbListeners = 0;
+    draining = 1;
+    start_thread_pool();
+    directory_pause(0);
+    printf("[Server] Hot upgrade complete, draining %d connection(s).\n", conn_count());
+    if (conn_count() == 0) exit(0);
+}
+
+static int is_listener(int fd) {
+    for (int i = 0; i < nbListeners; i++) {
+        if (listeners[i] == fd) return 1;
     }
+    return 0;
+}
 
-    // 2. Init Socket
-    listenSock = socket(AF_INET, SOCK_STREAM, 0);
+static int listen_tcp(int port) {
+    struct sockaddr_in addr;
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
     int opt = 1;
-    setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(port);
-    
-    bind(listenSock, (struct sockaddr *)&addr, sizeof(addr));
-    listen(listenSock, 10);
-    set_nonblocking(listenSock);
 
-    // 3. Init Epoll
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, serverConfig.listenBacklog) < 0) {
+        perror("[Server] TCP listener");
+        close(sock);
+        return -1;
+    }
+    set_nonblocking(sock);
+    return sock;
+}
+
+/**
+ * @brief Listen on a Unix stream socket for bots and gateways on this host
+ *
+ * Same TLV framing as TCP, without the loopback TCP stack.
+ */
+static int listen_unix(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "[Server] Unix socket path too long: %s\n", path);
+        return -1;
+    }
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path); // Stale socket file from a previous run
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, serverConfig.listenBacklog) < 0) {
+        perror("[Server] Unix listener");
+        close(sock);
+        return -1;
+    }
+    set_nonblocking(sock);
+    return sock;
+}
+
+/**
+ * @brief Attach an already connected socket (e.g. one end of a socketpair)
+ *
+ * Lets an in-process bot or gateway talk to the reactor without any
+ * listener. Safe to call from any thread.
+ */
+int server_adopt_connection(int fd) {
+    set_nonblocking(fd);
+    admission_track(fd);
+    return conn_open(fd);
+}
+
+void start_server_listener(int port) {
+    int epollFd;
+    struct epoll_event ev;
+    struct epoll_event *events = calloc(serverConfig.maxEvents, sizeof(struct epoll_event));
+    cpu_set_t reactorCpus;
+
+    // 1. Init Thread Pool (sized and pinned from the runtime configuration)
+    setup_cpu_topology(&reactorCpus);
+    pin_current_thread(&reactorCpus);
+    trace_thread_name("reactor");
+    init_queue(&taskQueue);
+    start_thread_pool();
+    directory_start(serverConfig.roomDeltaMs);
+
+    // 2. Init Epoll
     epollFd = epoll_create1(0);
-    ev.events = EPOLLIN | EPOLLET; // Edge Triggered
-    ev.data.fd = listenSock;
-    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenSock, &ev);
+    conn_init(epollFd);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_upgrade_signal; // No SA_RESTART: epoll_wait must return EINTR
+    sigaction(SIGUSR2, &sa, NULL);
+    sa.sa_handler = on_stats_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    // Exit through atexit() so the trace file and PGO profiles are completed
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // 3. Init Sockets (inherited from the previous binary on a hot upgrade)
+    int channel = upgrade_inherited_channel();
+    if (channel >= 0) {
+        int rc = adopt_upgrade(channel);
+        close(channel);
+        if (rc < 0) exit(1);
+    } else {
+        int sock = listen_tcp(port);
+        if (sock < 0) exit(1);
+        listeners[nbListeners++] = sock;
+        if (serverConfig.unixPath[0] != '\0') {
+            sock = listen_unix(serverConfig.unixPath);
+            if (sock < 0) exit(1);
+            listeners[nbListeners++] = sock;
+        }
+    }
+
+    for (int i = 0; i < nbListeners; i++) {
+        ev.events = EPOLLIN | EPOLLET; // Edge Triggered
+        ev.data.fd = listeners[i];
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listeners[i], &ev);
+    }
 
     printf("[Server] Listening on port %d using Epoll + ThreadPool...\n", port);
+    if (serverConfig.unixPath[0] != '\0') printf("[Server] Listening on unix:%s\n", serverConfig.unixPath);
 
     while (1) {
-        int nfds = epoll_wait(epollFd, events, MAX_EVENTS, -1);
-        
+        int nfds = epoll_wait(epollFd, events, serverConfig.maxEvents, -1);
+
+        if (stopRequested) {
+            printf("[Server] Stopping.\n");
+            exit(0);
+        }
+        if (statsRequested) {
+            statsRequested = 0;
+            conn_stats_print(stdout);
+            admission_stats_print(stdout);
+            ratings_stats_print(stdout);
+            directory_stats_print(stdout);
+            if (traceEnabled) trace_flush();
+            pthread_mutex_lock(&taskQueue.lock);
+            printf("[Metrics] workers=%d idle=%d queue_depth=%d\n", taskQueue.live, taskQueue.idle, taskQueue.depth);
+            pthread_mutex_unlock(&taskQueue.lock);
+        }
+        if (upgradeRequested) {
+            upgradeRequested = 0;
+            if (!draining) perform_hot_upgrade(epollFd);
+            continue;
+        }
+
         for (int i = 0; i < nfds; i++) {
-            if (events[i].data.fd == listenSock) {
-                // Handle New Connection
-                struct sockaddr_in cli_addr;
-                socklen_t len = sizeof(cli_addr);
-                int connSock = accept(listenSock, (struct sockaddr *)&cli_addr, &len);
-                if (connSock >= 0) {
-                    // Remove the non-blocking setting from the client socket to avoid improper use of non-blocking I/O.
-                    // set_nonblocking(connSock);
-                    ev.events = EPOLLIN | EPOLLET;
-                    ev.data.fd = connSock;
-                    epoll_ctl(epollFd, EPOLL_CTL_ADD, connSock, &ev);
-                    printf("[Server] New connection: Socket %d\n", connSock);
-                }
+            if (is_listener(events[i].data.fd)) {
+                // Handle New Connections (TCP or Unix)
+                accept_pending(events[i].data.fd);
             } else {
-                // Handle Data from Client
                 int fd = events[i].data.fd;
-                PacketHeader header;
-                
-                // Read Header first
-                if (recv_all(fd, &header, sizeof(PacketHeader)) < 0) {
-                    // Disconnected
-                    close(fd);
-                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
-                    // Remove client from list logic...
-                    continue;
-                }
+                uint32_t evs = events[i].events;
 
-                uint32_t len = ntohl(header.length);
-                void *payload = NULL;
-                if (len > 0) {
-                    payload = malloc(len);
-                    if (recv_all(fd, payload, len) < 0) {
-                        free(payload);
-                        close(fd);
-                        continue;
-                    }
-                }
+                // Flush the backlog first: it may resume a paused reader
+                if (evs & EPOLLOUT) conn_on_writable(fd);
 
-                // Push to Thread Pool
-                enqueue_task(&taskQueue, fd, header, payload);
+                // Handle Data from Client (every complete frame goes to the pool)
+                if ((evs & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && conn_read(fd, on_frame) < 0) {
+                    // Disconnected
+                    close_connection(fd);
+                }
             }
         }
     }
@@ -282,152 +779,353 @@ void start_server_listener(int port) {
 
 /* --- Business Logic (Executed by Worker Threads) --- */
 
-void broadcast_packet(uint8_t type, const void *payload, uint32_t len) {
-    for (int i = 0; i < nbClients; i++) {
-        send_packet(clientSockets[i], type, payload, len);
+// Caller holds r->lock
+void broadcast_packet(Room *r, uint8_t type, const void *payload, uint32_t len, SendClass cls) {
+    TRACE_POINT2(broadcast, TRACE_BROADCAST, r->id, type);
+    for (int i = 0; i < r->nbClients; i++) {
+        if (r->clientSockets[i] >= 0) conn_send_packet(r->clientSockets[i], type, payload, len, cls);
     }
 }
 
-void advance_turn() {
-    int attempts = 0;
-    do {
-        joueurCourant = (joueurCourant + 1) % nbClients;
-        attempts++;
-    } while (!playerAlive[joueurCourant] && attempts <= nbClients);
+void advance_turn(Room *r) {
+    Payload_Turn turnPkg = { .player_id = game_advance_turn(&r->game) };
+    broadcast_packet(r, MSG_TURN, &turnPkg, sizeof(turnPkg), SEND_GAME);
+}
 
-    Payload_Turn turnPkg = { .player_id = joueurCourant };
-    broadcast_packet(MSG_TURN, &turnPkg, sizeof(turnPkg));
+// Seat a player in the first room with a free seat (or the one picked with MSG_JOIN_ROOM)
+static void handle_connect(int clientSock, const Payload_Connect *pkg) {
+    // Filter invalid requests with empty names
+    if (strnlen(pkg->name, sizeof(pkg->name)) == 0) {
+        printf("[Server] Ignored connection with empty name.\n");
+        return;
+    }
+
+    // Also rejects repeated logins on the same socket
+    Room *r = room_enter(clientSock);
+    if (!r) {
+        printf("[Server] Connection rejected on socket %d: already seated or no free seat.\n", clientSock);
+        return;
+    }
+    if (room_bind(clientSock, r) < 0) {
+        pthread_mutex_unlock(&r->lock);
+        return;
+    }
+
+    // 1. Register new client, in the first seat left empty (seat ids never move while waiting)
+    int newID = 0;
+    while (newID < r->nbClients && r->clientSockets[newID] >= 0) newID++;
+    r->clientSockets[newID] = clientSock;
+    snprintf(r->tcpClients[newID].name, 32, "%.31s", pkg->name);
+    r->tcpClients[newID].port = pkg->port;
+    snprintf(r->tcpClients[newID].ipAddress, sizeof(r->tcpClients[newID].ipAddress), "%.39s", pkg->ip);
+    memset(&r->chatBucket[newID], 0, sizeof(r->chatBucket[newID]));
+
+    // 2. End ID Assignment
+    Payload_ID_Assign idPkg = { .playerId = newID, .port = 0 };
+    conn_send_packet(clientSock, MSG_ID_ASSIGN, &idPkg, sizeof(idPkg), SEND_GAME);
+    conn_send_packet(clientSock, MSG_RULES, &activeRules, sizeof(activeRules), SEND_GAME);
+
+    // 3. Broadcast Player List
+    for (int i = 0; i < r->nbClients; i++) {
+        if (i == newID || r->clientSockets[i] < 0) continue;
+        Payload_Player_List listPkg;
+        listPkg.id = i;
+        snprintf(listPkg.name, sizeof(listPkg.name), "%.31s", r->tcpClients[i].name);
+        conn_send_packet(clientSock, MSG_PLAYER_LIST, &listPkg, sizeof(listPkg), SEND_GAME);
+    }
+
+    // The room's recent chat, in one frame
+    if (r->chatSeq > 0) {
+        Payload_Chat_History history;
+        uint32_t historyLen = room_chat_history(r, &history);
+        conn_send_packet(clientSock, MSG_CHAT_HISTORY, &history, historyLen, SEND_CHAT);
+    }
+
+    if (newID == r->nbClients) r->nbClients++;
+
+    // 4. Broadcast the new player to all clients (including self); the roster is game state, never dropped
+    Payload_Player_List newPlayerPkg;
+    newPlayerPkg.id = newID;
+    snprintf(newPlayerPkg.name, sizeof(newPlayerPkg.name), "%.31s", r->tcpClients[newID].name);
+    broadcast_packet(r, MSG_PLAYER_LIST, &newPlayerPkg, sizeof(newPlayerPkg), SEND_GAME);
+
+    // 5. Check if game should start (empty seats are filled first, so every seat is taken)
+    if (r->nbClients == r->nbPlayers) {
+        printf("[Server] Room %d: %d Players connected. Starting game (%s)...\n", r->id, r->nbPlayers, activeRules.name);
+        r->gameStarted = 1;
+        // Shuffles with the room's own generator (seeded by rooms_init()) and deals
+        game_start(&r->game);
+
+        // Distribute Cards
+        for (int i = 0; i < r->nbPlayers; i++) {
+            Payload_Distribute distPkg;
+            memset(&distPkg, 0, sizeof(distPkg));
+            distPkg.nbCards = activeRules.handSize;
+            const int *hand = game_hand(&r->game, i);
+            for (int c = 0; c < activeRules.handSize; c++) distPkg.Cards[c] = hand[c];
+            // The player's own symbol counts
+            for (int j = 0; j < MAX_OBJECTS; j++) distPkg.objCounts[j] = r->game.table[i][j];
+            if (r->clientSockets[i] >= 0) conn_send_packet(r->clientSockets[i], MSG_DISTRIBUTE, &distPkg, sizeof(distPkg), SEND_GAME);
+        }
+
+        // Broadcast First Turn
+        Payload_Turn turnPkg = { .player_id = 0 };
+        broadcast_packet(r, MSG_TURN, &turnPkg, sizeof(turnPkg), SEND_GAME);
+    }
+    room_publish(r);
+    pthread_mutex_unlock(&r->lock);
 }
 
-void handle_logic(int clientSock, uint8_t type, void *data, uint32_t len) {
-    pthread_mutex_lock(&gameMutex);
+// Relay a chat line to the room, on the low lane so it never holds up game frames
+static void handle_chat(Room *r, int clientId, const Payload_Chat *pkg, uint32_t len) {
+    if (!bucket_take(&r->chatBucket[clientId], serverConfig.chatRate, serverConfig.chatBurst, admission_now_ns())) return;
+    const Chat_Line *line = room_chat_append(r, clientId, pkg->text, len);
+    if (!line) return;
+    uint32_t lineLen = offsetof(Chat_Line, text) + strlen(line->text) + 1;
+    broadcast_packet(r, MSG_CHAT_LINE, line, lineLen, SEND_CHAT);
+}
 
-    // Get Client Index
-    int clientId = -1;
-    for(int i=0; i<nbClients; i++) if(clientSockets[i] == clientSock) clientId = i;
-    (void)clientId;
+/* --- Room Migration --- */
 
-    switch (type) {
-        case MSG_CONNECT: {
-            // 0. Validate Connection
-            // Ignore if the room is full
-            if (nbClients >= MAX_CLIENTS) {
-                printf("[Server] Connection rejected: Server full.\n");
-                break; 
-            }
-            
-            // Prevent repeated logins to the same Socket
-            int isAlreadyRegistered = 0;
-            for (int i = 0; i < nbClients; i++) {
-                if (clientSockets[i] == clientSock) {
-                    isAlreadyRegistered = 1;
-                    break;
-                }
-            }
-            if (isAlreadyRegistered) {
-                printf("[Server] Ignored duplicate MSG_CONNECT from Socket %d\n", clientSock);
-                break; // End without assigning a new ID
-            }
+// Hold a table, ship it to the target and send its players there; caller passes the connected target
+static Payload_Migrate_Result migrate_room(Room *r, int sock, const char *endpoint, int port) {
+    Payload_Migrate_Result res = { .status = MIGRATE_EMPTY, .roomId = -1 };
+    char frame[ROOM_IMPORT_MAX];
+    Payload_Room_Import *head = (Payload_Room_Import *)frame;
+    memset(head, 0, sizeof(*head));
+    snprintf(head->secret, sizeof(head->secret), "%s", serverConfig.migrateSecret);
+    snprintf(head->rules, sizeof(head->rules), "%s", activeRules.name);
 
-            Payload_Connect *pkg = (Payload_Connect*)data;
+    uint64_t startNs = admission_now_ns();
+    pthread_mutex_lock(&r->lock);
+    if (room_resuming(r)) {
+        res.status = MIGRATE_BUSY;
+        pthread_mutex_unlock(&r->lock);
+        return res;
+    }
+    int live = 0;
+    for (int i = 0; i < r->nbClients; i++) {
+        if (r->clientSockets[i] < 0) continue;
+        r->resumeToken[i] = migrate_token();
+        live++;
+    }
+    if (live > 0) {
+        uint32_t len = sizeof(*head) + migrate_pack(r, frame + sizeof(*head), sizeof(frame) - sizeof(*head));
+        if (migrate_transfer(sock, frame, len, &res) < 0) {
+            res.status = MIGRATE_UNREACHABLE;
+            res.roomId = -1;
+        }
+    }
+    if (res.status == MIGRATE_OK) {
+        // The redirect is queued behind every frame already sent: nothing is lost on the way
+        for (int i = 0; i < r->nbClients; i++) {
+            int fd = r->clientSockets[i];
+            if (fd < 0) continue;
+            Payload_Redirect redirect;
+            memset(&redirect, 0, sizeof(redirect));
+            snprintf(redirect.endpoint, sizeof(redirect.endpoint), "%s", endpoint);
+            redirect.port = port;
+            redirect.roomId = res.roomId;
+            redirect.playerId = i;
+            redirect.token = r->resumeToken[i];
+            conn_send_packet(fd, MSG_REDIRECT, &redirect, sizeof(redirect), SEND_GAME);
+            room_detach(fd);
+        }
+        room_reset(r);
+    } else {
+        memset(r->resumeToken, 0, sizeof(r->resumeToken));
+    }
+    res.pauseUs = (uint32_t)((admission_now_ns() - startNs) / 1000);
+    pthread_mutex_unlock(&r->lock);
+    return res;
+}
 
-            // Filter invalid requests with empty names
-            if (strlen(pkg->name) == 0) {
-                 printf("[Server] Ignored connection with empty name.\n");
-                 break;
-            }
-            
-            // 1. Register new client
-            int newID = nbClients;
-            clientSockets[newID] = clientSock;
-            strncpy(tcpClients[newID].name, pkg->name, 32);
-            tcpClients[newID].port = pkg->port;
-            strcpy(tcpClients[newID].ipAddress, pkg->ip);
-            
-            // 2. End ID Assignment
-            Payload_ID_Assign idPkg = { .playerId = newID, .port = 0 };
-            send_packet(clientSock, MSG_ID_ASSIGN, &idPkg, sizeof(idPkg));
-            
-            // 3. Broadcast Player List
-            for (int i = 0; i < nbClients; i++) {
-                Payload_Player_List listPkg;
-                listPkg.id = i;
-                strncpy(listPkg.name, tcpClients[i].name, 32);
-                send_packet(clientSock, MSG_PLAYER_LIST, &listPkg, sizeof(listPkg));
-            }
+// Move a table to another server; only taken from the local Unix socket (sh13-migrate)
+static void handle_migrate(int clientSock, const Payload_Migrate *pkg) {
+    struct sockaddr_storage local;
+    socklen_t localLen = sizeof(local);
+    if (getsockname(clientSock, (struct sockaddr *)&local, &localLen) < 0 || local.ss_family != AF_UNIX) {
+        printf("[Server] Ignored MSG_MIGRATE on socket %d: not a local connection.\n", clientSock);
+        return;
+    }
 
-            nbClients++;
-
-            // 4. Broadcast the new player to all clients (including self)
-            Payload_Player_List newPlayerPkg;
-            newPlayerPkg.id = newID;
-            strncpy(newPlayerPkg.name, tcpClients[newID].name, 32);
-            broadcast_packet(MSG_PLAYER_LIST, &newPlayerPkg, sizeof(newPlayerPkg));
-
-            // 5. Check if game should start
-            if (nbClients == nbPlayers && !gameStarted) {
-                printf("[Server] 4 Players connected. Starting game...\n");
-                gameStarted = 1;
-                melangerDeck();
-                createTable();
-                crimeCard = deck[12];
-                
-                // Distribute Cards
-                for(int i=0; i<nbPlayers; i++) {
-                    Payload_Distribute distPkg;
-                    distPkg.Cards[0] = deck[i*3];
-                    distPkg.Cards[1] = deck[i*3+1];
-                    distPkg.Cards[2] = deck[i*3+2];
-                    
-                    // Calc initial visible objects 
-                    int c1=distPkg.Cards[0], c2=distPkg.Cards[1], c3=distPkg.Cards[2];
-                    for(int j=0; j<8; j++) {
-                        distPkg.objCounts[j] = tableCartes[c1][j] + tableCartes[c2][j] + tableCartes[c3][j]; 
-                        // distPkg.objCounts[j] = 0;
-                    }
-                    send_packet(clientSockets[i], MSG_DISTRIBUTE, &distPkg, sizeof(distPkg));
-                }
-                
-                // Broadcast First Turn
-                Payload_Turn turnPkg = { .player_id = 0 };
-                broadcast_packet(MSG_TURN, &turnPkg, sizeof(turnPkg));
+    char endpoint[ENDPOINT_MAX];
+    memcpy(endpoint, pkg->endpoint, sizeof(endpoint));
+    endpoint[sizeof(endpoint) - 1] = '\0';
+    Payload_Migrate_Result res = { .status = MIGRATE_BAD_ROOM, .roomId = -1 };
+    if (pkg->roomId >= 0 && pkg->roomId < nbRooms) {
+        // Connected before the table is held: only the transfer counts in the pause
+        int sock = migrate_connect(endpoint, pkg->port);
+        if (sock < 0) {
+            res.status = MIGRATE_UNREACHABLE;
+        } else {
+            res = migrate_room(&rooms[pkg->roomId], sock, endpoint, pkg->port);
+            close(sock);
+        }
+    }
+    if (res.status == MIGRATE_OK) {
+        printf("[Server] Room %d migrated to %s:%d (room %d), table held %.1f ms.\n",
+               pkg->roomId, endpoint, pkg->port, res.roomId, res.pauseUs / 1000.0);
+    } else {
+        printf("[Server] Room %d not migrated to %s:%d (status %d).\n", pkg->roomId, endpoint, pkg->port, res.status);
+    }
+    conn_send_packet(clientSock, MSG_MIGRATE_RESULT, &res, sizeof(res), SEND_GAME);
+}
+
+// Take in a table from another server sharing our migrate-secret; its players follow with MSG_RESUME
+static void handle_room_import(int clientSock, const void *data, uint32_t len) {
+    const Payload_Room_Import *pkg = data;
+    Payload_Migrate_Result res = { .status = MIGRATE_REFUSED, .roomId = -1 };
+    if (serverConfig.migrateSecret[0] != '\0' &&
+        strncmp(pkg->secret, serverConfig.migrateSecret, sizeof(pkg->secret)) == 0 &&
+        strncmp(pkg->rules, activeRules.name, sizeof(pkg->rules)) == 0) {
+        Room *r = room_take_empty();
+        if (!r) {
+            res.status = MIGRATE_NO_ROOM;
+        } else {
+            if (migrate_unpack(r, (const char *)data + sizeof(*pkg), len - sizeof(*pkg)) == 0) {
+                res.status = MIGRATE_OK;
+                res.roomId = r->id;
+                room_resume_wait(r);
+                printf("[Server] Room %d: table migrated in (%d players, %s), waiting for them.\n",
+                       r->id, r->nbClients, r->finished ? "game over" : r->gameStarted ? "game running" : "waiting");
             }
-            break;
+            pthread_mutex_unlock(&r->lock);
         }
+    }
+    if (res.status != MIGRATE_OK) printf("[Server] Refused a migrated table on socket %d (status %d).\n", clientSock, res.status);
+    conn_send_packet(clientSock, MSG_MIGRATE_RESULT, &res, sizeof(res), SEND_GAME);
+}
+
+// A player following MSG_REDIRECT takes the seat back; the game goes on once the table is complete
+static void handle_resume(int clientSock, const Payload_Resume *pkg) {
+    if (pkg->roomId < 0 || pkg->roomId >= nbRooms) return;
+    Room *r = &rooms[pkg->roomId];
+    pthread_mutex_lock(&r->lock);
+    int seat = pkg->playerId;
+    if (seat < 0 || seat >= r->nbClients || pkg->token == 0 || r->resumeToken[seat] != pkg->token ||
+        room_resume(clientSock, r) < 0) {
+        printf("[Server] Resume refused on socket %d (room %d, seat %d).\n", clientSock, pkg->roomId, seat);
+        pthread_mutex_unlock(&r->lock);
+        return;
+    }
+    r->clientSockets[seat] = clientSock;
+    r->resumeToken[seat] = 0;
+    if (!room_resuming(r)) {
+        uint64_t importNs = r->resumeUntilNs - (uint64_t)ROOM_RESUME_TIMEOUT_MS * 1000000ull;
+        printf("[Server] Room %d: every player is back, %.1f ms after the import.\n",
+               r->id, (admission_now_ns() - importNs) / 1e6);
+        room_resume_end(r);
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+void handle_logic(int clientSock, uint8_t type, void *data, uint32_t len) {
+    // Latency probe: echoed without touching the game, from any connection
+    if (type == MSG_PING) {
+        conn_send_packet(clientSock, MSG_PONG, data, len, SEND_SPECTATOR);
+        return;
+    }
+    // Leaderboard: read-only, served from the ratings index
+    if (type == MSG_RANK_QUERY) {
+        Payload_Rank_Reply reply;
+        ratings_query((const Payload_Rank_Query *)data, &reply);
+        conn_send_packet(clientSock, MSG_RANK_REPLY, &reply, sizeof(reply), SEND_SPECTATOR);
+        return;
+    }
+    // Lobby: served from the room directory, no room lock taken
+    if (type == MSG_ROOM_LIST) {
+        const Payload_Room_List *pkg = data;
+        // Subscribe before reading the page: a change in between arrives as a delta too
+        if (pkg->subscribe >= 0) directory_subscribe(clientSock, pkg->subscribe);
+        Payload_Room_Page page;
+        directory_page(pkg->first, pkg->count, &page);
+        conn_send_packet(clientSock, MSG_ROOM_PAGE, &page, sizeof(page), SEND_SPECTATOR);
+        return;
+    }
+    if (type == MSG_JOIN_ROOM) {
+        room_prefer(clientSock, ((const Payload_Join_Room *)data)->roomId);
+        return;
+    }
+    if (type == MSG_CONNECT) {
+        handle_connect(clientSock, (const Payload_Connect *)data);
+        return;
+    }
+    if (type == MSG_RESUME) {
+        handle_resume(clientSock, (const Payload_Resume *)data);
+        return;
+    }
+    if (type == MSG_MIGRATE) {
+        handle_migrate(clientSock, (const Payload_Migrate *)data);
+        return;
+    }
+    if (type == MSG_ROOM_IMPORT) {
+        handle_room_import(clientSock, data, len);
+        return;
+    }
+
+    // Actions only count from seated players during a game
+    Room *r = room_of(clientSock);
+    if (!r) return;
+    pthread_mutex_lock(&r->lock);
+
+    // Get Client Index
+    int clientId = -1;
+    for (int i = 0; i < r->nbClients; i++) if (r->clientSockets[i] == clientSock) clientId = i;
+    // Chat is open to the table before, during and after the game
+    if (clientId >= 0 && type == MSG_CHAT) handle_chat(r, clientId, (const Payload_Chat *)data, len);
+    // A migrated table plays on once its players are back
+    if (clientId < 0 || !r->gameStarted || room_resuming(r)) {
+        pthread_mutex_unlock(&r->lock);
+        return;
+    }
+    // O/S/G: only from the seat whose turn it is, acting as itself (asking_player_id is not trusted)
+    if (clientId != r->game.current) {
+        pthread_mutex_unlock(&r->lock);
+        return;
+    }
+
+    switch (type) {
         case MSG_ACTION_O: {
             Payload_Action_O *pkg = (Payload_Action_O*)data;
-            int found = 0;
+            if (pkg->object_id < 0 || pkg->object_id >= activeRules.nbObjects) break;
             // Logic: Check if any ALIVE player has object
-            for (int p=0; p<nbClients; p++) {
-                if(playerAlive[p] && tableCartes[p][pkg->object_id] > 0) found = 1;
-            }
+            int found = game_observe(&r->game, pkg->object_id);
             Payload_Verify res = { .result_val = found, .target_player_id = -1, .object_id = pkg->object_id };
-            broadcast_packet(MSG_VERIFY, &res, sizeof(res));
-            advance_turn();
+            broadcast_packet(r, MSG_VERIFY, &res, sizeof(res), SEND_GAME);
+            advance_turn(r);
             break;
         }
         case MSG_ACTION_S: {
             Payload_Action_S *pkg = (Payload_Action_S*)data;
-            int count = tableCartes[pkg->target_player_id][pkg->object_id];
+            if (pkg->object_id < 0 || pkg->object_id >= activeRules.nbObjects ||
+                pkg->target_player_id < 0 || pkg->target_player_id >= r->nbPlayers) break;
+            int count = game_speculate(&r->game, pkg->target_player_id, pkg->object_id);
             Payload_Verify res = { .result_val = count, .target_player_id = pkg->target_player_id, .object_id = pkg->object_id };
-            broadcast_packet(MSG_VERIFY, &res, sizeof(res));
-            advance_turn();
+            broadcast_packet(r, MSG_VERIFY, &res, sizeof(res), SEND_GAME);
+            advance_turn(r);
             break;
         }
         case MSG_ACTION_G: {
             Payload_Action_G *pkg = (Payload_Action_G*)data;
-            if (pkg->guessed_card_id == crimeCard) {
-                Payload_Game_Over over = { .player_id = pkg->asking_player_id, .is_winner = 1 };
-                broadcast_packet(MSG_GAME_OVER, &over, sizeof(over));
-                gameStarted = 0;
+            if (game_guess(&r->game, clientId, pkg->guessed_card_id)) {
+                Payload_Game_Over over = { .player_id = clientId, .is_winner = 1 };
+                broadcast_packet(r, MSG_GAME_OVER, &over, sizeof(over), SEND_GAME);
+                r->gameStarted = 0;
+                r->finished = 1;
+                room_publish(r);
+
+                // Ratings are updated off this path, by the ratings thread
+                char names[MAX_PLAYERS][32];
+                for (int i = 0; i < r->nbPlayers; i++) snprintf(names[i], sizeof(names[i]), "%.31s", r->tcpClients[i].name);
+                ratings_game_over((const char (*)[32])names, r->nbPlayers, clientId);
             } else {
-                Payload_Game_Over over = { .player_id = pkg->asking_player_id, .is_winner = 0 };
-                broadcast_packet(MSG_GAME_OVER, &over, sizeof(over));
-                playerAlive[pkg->asking_player_id] = 0;
-                advance_turn();
+                Payload_Game_Over over = { .player_id = clientId, .is_winner = 0 };
+                broadcast_packet(r, MSG_GAME_OVER, &over, sizeof(over), SEND_GAME);
+                advance_turn(r);
             }
             break;
         }
     }
-    pthread_mutex_unlock(&gameMutex);
-}
\ No newline at end of file
+    pthread_mutex_unlock(&r->lock);
+}
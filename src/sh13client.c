@@ -0,0 +1,492 @@
+// sh13client.c
+#include "../include/sh13client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define CLIENT_RX_BUFFER 16384      // Receive buffer, grown only for a larger frame
+#define CLIENT_MAX_FRAME (1 << 20)  // Anything larger is a broken stream
+
+// External helper from common.c
+extern int send_all(int sockfd, const void *buffer, size_t length);
+
+struct Sh13Client {
+    int fd;
+    atomic_int myId;                // Read by senders on other threads
+    atomic_uint pingSeq;
+    char *rx;
+    size_t rxLen, rxCap;
+    Sh13State state;
+    Sh13Callbacks cb;
+    void *user;
+};
+
+static int send_frame(Sh13Client *c, uint8_t type, const void *payload, uint32_t len);
+
+/**
+ * @brief Create a disconnected session with the classic rules
+ *
+ * @return The context, or NULL if out of memory
+ */
+Sh13Client *sh13_client_new(const Sh13Callbacks *callbacks, void *user) {
+    Sh13Client *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->rx = malloc(CLIENT_RX_BUFFER);
+    if (!c->rx) {
+        free(c);
+        return NULL;
+    }
+    c->rxCap = CLIENT_RX_BUFFER;
+    c->fd = -1;
+    atomic_init(&c->myId, -1);
+    if (callbacks) c->cb = *callbacks;
+    c->user = user;
+
+    c->state.myClientId = -1;
+    c->state.currentTurnPlayer = -1;
+    for (int i = 0; i < MAX_PLAYERS; i++) c->state.playerAlive[i] = 1;
+    for (int i = 0; i < MAX_HAND; i++) c->state.myCards[i] = -1;
+    c->state.rules = *rules_builtin("classic"); // Until the server sends its own
+    c->state.rttUs = -1;
+    return c;
+}
+
+uint64_t sh13_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void sh13_client_free(Sh13Client *c) {
+    if (!c) return;
+    if (c->fd >= 0) close(c->fd);
+    free(c->rx);
+    free(c);
+}
+
+/**
+ * @brief Connect the session ("unix:/path" or an IPv4 address)
+ *
+ * @return 0 on success, -1 on failure (errno set)
+ */
+int sh13_client_connect(Sh13Client *c, const char *endpoint, int port) {
+    if (c->fd >= 0) {
+        errno = EISCONN;
+        return -1;
+    }
+    c->fd = connect_endpoint(endpoint, port);
+    return c->fd < 0 ? -1 : 0;
+}
+
+int sh13_client_fd(const Sh13Client *c) {
+    return c->fd;
+}
+
+void *sh13_client_user(const Sh13Client *c) {
+    return c->user;
+}
+
+const Sh13State *sh13_client_state(const Sh13Client *c) {
+    return &c->state;
+}
+
+static const char *object_name(const Sh13State *s, int objectId) {
+    if (objectId >= 0 && objectId < s->rules.nbObjects) return s->rules.objectNames[objectId];
+    return "?";
+}
+
+// Smallest payload each server message must carry to be decoded
+static uint32_t min_payload(uint8_t type) {
+    switch (type) {
+        case MSG_ID_ASSIGN:   return sizeof(Payload_ID_Assign);
+        case MSG_RULES:       return sizeof(RuleSet);
+        case MSG_PLAYER_LIST: return sizeof(Payload_Player_List);
+        case MSG_DISTRIBUTE:  return sizeof(Payload_Distribute);
+        case MSG_TURN:        return sizeof(Payload_Turn);
+        case MSG_VERIFY:      return sizeof(Payload_Verify);
+        case MSG_GAME_OVER:   return sizeof(Payload_Game_Over);
+        case MSG_PONG:        return sizeof(Payload_Ping);
+        case MSG_RANK_REPLY:  return sizeof(Payload_Rank_Reply);
+        case MSG_ROOM_PAGE:   return sizeof(Payload_Room_Page);
+        case MSG_ROOM_DELTA:  return offsetof(Payload_Room_Delta, rooms);
+        case MSG_CHAT_LINE:   return offsetof(Chat_Line, text) + 1;
+        case MSG_CHAT_HISTORY: return offsetof(Payload_Chat_History, lines);
+        default:              return 0;
+    }
+}
+
+/**
+ * @brief Apply one server message to the state, then notify
+ *
+ * @return 1 if the frame was decoded, 0 if it was ignored
+ */
+static int apply_message(Sh13Client *c, uint8_t type, const void *payload, uint32_t len) {
+    Sh13State *s = &c->state;
+    if (len < min_payload(type)) return 0;
+
+    switch (type) {
+        case MSG_ID_ASSIGN: {
+            const Payload_ID_Assign *p = payload;
+            s->myClientId = p->playerId;
+            s->connected = 1;
+            atomic_store(&c->myId, p->playerId);
+            if (c->cb.onIdAssign) c->cb.onIdAssign(c, p, c->user);
+            break;
+        }
+        case MSG_RULES: {
+            // Table size, deck and objects of this server
+            RuleSet rules;
+            if (len != sizeof(rules)) return 0;
+            memcpy(&rules, payload, sizeof(rules));
+            if (rules_validate(&rules) < 0) return 0;
+            s->rules = rules;
+            if (c->cb.onRules) c->cb.onRules(c, &s->rules, c->user);
+            break;
+        }
+        case MSG_PLAYER_LIST: {
+            const Payload_Player_List *p = payload;
+            if (p->id >= 0 && p->id < MAX_PLAYERS) {
+                snprintf(s->playerNames[p->id], sizeof(s->playerNames[0]), "%.31s", p->name);
+                // Update player count based on the highest ID received + 1
+                if (p->id >= s->playerCount) {
+                    s->playerCount = p->id + 1;
+                }
+            }
+            if (c->cb.onPlayerList) c->cb.onPlayerList(c, p, c->user);
+            break;
+        }
+        case MSG_DISTRIBUTE: {
+            const Payload_Distribute *p = payload;
+            s->myCardCount = (p->nbCards >= 0 && p->nbCards <= MAX_HAND) ? p->nbCards : 0;
+            memcpy(s->myCards, p->Cards, sizeof(s->myCards));
+            memcpy(s->objectCounts, p->objCounts, sizeof(s->objectCounts));
+            s->gameState = GAME_STARTED;
+            snprintf(s->lastResult, sizeof(s->lastResult), "Game Started!");
+            s->playerCount = s->rules.nbPlayers;
+            if (c->cb.onDistribute) c->cb.onDistribute(c, p, c->user);
+            break;
+        }
+        case MSG_TURN: {
+            const Payload_Turn *p = payload;
+            s->isMyTurn = (p->player_id == s->myClientId);
+            s->currentTurnPlayer = p->player_id;
+            snprintf(s->lastResult, sizeof(s->lastResult), "Player %d's Turn", p->player_id);
+            if (c->cb.onTurn) c->cb.onTurn(c, p, c->user);
+            break;
+        }
+        case MSG_VERIFY: {
+            const Payload_Verify *p = payload;
+            if (p->target_player_id == -1) {
+                snprintf(s->lastResult, sizeof(s->lastResult), "Global Check: Object %s %s found",
+                         object_name(s, p->object_id), p->result_val ? "IS" : "NOT");
+            } else {
+                snprintf(s->lastResult, sizeof(s->lastResult), "Player %d has %d of %s",
+                         p->target_player_id, p->result_val, object_name(s, p->object_id));
+            }
+            if (c->cb.onVerify) c->cb.onVerify(c, p, c->user);
+            break;
+        }
+        case MSG_GAME_OVER: {
+            const Payload_Game_Over *p = payload;
+            if (p->is_winner) {
+                snprintf(s->lastResult, sizeof(s->lastResult), "Player %d WINS!", p->player_id);
+                s->gameState = GAME_ENDED;
+            } else {
+                snprintf(s->lastResult, sizeof(s->lastResult), "Player %d Eliminated.", p->player_id);
+                if (p->player_id >= 0 && p->player_id < MAX_PLAYERS) s->playerAlive[p->player_id] = 0;
+            }
+            if (c->cb.onGameOver) c->cb.onGameOver(c, p, c->user);
+            break;
+        }
+        case MSG_PONG: {
+            Payload_Ping p;
+            memcpy(&p, payload, sizeof(p));
+            uint64_t now = sh13_now_ns();
+            if (p.sentNs > now) return 0;
+            s->rttUs = (int)((now - p.sentNs) / 1000);
+            if (c->cb.onPong) c->cb.onPong(c, s->rttUs, c->user);
+            break;
+        }
+        case MSG_RANK_REPLY: {
+            Payload_Rank_Reply p;
+            memcpy(&p, payload, sizeof(p));
+            if (p.count < 0 || p.count > RANK_PAGE) return 0;
+            if (c->cb.onRank) c->cb.onRank(c, &p, c->user);
+            break;
+        }
+        case MSG_ROOM_PAGE: {
+            Payload_Room_Page p;
+            memcpy(&p, payload, sizeof(p));
+            if (p.count < 0 || p.count > ROOM_PAGE) return 0;
+            if (c->cb.onRoomPage) c->cb.onRoomPage(c, &p, c->user);
+            break;
+        }
+        case MSG_ROOM_DELTA: {
+            // Variable length: the header fields, then `count` entries
+            Payload_Room_Delta p;
+            size_t head = offsetof(Payload_Room_Delta, rooms);
+            memcpy(&p, payload, head);
+            if (p.count < 0 || p.count > ROOM_DELTA_MAX || len < head + p.count * sizeof(Room_Info)) return 0;
+            memcpy(p.rooms, (const char *)payload + head, p.count * sizeof(Room_Info));
+            if (c->cb.onRoomDelta) c->cb.onRoomDelta(c, &p, c->user);
+            break;
+        }
+        case MSG_CHAT_LINE: {
+            // Sent up to the terminator: terminate again whatever arrived
+            Chat_Line line;
+            memset(&line, 0, sizeof(line));
+            memcpy(&line, payload, len < sizeof(line) ? len : sizeof(line));
+            line.name[sizeof(line.name) - 1] = '\0';
+            line.text[CHAT_MAX_TEXT] = '\0';
+            if (c->cb.onChat) c->cb.onChat(c, &line, c->user);
+            break;
+        }
+        case MSG_CHAT_HISTORY: {
+            Payload_Chat_History *p = malloc(sizeof(*p));
+            size_t head = offsetof(Payload_Chat_History, lines);
+            if (!p) return 0;
+            memcpy(p, payload, head);
+            if (p->count < 0 || p->count > CHAT_HISTORY || len < head + p->count * sizeof(Chat_Line)) {
+                free(p);
+                return 0;
+            }
+            memcpy(p->lines, (const char *)payload + head, p->count * sizeof(Chat_Line));
+            for (int i = 0; i < p->count; i++) {
+                p->lines[i].name[sizeof(p->lines[i].name) - 1] = '\0';
+                p->lines[i].text[CHAT_MAX_TEXT] = '\0';
+            }
+            if (c->cb.onChatHistory) c->cb.onChatHistory(c, p, c->user);
+            free(p);
+            break;
+        }
+        default:
+            return 0;
+    }
+    return 1;
+}
+
+static void disconnect(Sh13Client *c) {
+    if (c->fd < 0) return;
+    close(c->fd);
+    c->fd = -1;
+    c->rxLen = 0;
+    c->state.connected = 0;
+    c->state.version++;
+    if (c->cb.onDisconnect) c->cb.onDisconnect(c, c->user);
+}
+
+/**
+ * @brief Move the session to the server named by MSG_REDIRECT and take the seat back
+ *
+ * The new connection replaces the old one under the same descriptor, with
+ * the same flags, so poll() loops carry on unaware; an epoll user adds the
+ * descriptor again from onRedirect.
+ *
+ * @return 0, or -1 if the new server could not be reached
+ */
+static int follow_redirect(Sh13Client *c, const void *payload, uint32_t len) {
+    Payload_Redirect p;
+    if (len < sizeof(p)) return -1;
+    memcpy(&p, payload, sizeof(p));
+    p.endpoint[sizeof(p.endpoint) - 1] = '\0';
+
+    int sock = connect_endpoint(p.endpoint, p.port);
+    if (sock < 0) return -1;
+    int flags = fcntl(c->fd, F_GETFL);
+    if (flags >= 0) fcntl(sock, F_SETFL, flags);
+    if (dup2(sock, c->fd) < 0) {
+        close(sock);
+        return -1;
+    }
+    close(sock);
+
+    Payload_Resume resume = { .roomId = p.roomId, .playerId = p.playerId, .token = p.token };
+    if (send_frame(c, MSG_RESUME, &resume, sizeof(resume)) < 0) return -1;
+    if (c->cb.onRedirect) c->cb.onRedirect(c, &p, c->user);
+    return 0;
+}
+
+/**
+ * @brief Read what the socket holds and apply every complete frame
+ *
+ * Frames are decoded in place from the session's reusable buffer. Works on
+ * blocking and non-blocking sockets (EAGAIN reads nothing).
+ *
+ * @return Frames applied, or -1 once the connection is closed
+ */
+int sh13_client_read(Sh13Client *c) {
+    if (c->fd < 0) return -1;
+
+    ssize_t n;
+    do {
+        n = recv(c->fd, c->rx + c->rxLen, c->rxCap - c->rxLen, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    if (n <= 0) {
+        disconnect(c);
+        return -1;
+    }
+    c->rxLen += n;
+    c->state.lastMessageNs = sh13_now_ns();
+
+    size_t off = 0;
+    int applied = 0;
+    while (c->rxLen - off >= sizeof(PacketHeader)) {
+        PacketHeader header;
+        memcpy(&header, c->rx + off, sizeof(header));
+        uint32_t payloadLen = ntohl(header.length);
+        if (payloadLen > CLIENT_MAX_FRAME) {
+            disconnect(c);
+            return -1;
+        }
+        size_t frameLen = sizeof(header) + payloadLen;
+        if (c->rxLen - off < frameLen) {
+            // Make room for the rest of a large frame
+            if (frameLen > c->rxCap) {
+                char *grown = realloc(c->rx, frameLen);
+                if (!grown) {
+                    disconnect(c);
+                    return -1;
+                }
+                c->rx = grown;
+                c->rxCap = frameLen;
+            }
+            break;
+        }
+        const char *payload = c->rx + off + sizeof(header);
+        if (header.type == MSG_REDIRECT) {
+            // The old server let go of the table: whatever follows is not ours any more
+            if (c->cb.onFrame) c->cb.onFrame(c, header.type, payload, payloadLen, c->user);
+            int rc = follow_redirect(c, payload, payloadLen);
+            c->rxLen = 0;
+            if (rc < 0) {
+                disconnect(c);
+                return -1;
+            }
+            c->state.version++;
+            if (c->cb.onBatch) c->cb.onBatch(c, c->user);
+            return applied + 1;
+        }
+        applied += apply_message(c, header.type, payload, payloadLen);
+        if (c->cb.onFrame) c->cb.onFrame(c, header.type, payload, payloadLen, c->user);
+        off += frameLen;
+    }
+    if (off > 0) {
+        memmove(c->rx, c->rx + off, c->rxLen - off);
+        c->rxLen -= off;
+    }
+    if (applied) {
+        c->state.version++;
+        if (c->cb.onBatch) c->cb.onBatch(c, c->user);
+    }
+    return applied;
+}
+
+/**
+ * @brief Read and dispatch until the connection ends (blocking socket)
+ */
+void sh13_client_run(Sh13Client *c) {
+    while (sh13_client_read(c) >= 0) {
+    }
+}
+
+// Header and payload leave in a single send
+static int send_frame(Sh13Client *c, uint8_t type, const void *payload, uint32_t len) {
+    char frame[sizeof(PacketHeader) + CHAT_MAX_TEXT];
+    PacketHeader header = { .type = type, .length = htonl(len) };
+    if (c->fd < 0 || len > sizeof(frame) - sizeof(header)) return -1;
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), payload, len);
+    return send_all(c->fd, frame, sizeof(header) + len);
+}
+
+/**
+ * @brief Log in; the address sent is the one this socket goes out from
+ */
+int sh13_client_send_connect(Sh13Client *c, const char *name, int port) {
+    Payload_Connect pkg;
+    memset(&pkg, 0, sizeof(pkg));
+    snprintf(pkg.name, sizeof(pkg.name), "%s", name);
+    pkg.port = port;
+
+    struct sockaddr_storage local;
+    socklen_t localLen = sizeof(local);
+    if (c->fd >= 0 && getsockname(c->fd, (struct sockaddr *)&local, &localLen) == 0 &&
+        local.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &((struct sockaddr_in *)&local)->sin_addr, pkg.ip, sizeof(pkg.ip));
+    } else {
+        snprintf(pkg.ip, sizeof(pkg.ip), "127.0.0.1");
+    }
+    return send_frame(c, MSG_CONNECT, &pkg, sizeof(pkg));
+}
+
+int sh13_client_observe(Sh13Client *c, int objectId) {
+    Payload_Action_O pkg = { .asking_player_id = atomic_load(&c->myId), .object_id = objectId };
+    return send_frame(c, MSG_ACTION_O, &pkg, sizeof(pkg));
+}
+
+int sh13_client_speculate(Sh13Client *c, int targetId, int objectId) {
+    Payload_Action_S pkg = { .asking_player_id = atomic_load(&c->myId), .target_player_id = targetId,
+                             .object_id = objectId };
+    return send_frame(c, MSG_ACTION_S, &pkg, sizeof(pkg));
+}
+
+int sh13_client_guess(Sh13Client *c, int cardId) {
+    Payload_Action_G pkg = { .asking_player_id = atomic_load(&c->myId), .guessed_card_id = cardId };
+    return send_frame(c, MSG_ACTION_G, &pkg, sizeof(pkg));
+}
+
+/**
+ * @brief Send a latency probe; its MSG_PONG sets rttUs and calls onPong
+ */
+int sh13_client_ping(Sh13Client *c) {
+    Payload_Ping pkg = { .seq = atomic_fetch_add(&c->pingSeq, 1), .sentNs = sh13_now_ns() };
+    return send_frame(c, MSG_PING, &pkg, sizeof(pkg));
+}
+
+/**
+ * @brief Ask for a player's rank (name) or a leaderboard page (name NULL
+ * or empty, from 0-based rank `first`); answered through onRank
+ */
+int sh13_client_rank_query(Sh13Client *c, const char *name, int first, int count) {
+    Payload_Rank_Query pkg;
+    memset(&pkg, 0, sizeof(pkg));
+    if (name) strncpy(pkg.name, name, sizeof(pkg.name) - 1);
+    pkg.first = first;
+    pkg.count = count;
+    return send_frame(c, MSG_RANK_QUERY, &pkg, sizeof(pkg));
+}
+
+/**
+ * @brief Ask for a page of the room directory (answered through onRoomPage);
+ * subscribe 1 also starts the onRoomDelta updates, 0 stops them, -1 keeps them as they are
+ */
+int sh13_client_room_list(Sh13Client *c, int first, int count, int subscribe) {
+    Payload_Room_List pkg = { .first = first, .count = count, .subscribe = subscribe };
+    return send_frame(c, MSG_ROOM_LIST, &pkg, sizeof(pkg));
+}
+
+/**
+ * @brief Pick the room the next sh13_client_send_connect() seats in (ROOM_ANY: the server's choice)
+ */
+int sh13_client_join_room(Sh13Client *c, int roomId) {
+    Payload_Join_Room pkg = { .roomId = roomId };
+    return send_frame(c, MSG_JOIN_ROOM, &pkg, sizeof(pkg));
+}
+
+/**
+ * @brief Say something to the table (cut at CHAT_MAX_TEXT bytes); lines come back through onChat
+ */
+int sh13_client_chat(Sh13Client *c, const char *text) {
+    size_t len = strnlen(text, CHAT_MAX_TEXT);
+    if (len == 0) return -1;
+    return send_frame(c, MSG_CHAT, text, len);
+}
@@ -0,0 +1,389 @@
+// solver.c
+#include "../include/solver.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSWER_MAX 256          // O answers 0/1, S answers a count
+
+static uint64_t mix64(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/* --- Transposition table --- */
+
+int tt_init(TransTable *tt, size_t megabytes) {
+    size_t n = 1;
+    while (n * 2 * sizeof(TTEntry) <= megabytes * 1024 * 1024) n *= 2;
+    tt->entries = calloc(n, sizeof(TTEntry));
+    tt->mask = n - 1;
+    return tt->entries ? 0 : -1;
+}
+
+void tt_free(TransTable *tt) {
+    free(tt->entries);
+    tt->entries = NULL;
+}
+
+static int tt_probe(const TransTable *tt, uint64_t key, double *value) {
+    TTEntry *e = &tt->entries[key & tt->mask];
+    uint64_t data = atomic_load_explicit(&e->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&e->check, memory_order_relaxed);
+    if ((check ^ data) != key) return 0;
+    memcpy(value, &data, sizeof(*value));
+    return 1;
+}
+
+static void tt_store(TransTable *tt, uint64_t key, double value) {
+    TTEntry *e = &tt->entries[key & tt->mask];
+    uint64_t data;
+    memcpy(&data, &value, sizeof(data));
+    atomic_store_explicit(&e->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&e->data, data, memory_order_relaxed);
+}
+
+/* --- Worlds --- */
+
+/**
+ * @brief List the worlds of a hand (see worlds.c)
+ *
+ * @return 0, or -1 if the rule set has too many worlds to enumerate
+ */
+int solver_init(Solver *s, const RuleSet *rules, const int *hand, TransTable *tt) {
+    memset(s, 0, sizeof(*s));
+    s->rules = rules;
+    s->tt = tt;
+    s->handKey = mix64(rules->nbCards * 131 + rules->nbPlayers);
+    for (int i = 0; i < rules->handSize; i++) {
+        s->hand[i] = hand[i];
+        s->handKey = mix64(s->handKey ^ hand[i]);
+    }
+    for (int c = 0; c < rules->nbCards; c++) {
+        for (int o = 0; o < MAX_OBJECTS; o++) s->handKey = mix64(s->handKey ^ rules->cardObjects[c][o]);
+    }
+    return worlds_build(&s->ws, rules, hand);
+}
+
+void solver_free(Solver *s) {
+    worlds_free(&s->ws);
+}
+
+static void root_state(const Solver *s, SolverState *st) {
+    memset(st, 0, sizeof(*st));
+    for (int p = 1; p < s->rules->nbPlayers; p++) memset(st->hi[p], 0xff, MAX_OBJECTS);
+}
+
+/* --- Search --- */
+
+// Best blind guess: the most frequent culprit among the worlds
+static double guess_value(const Solver *s, const uint32_t *idx, int n, int *card) {
+    int freq[MAX_CARDS] = {0}, best = 0;
+    for (int i = 0; i < n; i++) freq[s->ws.culprit[idx[i]]]++;
+    for (int c = 1; c < s->rules->nbCards; c++) {
+        if (freq[c] > freq[best]) best = c;
+    }
+    if (card) *card = best;
+    return n ? (double)freq[best] / n : 0;
+}
+
+static int answer(const Solver *s, uint32_t world, const BotAction *q) {
+    if (q->kind == BOT_SPECULATE) return s->ws.counts[q->target][q->object][world];
+    for (int p = 0; p < s->rules->nbPlayers; p++) {
+        if (s->ws.counts[p][q->object][world]) return 1;
+    }
+    return 0;
+}
+
+static void apply_answer(const Solver *s, SolverState *st, const BotAction *q, int a) {
+    if (q->kind == BOT_SPECULATE) {
+        st->lo[q->target][q->object] = st->hi[q->target][q->object] = a;
+    } else if (a) {
+        st->seen |= 1u << q->object;
+    } else {
+        for (int p = 1; p < s->rules->nbPlayers; p++) st->hi[p][q->object] = 0;
+    }
+}
+
+/**
+ * @brief Sort the worlds by their answer to a question
+ *
+ * @return Number of distinct answers; bucket sizes in sizes[], worlds in out
+ */
+static int partition(const Solver *s, const uint32_t *idx, int n, const BotAction *q,
+                     uint32_t *out, int *sizes) {
+    int start[ANSWER_MAX], distinct = 0;
+    memset(sizes, 0, sizeof(int) * ANSWER_MAX);
+    for (int i = 0; i < n; i++) sizes[answer(s, idx[i], q)]++;
+    for (int a = 0, pos = 0; a < ANSWER_MAX; a++) {
+        start[a] = pos;
+        pos += sizes[a];
+        distinct += sizes[a] > 0;
+    }
+    if (distinct < 2) return distinct;
+    for (int i = 0; i < n; i++) out[start[answer(s, idx[i], q)]++] = idx[i];
+    return distinct;
+}
+
+/**
+ * @brief TT key of a state: opponents are interchangeable, so their rows
+ * of bounds are sorted first and every relabelling hashes the same
+ */
+static uint64_t state_key(const Solver *s, const SolverState *st, int depth) {
+    uint8_t rows[MAX_PLAYERS][2 * MAX_OBJECTS];
+    int n = s->rules->nbPlayers - 1;
+    for (int p = 0; p < n; p++) {
+        memcpy(rows[p], st->lo[p + 1], MAX_OBJECTS);
+        memcpy(rows[p] + MAX_OBJECTS, st->hi[p + 1], MAX_OBJECTS);
+    }
+    for (int i = 1; i < n; i++) {
+        uint8_t tmp[2 * MAX_OBJECTS];
+        memcpy(tmp, rows[i], sizeof(tmp));
+        int j = i;
+        while (j > 0 && memcmp(rows[j - 1], tmp, sizeof(tmp)) > 0) {
+            memcpy(rows[j], rows[j - 1], sizeof(tmp));
+            j--;
+        }
+        memcpy(rows[j], tmp, sizeof(tmp));
+    }
+    uint64_t key = mix64(s->handKey ^ ((uint64_t)depth << 8 | st->seen));
+    for (int p = 0; p < n; p++) {
+        uint64_t words[2];
+        memcpy(words, rows[p], sizeof(words));
+        key = mix64(key ^ words[0]);
+        key = mix64(key ^ words[1]);
+    }
+    return key ? key : 1;
+}
+
+// Opponent p has the same bounds as an earlier one: asking p is a duplicate
+static int same_as_earlier(const SolverState *st, int p) {
+    for (int q = 1; q < p; q++) {
+        if (!memcmp(st->lo[q], st->lo[p], MAX_OBJECTS) && !memcmp(st->hi[q], st->hi[p], MAX_OBJECTS)) return 1;
+    }
+    return 0;
+}
+
+// Questions worth asking, duplicates of symmetric opponents left out
+static int list_questions(const Solver *s, const SolverState *st, BotAction *out) {
+    int n = 0;
+    for (int o = 0; o < s->rules->nbObjects; o++) {
+        out[n++] = (BotAction){.kind = BOT_OBSERVE, .object = o};
+        for (int p = 1; p < s->rules->nbPlayers; p++) {
+            if (st->lo[p][o] == st->hi[p][o] || same_as_earlier(st, p)) continue;
+            out[n++] = (BotAction){.kind = BOT_SPECULATE, .object = o, .target = p};
+        }
+    }
+    return n;
+}
+
+static double search(const Solver *s, const SolverState *st, const uint32_t *idx, int n,
+                     int depth, SolverCounters *c);
+
+/**
+ * @brief Value of asking q now, then playing the best with depth-1 turns
+ *
+ * @return -1 if every world gives the same answer (a wasted turn)
+ */
+static double question_value(const Solver *s, const SolverState *st, const uint32_t *idx, int n,
+                             const BotAction *q, int depth, SolverCounters *c) {
+    uint32_t *buf = malloc(sizeof(uint32_t) * n);
+    int sizes[ANSWER_MAX];
+    if (!buf) return -1;
+    if (partition(s, idx, n, q, buf, sizes) < 2) {
+        free(buf);
+        return -1;
+    }
+    double value = 0;
+    for (int a = 0, pos = 0; a < ANSWER_MAX; a++) {
+        if (!sizes[a]) continue;
+        SolverState child = *st;
+        apply_answer(s, &child, q, a);
+        value += (double)sizes[a] / n * search(s, &child, buf + pos, sizes[a], depth - 1, c);
+        pos += sizes[a];
+    }
+    free(buf);
+    return value;
+}
+
+static double search(const Solver *s, const SolverState *st, const uint32_t *idx, int n,
+                     int depth, SolverCounters *c) {
+    c->nodes++;
+    double best = guess_value(s, idx, n, NULL);
+    if (depth <= 1 || best >= 1.0) return best;
+
+    uint64_t key = state_key(s, st, depth);
+    double cached;
+    if (tt_probe(s->tt, key, &cached)) {
+        c->hits++;
+        return cached;
+    }
+
+    BotAction questions[MAX_OBJECTS * MAX_PLAYERS];
+    int nq = list_questions(s, st, questions);
+    for (int i = 0; i < nq && best < 1.0; i++) {
+        double v = question_value(s, st, idx, n, &questions[i], depth, c);
+        if (v > best) best = v;
+    }
+    tt_store(s->tt, key, best);
+    c->stores++;
+    return best;
+}
+
+static uint32_t *all_worlds(const Solver *s) {
+    uint32_t *idx = malloc(sizeof(uint32_t) * (s->ws.nbWorlds ? s->ws.nbWorlds : 1));
+    if (idx) {
+        for (int i = 0; i < s->ws.nbWorlds; i++) idx[i] = i;
+    }
+    return idx;
+}
+
+/**
+ * @brief Best probability of naming the culprit within `depth` own turns
+ */
+double solver_value(const Solver *s, int depth, SolverCounters *c) {
+    SolverState st;
+    uint32_t *idx = all_worlds(s);
+    if (!idx) return -1;
+    root_state(s, &st);
+    double v = search(s, &st, idx, s->ws.nbWorlds, depth, c);
+    free(idx);
+    return v;
+}
+
+/* --- Root actions, in parallel --- */
+
+typedef struct {
+    const Solver *s;
+    const SolverState *st;
+    const uint32_t *idx;
+    SolverAction *actions;
+    int count, depth;
+    atomic_int next;
+    pthread_mutex_t lock;
+    SolverCounters *counters;
+} RootJob;
+
+static void *root_worker(void *arg) {
+    RootJob *job = arg;
+    SolverCounters local = {0};
+    for (;;) {
+        int i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) break;
+        SolverAction *a = &job->actions[i];
+        if (a->action.kind == BOT_GUESS) continue;
+        a->value = question_value(job->s, job->st, job->idx, job->s->ws.nbWorlds, &a->action, job->depth, &local);
+    }
+    pthread_mutex_lock(&job->lock);
+    job->counters->nodes += local.nodes;
+    job->counters->hits += local.hits;
+    job->counters->stores += local.stores;
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+/**
+ * @brief Value of every first move: one guess per possible culprit, one
+ * question per useful O/S. Questions are shared out between threads, which
+ * meet in the common transposition table.
+ *
+ * @return Number of actions written to out, best first
+ */
+int solver_root_actions(const Solver *s, int depth, int threads, SolverAction *out, int max,
+                        SolverCounters *c) {
+    SolverState st;
+    root_state(s, &st);
+    uint32_t *idx = all_worlds(s);
+    if (!idx) return -1;
+
+    int n = 0, freq[MAX_CARDS] = {0};
+    for (int i = 0; i < s->ws.nbWorlds; i++) freq[s->ws.culprit[i]]++;
+    for (int card = 0; card < s->rules->nbCards && n < max; card++) {
+        if (!freq[card]) continue;
+        out[n++] = (SolverAction){{.kind = BOT_GUESS, .card = card}, (double)freq[card] / s->ws.nbWorlds};
+    }
+    BotAction questions[MAX_OBJECTS * MAX_PLAYERS];
+    int nq = depth > 1 ? list_questions(s, &st, questions) : 0;
+    for (int i = 0; i < nq && n < max; i++) out[n++] = (SolverAction){questions[i], 0};
+
+    RootJob job = {s, &st, idx, out, n, depth, 0, PTHREAD_MUTEX_INITIALIZER, c};
+    pthread_t tids[64];
+    int started = 0;
+    for (int t = 1; t < threads && t < 64; t++) {
+        if (pthread_create(&tids[started], NULL, root_worker, &job) == 0) started++;
+    }
+    root_worker(&job);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    free(idx);
+
+    // Wasted questions (-1) sink to the bottom
+    for (int i = 1; i < n; i++) {
+        SolverAction a = out[i];
+        int j = i;
+        while (j > 0 && out[j - 1].value < a.value) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = a;
+    }
+    return n;
+}
+
+/* --- Bots against the solver --- */
+
+static double policy(const Solver *s, const Strategy *strategy, const SolverState *st,
+                     const uint32_t *idx, int n, int depth, uint64_t *rng) {
+    Knowledge k;
+    knowledge_init(&k, s->rules, 0, s->hand);
+    for (int p = 1; p < s->rules->nbPlayers; p++) {
+        for (int o = 0; o < MAX_OBJECTS; o++) {
+            if (st->lo[p][o] > k.lo[p][o]) k.lo[p][o] = st->lo[p][o];
+            if (st->hi[p][o] < k.hi[p][o]) k.hi[p][o] = st->hi[p][o];
+        }
+    }
+    BotAction a = {0};
+    strategy->choose(&k, rng, &a);
+    if (a.kind == BOT_GUESS) {
+        int hits = 0;
+        for (int i = 0; i < n; i++) hits += s->ws.culprit[idx[i]] == a.card;
+        return n ? (double)hits / n : 0;
+    }
+    if (depth <= 1) return 0;   // Asked instead of naming the culprit on the last turn
+
+    uint32_t *buf = malloc(sizeof(uint32_t) * n);
+    int sizes[ANSWER_MAX];
+    if (!buf) return 0;
+    if (partition(s, idx, n, &a, buf, sizes) < 2) {
+        // Nothing learnt, one turn gone
+        double v = policy(s, strategy, st, idx, n, depth - 1, rng);
+        free(buf);
+        return v;
+    }
+    double value = 0;
+    for (int ans = 0, pos = 0; ans < ANSWER_MAX; ans++) {
+        if (!sizes[ans]) continue;
+        SolverState child = *st;
+        apply_answer(s, &child, &a, ans);
+        value += (double)sizes[ans] / n * policy(s, strategy, &child, buf + pos, sizes[ans], depth - 1, rng);
+        pos += sizes[ans];
+    }
+    free(buf);
+    return value;
+}
+
+/**
+ * @brief Same measure as solver_value, for a bot playing its own strategy
+ */
+double solver_policy_value(const Solver *s, const Strategy *strategy, int depth, uint64_t seed) {
+    SolverState st;
+    uint32_t *idx = all_worlds(s);
+    if (!idx) return -1;
+    root_state(s, &st);
+    uint64_t rng = mix64(seed);
+    double v = policy(s, strategy, &st, idx, s->ws.nbWorlds, depth, &rng);
+    free(idx);
+    return v;
+}
@@ -0,0 +1,191 @@
+// strategy.c
+#include "../include/strategy.h"
+#include <string.h>
+
+/* --- Knowledge --- */
+
+static int holds(const Knowledge *k, int card) {
+    return (k->mine[card / 32] >> (card % 32)) & 1;
+}
+
+/**
+ * @brief Start from the hand dealt to seat `self`: nothing known about others
+ */
+void knowledge_init(Knowledge *k, const RuleSet *rules, int self, const int *hand) {
+    memset(k, 0, sizeof(*k));
+    k->rules = rules;
+    k->self = self;
+    for (int c = 0; c < rules->nbCards; c++) {
+        for (int o = 0; o < MAX_OBJECTS; o++) k->totals[o] += rules->cardObjects[c][o];
+    }
+    for (int i = 0; i < rules->handSize; i++) {
+        k->mine[hand[i] / 32] |= 1u << (hand[i] % 32);
+        for (int o = 0; o < MAX_OBJECTS; o++) k->myCounts[o] += rules->cardObjects[hand[i]][o];
+    }
+    for (int p = 0; p < rules->nbPlayers; p++) {
+        k->alive[p] = 1;
+        for (int o = 0; o < MAX_OBJECTS; o++) {
+            int max = k->totals[o] - k->myCounts[o];
+            k->hi[p][o] = p == self ? k->myCounts[o] : (max > 255 ? 255 : max);
+            if (p == self) k->lo[p][o] = k->myCounts[o];
+        }
+    }
+}
+
+/**
+ * @brief O answer: nobody still in the game holds the object, or somebody does
+ *
+ * Only a "no" tells something about individual players.
+ */
+void knowledge_observe(Knowledge *k, int object, int found) {
+    if (found) return;
+    for (int p = 0; p < k->rules->nbPlayers; p++) {
+        if (p != k->self && k->alive[p]) k->hi[p][object] = 0;
+    }
+}
+
+void knowledge_speculate(Knowledge *k, int target, int object, int count) {
+    if (target == k->self) return;
+    k->lo[target][object] = k->hi[target][object] = count;
+}
+
+void knowledge_eliminated(Knowledge *k, int player) {
+    k->alive[player] = 0;
+}
+
+/**
+ * @brief Cards that can still be the culprit
+ *
+ * The other players hold every symbol not in my hand nor on the culprit:
+ * a card stays a candidate if, for every object, what it leaves for them
+ * fits between the sums of their known bounds.
+ *
+ * @return Number of candidates written to out
+ */
+int knowledge_candidates(const Knowledge *k, int *out) {
+    const RuleSet *r = k->rules;
+    int sumLo[MAX_OBJECTS] = {0}, sumHi[MAX_OBJECTS] = {0};
+    for (int p = 0; p < r->nbPlayers; p++) {
+        if (p == k->self) continue;
+        for (int o = 0; o < MAX_OBJECTS; o++) {
+            sumLo[o] += k->lo[p][o];
+            sumHi[o] += k->hi[p][o];
+        }
+    }
+
+    int n = 0;
+    for (int c = 0; c < r->nbCards; c++) {
+        if (holds(k, c)) continue;
+        int fits = 1;
+        for (int o = 0; o < r->nbObjects && fits; o++) {
+            int left = k->totals[o] - k->myCounts[o] - r->cardObjects[c][o];
+            fits = left >= sumLo[o] && left <= sumHi[o];
+        }
+        if (fits) out[n++] = c;
+    }
+    return n;
+}
+
+/* --- Strategies --- */
+
+static uint32_t bot_rand(uint64_t *rng, uint32_t bound) {
+    uint64_t z = (*rng += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return (uint32_t)(((z >> 32) * (uint64_t)bound) >> 32);
+}
+
+static int random_other(const Knowledge *k, uint64_t *rng) {
+    int n = k->rules->nbPlayers;
+    int target = bot_rand(rng, n - 1);
+    return target >= k->self ? target + 1 : target;
+}
+
+/**
+ * @brief Baseline: random questions, and a random candidate once in a while
+ */
+static void choose_random(const Knowledge *k, uint64_t *rng, BotAction *out) {
+    int candidates[MAX_CARDS];
+    int n = knowledge_candidates(k, candidates);
+    if (n <= 1 || bot_rand(rng, 8) == 0) {
+        out->kind = BOT_GUESS;
+        out->card = n ? candidates[bot_rand(rng, n)] : 0;
+        return;
+    }
+    out->object = bot_rand(rng, k->rules->nbObjects);
+    if (bot_rand(rng, 2)) {
+        out->kind = BOT_OBSERVE;
+    } else {
+        out->kind = BOT_SPECULATE;
+        out->target = random_other(k, rng);
+    }
+}
+
+/**
+ * @brief Ask S on the object that best splits the candidates, of the player
+ * we know least about on it
+ *
+ * @return 0 if no question can narrow the candidates down
+ */
+static int best_question(const Knowledge *k, const int *candidates, int n, BotAction *out) {
+    const RuleSet *r = k->rules;
+    int bestScore = 0;
+    for (int o = 0; o < r->nbObjects; o++) {
+        int with = 0;
+        for (int i = 0; i < n; i++) with += r->cardObjects[candidates[i]][o] > 0;
+        int score = with * (n - with);
+        if (score <= bestScore) continue;
+
+        int target = -1, widest = 0;
+        for (int p = 0; p < r->nbPlayers; p++) {
+            int width = k->hi[p][o] - k->lo[p][o];
+            if (p != k->self && width > widest) {
+                widest = width;
+                target = p;
+            }
+        }
+        if (target < 0) continue;
+        bestScore = score;
+        out->kind = BOT_SPECULATE;
+        out->object = o;
+        out->target = target;
+    }
+    return bestScore > 0;
+}
+
+static void choose_threshold(const Knowledge *k, uint64_t *rng, BotAction *out, int guessAt) {
+    int candidates[MAX_CARDS];
+    int n = knowledge_candidates(k, candidates);
+    if (n > guessAt && best_question(k, candidates, n, out)) return;
+    out->kind = BOT_GUESS;
+    out->card = n ? candidates[bot_rand(rng, n)] : 0;
+}
+
+// Guesses only when certain
+static void choose_greedy(const Knowledge *k, uint64_t *rng, BotAction *out) {
+    choose_threshold(k, rng, out, 1);
+}
+
+// Takes a coin flip between the last two candidates to save turns
+static void choose_bold(const Knowledge *k, uint64_t *rng, BotAction *out) {
+    choose_threshold(k, rng, out, 2);
+}
+
+static const Strategy strategies[] = {
+    {"random", "random questions, random guess one turn in eight", choose_random},
+    {"greedy", "most splitting question, guesses when one candidate is left", choose_greedy},
+    {"bold", "most splitting question, guesses at two candidates", choose_bold},
+};
+
+const Strategy *strategy_find(const char *name) {
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        if (strcmp(strategies[i].name, name) == 0) return &strategies[i];
+    }
+    return NULL;
+}
+
+const Strategy *strategy_list(int *count) {
+    *count = sizeof(strategies) / sizeof(strategies[0]);
+    return strategies;
+}
@@ -0,0 +1,141 @@
+// text_cache.c
+#include "../include/text_cache.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_CACHE_BUCKETS 1024     // Power of two
+
+typedef struct TextEntry {
+    TTF_Font *font;
+    uint32_t color;
+    char text[TEXT_CACHE_MAX_LEN];
+    SDL_Texture *tex;
+    int w, h;
+    struct TextEntry *hashNext;
+    struct TextEntry *lruPrev, *lruNext;   // Most recently used at the head
+} TextEntry;
+
+static TextEntry entries[TEXT_CACHE_CAPACITY];
+static TextEntry *buckets[TEXT_CACHE_BUCKETS];
+static TextEntry *lruHead, *lruTail;
+static int used;
+static SDL_Renderer *cacheRenderer;        // Textures belong to this renderer
+static TextCacheStats stats;
+
+static uint32_t pack_color(SDL_Color c) {
+    return ((uint32_t)c.r << 24) | ((uint32_t)c.g << 16) | ((uint32_t)c.b << 8) | c.a;
+}
+
+// FNV-1a over the text, mixed with the font and color
+static uint32_t hash_key(TTF_Font *font, uint32_t color, const char *text) {
+    uint32_t h = 2166136261u ^ color ^ (uint32_t)(uintptr_t)font;
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h & (TEXT_CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(TextEntry *e) {
+    if (e->lruPrev) e->lruPrev->lruNext = e->lruNext;
+    else lruHead = e->lruNext;
+    if (e->lruNext) e->lruNext->lruPrev = e->lruPrev;
+    else lruTail = e->lruPrev;
+    e->lruPrev = e->lruNext = NULL;
+}
+
+static void lru_push_front(TextEntry *e) {
+    e->lruPrev = NULL;
+    e->lruNext = lruHead;
+    if (lruHead) lruHead->lruPrev = e;
+    lruHead = e;
+    if (!lruTail) lruTail = e;
+}
+
+static void hash_remove(TextEntry *e) {
+    TextEntry **link = &buckets[hash_key(e->font, e->color, e->text)];
+    while (*link && *link != e) link = &(*link)->hashNext;
+    if (*link) *link = e->hashNext;
+    e->hashNext = NULL;
+}
+
+/**
+ * @brief Drop every cached texture (renderer or font about to go away)
+ */
+void text_cache_clear(void) {
+    for (int i = 0; i < used; i++) {
+        if (entries[i].tex) SDL_DestroyTexture(entries[i].tex);
+    }
+    memset(entries, 0, sizeof(entries));
+    memset(buckets, 0, sizeof(buckets));
+    lruHead = lruTail = NULL;
+    used = 0;
+    cacheRenderer = NULL;
+}
+
+// A free slot: a fresh one while the pool lasts, else the least recently used
+static TextEntry *take_slot(void) {
+    if (used < TEXT_CACHE_CAPACITY) return &entries[used++];
+    TextEntry *victim = lruTail;
+    lru_unlink(victim);
+    hash_remove(victim);
+    SDL_DestroyTexture(victim->tex);
+    victim->tex = NULL;
+    stats.evictions++;
+    return victim;
+}
+
+/**
+ * @brief Texture of a rendered string, rasterized on first use only
+ *
+ * The texture stays owned by the cache: draw it, never destroy it.
+ * Strings longer than TEXT_CACHE_MAX_LEN are not cached and return NULL.
+ */
+SDL_Texture *text_cache_get(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color, int *w, int *h) {
+    if (strlen(text) >= TEXT_CACHE_MAX_LEN) return NULL;
+    if (renderer != cacheRenderer) {
+        text_cache_clear();
+        cacheRenderer = renderer;
+    }
+
+    uint32_t key = pack_color(color);
+    uint32_t bucket = hash_key(font, key, text);
+    for (TextEntry *e = buckets[bucket]; e; e = e->hashNext) {
+        if (e->font == font && e->color == key && strcmp(e->text, text) == 0) {
+            if (e != lruHead) {
+                lru_unlink(e);
+                lru_push_front(e);
+            }
+            stats.hits++;
+            *w = e->w;
+            *h = e->h;
+            return e->tex;
+        }
+    }
+
+    stats.misses++;
+    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, color);
+    if (!surf) return NULL;
+    SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surf);
+    int sw = surf->w, sh = surf->h;
+    SDL_FreeSurface(surf);
+    if (!tex) return NULL;
+
+    TextEntry *e = take_slot();
+    e->font = font;
+    e->color = key;
+    strcpy(e->text, text);
+    e->tex = tex;
+    e->w = *w = sw;
+    e->h = *h = sh;
+    e->hashNext = buckets[bucket];
+    buckets[bucket] = e;
+    lru_push_front(e);
+    return tex;
+}
+
+void text_cache_stats(TextCacheStats *out) {
+    *out = stats;
+    out->entries = used;
+}
@@ -0,0 +1,368 @@
+// tournament.c
+#include "../include/tournament.h"
+#include "../include/game.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STEAL_CHUNK 32          // Games an owner takes from its range at a time
+#define ELO_ITERATIONS 500
+
+/* Work stealing over ranges of game indices. Each worker owns a range
+ * [lo, hi) packed in one 64-bit word: the owner takes chunks from the
+ * front, thieves cut the back half off with the same CAS, so neither side
+ * ever takes a lock. Games are independent and of similar cost, so a range
+ * is all a deque would hold anyway. */
+
+typedef struct {
+    _Atomic uint64_t range;     // hi << 32 | lo
+} __attribute__((aligned(64))) WorkRange;
+
+// Per-worker counters on their own cache lines, merged once the batch is done
+typedef struct {
+    long games, draws, turns, steals;
+    long played[TOURNAMENT_MAX_STRATEGIES];
+    long wins[TOURNAMENT_MAX_STRATEGIES];
+    long beat[TOURNAMENT_MAX_STRATEGIES][TOURNAMENT_MAX_STRATEGIES];
+} __attribute__((aligned(64))) WorkerStats;
+
+// One parallel run: game i is played on seating i % nbSeatings
+typedef struct {
+    const TournamentConfig *cfg;
+    const uint8_t *seatings;    // nbSeatings rows of nbPlayers strategy indices
+    int nbSeatings;
+    uint64_t seed;
+    int nbWorkers;
+    WorkRange *ranges;
+    WorkerStats *stats;
+} Batch;
+
+typedef struct {
+    Batch *batch;
+    int id;
+} Worker;
+
+static uint64_t pack_range(uint32_t lo, uint32_t hi) {
+    return (uint64_t)hi << 32 | lo;
+}
+
+static uint64_t mix64(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Play one game between the strategies seated in `seating`
+ *
+ * @return Turns played; the winner seat in *winner (-1: draw)
+ */
+static int play_game(const TournamentConfig *cfg, const uint8_t *seating, uint64_t seed, int *winner) {
+    const RuleSet *rules = cfg->rules;
+    Game g;
+    Knowledge k[MAX_PLAYERS];
+    uint64_t rng = mix64(seed);
+
+    game_init(&g, rules, seed);
+    game_start(&g);
+    for (int p = 0; p < rules->nbPlayers; p++) knowledge_init(&k[p], rules, p, game_hand(&g, p));
+
+    *winner = -1;
+    int turn;
+    for (turn = 0; turn < cfg->maxTurns; turn++) {
+        int p = g.current;
+        BotAction a = {0};
+        cfg->strategies[seating[p]]->choose(&k[p], &rng, &a);
+
+        if (a.kind == BOT_OBSERVE) {
+            int found = game_observe(&g, a.object);
+            for (int i = 0; i < rules->nbPlayers; i++) knowledge_observe(&k[i], a.object, found);
+        } else if (a.kind == BOT_SPECULATE) {
+            int count = game_speculate(&g, a.target, a.object);
+            for (int i = 0; i < rules->nbPlayers; i++) knowledge_speculate(&k[i], a.target, a.object, count);
+        } else {
+            if (game_guess(&g, p, a.card)) {
+                *winner = p;
+                return turn + 1;
+            }
+            for (int i = 0; i < rules->nbPlayers; i++) knowledge_eliminated(&k[i], p);
+            if (game_alive_count(&g) == 0) return turn + 1;
+        }
+        game_advance_turn(&g);
+    }
+    return turn;
+}
+
+static void record_game(WorkerStats *st, const uint8_t *seating, int nbPlayers, int winner, int turns) {
+    st->games++;
+    st->turns += turns;
+    for (int p = 0; p < nbPlayers; p++) st->played[seating[p]]++;
+    if (winner < 0) {
+        st->draws++;
+        return;
+    }
+    int w = seating[winner];
+    st->wins[w]++;
+    for (int p = 0; p < nbPlayers; p++) {
+        if (seating[p] != w) st->beat[w][seating[p]]++;
+    }
+}
+
+// Owner side: take a chunk from the front of its own range
+static int take_own(WorkRange *r, uint32_t *lo, uint32_t *hi) {
+    uint64_t cur = atomic_load_explicit(&r->range, memory_order_relaxed);
+    for (;;) {
+        uint32_t l = (uint32_t)cur, h = (uint32_t)(cur >> 32);
+        if (l >= h) return 0;
+        uint32_t end = h - l > STEAL_CHUNK ? l + STEAL_CHUNK : h;
+        if (atomic_compare_exchange_weak(&r->range, &cur, pack_range(end, h))) {
+            *lo = l;
+            *hi = end;
+            return 1;
+        }
+    }
+}
+
+/**
+ * @brief Thief side: move the back half of another worker's range to our own
+ *
+ * Victims are scanned from our right neighbour on, so thieves spread out.
+ * Work is never added, so a scan that finds nothing means the batch is done.
+ */
+static int steal(Batch *b, int self) {
+    for (int i = 1; i < b->nbWorkers; i++) {
+        WorkRange *victim = &b->ranges[(self + i) % b->nbWorkers];
+        uint64_t cur = atomic_load_explicit(&victim->range, memory_order_relaxed);
+        for (;;) {
+            uint32_t l = (uint32_t)cur, h = (uint32_t)(cur >> 32);
+            if (l >= h) break;
+            uint32_t mid = l + (h - l) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &cur, pack_range(l, mid))) {
+                atomic_store(&b->ranges[self].range, pack_range(mid, h));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    Batch *b = w->batch;
+    WorkerStats *st = &b->stats[w->id];
+    int nbPlayers = b->cfg->rules->nbPlayers;
+
+    for (;;) {
+        uint32_t lo, hi;
+        if (!take_own(&b->ranges[w->id], &lo, &hi)) {
+            if (!steal(b, w->id)) break;
+            st->steals++;
+            continue;
+        }
+        for (uint32_t i = lo; i < hi; i++) {
+            const uint8_t *seating = b->seatings + (size_t)(i % b->nbSeatings) * nbPlayers;
+            int winner;
+            int turns = play_game(b->cfg, seating, b->seed ^ mix64(i), &winner);
+            record_game(st, seating, nbPlayers, winner, turns);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Play `count` games of a batch on all workers and add them to res
+ */
+static int run_batch(const TournamentConfig *cfg, const uint8_t *seatings, int nbSeatings,
+                     long count, uint64_t seed, TournamentResult *res) {
+    int n = cfg->threads;
+    Batch b = {cfg, seatings, nbSeatings, seed, n, NULL, NULL};
+    b.ranges = aligned_alloc(64, sizeof(WorkRange) * n);
+    b.stats = aligned_alloc(64, sizeof(WorkerStats) * n);
+    Worker *workers = malloc(sizeof(Worker) * n);
+    pthread_t *threads = malloc(sizeof(pthread_t) * n);
+    if (!b.ranges || !b.stats || !workers || !threads) {
+        free(b.ranges); free(b.stats); free(workers); free(threads);
+        return -1;
+    }
+    memset(b.stats, 0, sizeof(WorkerStats) * n);
+
+    // Even split to start with; stealing evens out whatever is left
+    for (int i = 0; i < n; i++) {
+        atomic_init(&b.ranges[i].range, pack_range(count * i / n, count * (i + 1) / n));
+    }
+    int started = 0;
+    for (int i = 0; i < n; i++) {
+        workers[i] = (Worker){&b, i};
+        if (i > 0 && pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) {
+            perror("[Tournament] pthread_create");
+            break;  // Running workers steal the orphaned range
+        }
+        started = i + 1;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i < started; i++) pthread_join(threads[i], NULL);
+
+    for (int w = 0; w < n; w++) {
+        const WorkerStats *st = &b.stats[w];
+        res->games += st->games;
+        res->draws += st->draws;
+        res->turns += st->turns;
+        res->steals += st->steals;
+        for (int i = 0; i < cfg->nbStrategies; i++) {
+            res->played[i] += st->played[i];
+            res->wins[i] += st->wins[i];
+            for (int j = 0; j < cfg->nbStrategies; j++) res->beat[i][j] += st->beat[i][j];
+        }
+    }
+    free(b.ranges);
+    free(b.stats);
+    free(workers);
+    free(threads);
+    return 0;
+}
+
+/**
+ * @brief Every ordered seating of the strategies: distinct strategies when
+ * there are enough to fill the table, otherwise every mix of at least two
+ *
+ * @return Number of rows written to out (allocated)
+ */
+static int round_robin_seatings(const TournamentConfig *cfg, uint8_t **out) {
+    int k = cfg->nbStrategies, n = cfg->rules->nbPlayers;
+    long total = 1;
+    for (int i = 0; i < n; i++) total *= k;
+    uint8_t *rows = malloc((size_t)total * n);
+    if (!rows) return -1;
+
+    int count = 0;
+    for (long idx = 0; idx < total; idx++) {
+        uint8_t *row = rows + (size_t)count * n;
+        uint32_t used = 0;
+        long rest = idx;
+        for (int s = 0; s < n; s++) {
+            row[s] = rest % k;
+            rest /= k;
+            used |= 1u << row[s];
+        }
+        int distinct = __builtin_popcount(used);
+        if (k >= n ? distinct == n : distinct >= 2) count++;
+    }
+    *out = rows;
+    return count;
+}
+
+/**
+ * @brief Swiss round: strategies sorted by win rate, neighbours share a
+ * table, every rotation of each table is played
+ */
+static int swiss_seatings(const TournamentConfig *cfg, const TournamentResult *res, uint8_t **out) {
+    int k = cfg->nbStrategies, n = cfg->rules->nbPlayers;
+    int order[TOURNAMENT_MAX_STRATEGIES];
+    for (int i = 0; i < k; i++) order[i] = i;
+    for (int i = 1; i < k; i++) {
+        int s = order[i], j = i;
+        double rate = res->played[s] ? (double)res->wins[s] / res->played[s] : 0;
+        while (j > 0) {
+            int t = order[j - 1];
+            double other = res->played[t] ? (double)res->wins[t] / res->played[t] : 0;
+            if (other >= rate) break;
+            order[j] = t;
+            j--;
+        }
+        order[j] = s;
+    }
+
+    int tables = (k + n - 1) / n;
+    uint8_t *rows = malloc((size_t)tables * n * n);
+    if (!rows) return -1;
+    int count = 0;
+    for (int t = 0; t < tables; t++) {
+        for (int rot = 0; rot < n; rot++) {
+            uint8_t *row = rows + (size_t)count++ * n;
+            for (int s = 0; s < n; s++) row[s] = order[(t * n + (s + rot) % n) % k];
+        }
+    }
+    *out = rows;
+    return count;
+}
+
+/**
+ * @brief Bradley-Terry strengths by minorization-maximization, as Elo
+ *
+ * Each pair gets one virtual draw (half a win each way) so that a strategy
+ * that never won keeps a finite rating. Mean rating is 1500.
+ */
+static void fit_elo(const TournamentConfig *cfg, TournamentResult *res) {
+    int k = cfg->nbStrategies;
+    double strength[TOURNAMENT_MAX_STRATEGIES];
+    for (int i = 0; i < k; i++) strength[i] = 1;
+
+    for (int it = 0; it < ELO_ITERATIONS; it++) {
+        double next[TOURNAMENT_MAX_STRATEGIES], logSum = 0;
+        for (int i = 0; i < k; i++) {
+            double wins = 0, denom = 0;
+            for (int j = 0; j < k; j++) {
+                if (j == i) continue;
+                wins += res->beat[i][j] + 0.5;
+                denom += (res->beat[i][j] + res->beat[j][i] + 1) / (strength[i] + strength[j]);
+            }
+            next[i] = denom > 0 ? wins / denom : 1;
+            logSum += log(next[i]);
+        }
+        double norm = exp(logSum / k);
+        for (int i = 0; i < k; i++) strength[i] = next[i] / norm;
+    }
+    for (int i = 0; i < k; i++) res->elo[i] = 1500 + 400 * log10(strength[i]);
+}
+
+/**
+ * @brief 95% Wilson score interval of a win rate
+ */
+void wilson_interval(long wins, long n, double *lo, double *hi) {
+    if (n == 0) {
+        *lo = 0;
+        *hi = 1;
+        return;
+    }
+    const double z = 1.96;
+    double p = (double)wins / n;
+    double denom = 1 + z * z / n;
+    double centre = (p + z * z / (2.0 * n)) / denom;
+    double half = z * sqrt(p * (1 - p) / n + z * z / (4.0 * n * n)) / denom;
+    *lo = centre - half;
+    *hi = centre + half;
+}
+
+int tournament_run(const TournamentConfig *cfg, TournamentResult *res) {
+    memset(res, 0, sizeof(*res));
+    if (cfg->nbStrategies < 1 || cfg->threads < 1 || cfg->games < 1 || cfg->games > UINT32_MAX) return -1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    uint8_t *seatings = NULL;
+    int rc = 0;
+    if (cfg->format == FORMAT_SWISS) {
+        int rounds = cfg->rounds > 0 ? cfg->rounds : 1;
+        for (int r = 0; r < rounds && rc == 0; r++) {
+            int nb = swiss_seatings(cfg, res, &seatings);
+            long count = cfg->games * (r + 1) / rounds - cfg->games * r / rounds;
+            rc = nb < 1 ? -1 : run_batch(cfg, seatings, nb, count, mix64(cfg->seed + r), res);
+            free(seatings);
+        }
+    } else {
+        int nb = round_robin_seatings(cfg, &seatings);
+        rc = nb < 1 ? -1 : run_batch(cfg, seatings, nb, cfg->games, mix64(cfg->seed), res);
+        free(seatings);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    res->seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    fit_elo(cfg, res);
+    return rc;
+}
@@ -0,0 +1,202 @@
+// trace.c
+#include "../include/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    uint64_t ts, dur;
+    int64_t a, b;
+    uint8_t ev;
+    char ph;            // 'i' instant, 'X' complete span
+} TraceRecord;
+
+// One per recording thread, so threads never contend while recording
+typedef struct TraceBuf {
+    pthread_mutex_t lock;   // Only contended by trace_flush()
+    int tid;
+    int inUse;              // Owned by a live thread; freed ones are reused
+    int n;
+    TraceRecord rec[TRACE_BUF_EVENTS];
+    struct TraceBuf *next;
+} TraceBuf;
+
+int traceEnabled = 0;
+
+static FILE *traceFile;
+static pthread_mutex_t fileLock = PTHREAD_MUTEX_INITIALIZER;   // File, buffer list, first; taken after a buffer's lock
+static TraceBuf *buffers;
+static pthread_key_t bufKey;            // Hands a buffer back when its thread exits (the pool shrinks)
+static pthread_once_t bufKeyOnce = PTHREAD_ONCE_INIT;
+static int first = 1;
+static int pid;
+static __thread TraceBuf *myBuf;
+
+static const struct {
+    const char *name;
+    const char *argA, *argB;
+} eventInfo[TRACE_NB_EVENTS] = {
+    [TRACE_ACCEPT]     = { "accept",       "fd",   NULL },
+    [TRACE_FRAME]      = { "frame",        "fd",   "type" },
+    [TRACE_ENQUEUE]    = { "enqueue",      "fd",   "depth" },
+    [TRACE_QUEUE_WAIT] = { "queue_wait",   "fd",   "type" },
+    [TRACE_HANDLE]     = { "handle_logic", "fd",   "type" },
+    [TRACE_BROADCAST]  = { "broadcast",    "room", "type" },
+    [TRACE_SEND_DONE]  = { "send_done",    "fd",   "bytes" },
+};
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Caller holds fileLock
+static void write_separator(void) {
+    if (!first) fputs(",\n", traceFile);
+    first = 0;
+}
+
+// Caller holds fileLock and b->lock
+static void write_buffer(TraceBuf *b) {
+    for (int i = 0; i < b->n; i++) {
+        const TraceRecord *r = &b->rec[i];
+        write_separator();
+        fprintf(traceFile, "{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                eventInfo[r->ev].name, r->ph, pid, b->tid, r->ts / 1000.0);
+        if (r->ph == 'X') fprintf(traceFile, ",\"dur\":%.3f", r->dur / 1000.0);
+        else fputs(",\"s\":\"t\"", traceFile);
+        fprintf(traceFile, ",\"args\":{\"%s\":%lld", eventInfo[r->ev].argA, (long long)r->a);
+        if (eventInfo[r->ev].argB) fprintf(traceFile, ",\"%s\":%lld", eventInfo[r->ev].argB, (long long)r->b);
+        fputs("}}", traceFile);
+    }
+    b->n = 0;
+}
+
+// Thread exit: write out what the buffer holds and let another thread take it
+static void release_buffer(void *arg) {
+    TraceBuf *b = arg;
+    pthread_mutex_lock(&b->lock);
+    pthread_mutex_lock(&fileLock);
+    if (traceFile) write_buffer(b);
+    b->inUse = 0;
+    pthread_mutex_unlock(&fileLock);
+    pthread_mutex_unlock(&b->lock);
+}
+
+static void make_buf_key(void) {
+    pthread_key_create(&bufKey, release_buffer);
+}
+
+static TraceBuf *thread_buffer(void) {
+    if (myBuf) return myBuf;
+    pthread_once(&bufKeyOnce, make_buf_key);
+
+    pthread_mutex_lock(&fileLock);
+    TraceBuf *b = buffers;
+    while (b && b->inUse) b = b->next;
+    if (!b) {
+        b = calloc(1, sizeof(TraceBuf));
+        if (!b) {
+            pthread_mutex_unlock(&fileLock);
+            return NULL;
+        }
+        pthread_mutex_init(&b->lock, NULL);
+        b->next = buffers;
+        buffers = b;
+    }
+    b->inUse = 1;
+    b->tid = (int)syscall(SYS_gettid);
+    pthread_mutex_unlock(&fileLock);
+
+    pthread_setspecific(bufKey, b);
+    myBuf = b;
+    return b;
+}
+
+static void record(TraceEvent ev, char ph, uint64_t ts, uint64_t dur, int64_t a, int64_t b) {
+    TraceBuf *buf = thread_buffer();
+    if (!buf) return;
+    pthread_mutex_lock(&buf->lock);
+    buf->rec[buf->n++] = (TraceRecord){ .ts = ts, .dur = dur, .a = a, .b = b, .ev = ev, .ph = ph };
+    if (buf->n == TRACE_BUF_EVENTS) {
+        pthread_mutex_lock(&fileLock);
+        if (traceFile) write_buffer(buf);
+        pthread_mutex_unlock(&fileLock);
+    }
+    pthread_mutex_unlock(&buf->lock);
+}
+
+void trace_instant(TraceEvent ev, int64_t a, int64_t b) {
+    record(ev, 'i', trace_now_ns(), 0, a, b);
+}
+
+void trace_span(TraceEvent ev, uint64_t startNs, uint64_t endNs, int64_t a, int64_t b) {
+    record(ev, 'X', startNs, endNs - startNs, a, b);
+}
+
+/**
+ * @brief Name the calling thread in the trace viewer
+ */
+void trace_thread_name(const char *name) {
+    if (!traceEnabled) return;
+    pthread_mutex_lock(&fileLock);
+    if (traceFile) {
+        write_separator();
+        fprintf(traceFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                pid, (int)syscall(SYS_gettid), name);
+    }
+    pthread_mutex_unlock(&fileLock);
+}
+
+/**
+ * @brief Start recording to a Chrome trace-event file (JSON array format)
+ */
+int trace_open(const char *path) {
+    traceFile = fopen(path, "w");
+    if (!traceFile) {
+        perror("[Trace] trace file");
+        return -1;
+    }
+    pid = getpid();
+    fputs("[\n", traceFile);
+    traceEnabled = 1;
+    atexit(trace_close);
+    printf("[Trace] Recording Chrome trace events to %s\n", path);
+    return 0;
+}
+
+/**
+ * @brief Write out every thread's buffered events
+ */
+void trace_flush(void) {
+    // Buffers are only ever pushed at the head: walk the list as it was
+    pthread_mutex_lock(&fileLock);
+    TraceBuf *head = buffers;
+    pthread_mutex_unlock(&fileLock);
+    for (TraceBuf *b = head; b; b = b->next) {
+        pthread_mutex_lock(&b->lock);       // Same order as record(): buffer, then file
+        pthread_mutex_lock(&fileLock);
+        if (traceFile) write_buffer(b);
+        pthread_mutex_unlock(&fileLock);
+        pthread_mutex_unlock(&b->lock);
+    }
+    pthread_mutex_lock(&fileLock);
+    if (traceFile) fflush(traceFile);
+    pthread_mutex_unlock(&fileLock);
+}
+
+void trace_close(void) {
+    if (!traceFile) return;
+    traceEnabled = 0;
+    trace_flush();
+    pthread_mutex_lock(&fileLock);
+    fputs("\n]\n", traceFile);
+    fclose(traceFile);
+    traceFile = NULL;
+    pthread_mutex_unlock(&fileLock);
+}
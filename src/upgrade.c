@@ -0,0 +1,241 @@
+// upgrade.c
+#include "../include/upgrade.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define UPGRADE_MAGIC      0x53483133u   // "SH13"
+#define UPGRADE_FDS_PER_MSG 200          // Stay well below the kernel SCM_MAX_FD (253)
+
+// Preamble sent before the fd batches so the receiver can size its buffers
+typedef struct {
+    uint32_t magic;
+    uint32_t nfds;
+    uint64_t blobLen;
+} UpgradePreamble;
+
+static char exePath[PATH_MAX];
+static char **savedArgv = NULL;
+
+/**
+ * @brief Remember how this process was started so it can re-exec itself
+ *
+ * argv[0] is resolved now: after a deploy, /proc/self/exe still points to the
+ * old (deleted) binary, while the path on disk holds the new one.
+ */
+void upgrade_init(int argc, char *argv[]) {
+    (void)argc;
+    savedArgv = argv;
+    if (!realpath(argv[0], exePath)) {
+        snprintf(exePath, sizeof(exePath), "/proc/self/exe");
+    }
+}
+
+/**
+ * @brief Returns the upgrade channel inherited from the previous process, or -1
+ */
+int upgrade_inherited_channel(void) {
+    const char *val = getenv(UPGRADE_ENV_FD);
+    if (!val) return -1;
+    int fd = atoi(val);
+    unsetenv(UPGRADE_ENV_FD); // Do not leak into a later upgrade
+    if (fd < 0 || fcntl(fd, F_GETFD) < 0) return -1;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+/**
+ * @brief Fork and exec the new server binary, connected by a Unix socketpair
+ *
+ * @param channel Receives the parent's end of the socketpair
+ * @return Child pid, or -1 on failure
+ */
+pid_t upgrade_spawn(int *channel) {
+    int sv[2];
+    if (!savedArgv) return -1;
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        perror("[Upgrade] socketpair");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("[Upgrade] fork");
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Child: keep only its end of the channel across exec
+        close(sv[0]);
+        int flags = fcntl(sv[1], F_GETFD);
+        fcntl(sv[1], F_SETFD, flags & ~FD_CLOEXEC);
+        char val[16];
+        snprintf(val, sizeof(val), "%d", sv[1]);
+        setenv(UPGRADE_ENV_FD, val, 1);
+        execv(exePath, savedArgv);
+        perror("[Upgrade] execv");
+        _exit(127);
+    }
+
+    close(sv[1]);
+    *channel = sv[0];
+    return pid;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Send file descriptors and a state blob over the upgrade channel
+ *
+ * Layout: preamble, blob bytes, then the fds in SCM_RIGHTS batches (each
+ * batch carries one dummy byte, as required to transmit ancillary data).
+ */
+int upgrade_send(int channel, const int *fds, int nfds, const void *blob, size_t blobLen) {
+    UpgradePreamble pre = { .magic = UPGRADE_MAGIC, .nfds = (uint32_t)nfds, .blobLen = blobLen };
+    if (write_full(channel, &pre, sizeof(pre)) < 0) return -1;
+    if (blobLen > 0 && write_full(channel, blob, blobLen) < 0) return -1;
+
+    for (int sent = 0; sent < nfds; ) {
+        int batch = nfds - sent;
+        if (batch > UPGRADE_FDS_PER_MSG) batch = UPGRADE_FDS_PER_MSG;
+
+        char dummy = 'F';
+        struct iovec iov = { .iov_base = &dummy, .iov_len = 1 };
+        char ctrl[CMSG_SPACE(sizeof(int) * UPGRADE_FDS_PER_MSG)];
+        memset(ctrl, 0, sizeof(ctrl));
+
+        struct msghdr msg = {0};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * batch);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * batch);
+        memcpy(CMSG_DATA(cmsg), fds + sent, sizeof(int) * batch);
+
+        ssize_t n;
+        do {
+            n = sendmsg(channel, &msg, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) return -1;
+        sent += batch;
+    }
+    return 0;
+}
+
+/**
+ * @brief Receive what upgrade_send() transmitted
+ *
+ * On success *fds and *blob are malloc'd and owned by the caller.
+ */
+int upgrade_recv(int channel, int **fds, int *nfds, void **blob, size_t *blobLen) {
+    UpgradePreamble pre;
+    if (read_full(channel, &pre, sizeof(pre)) < 0 || pre.magic != UPGRADE_MAGIC) return -1;
+
+    *blob = NULL;
+    *blobLen = pre.blobLen;
+    if (pre.blobLen > 0) {
+        *blob = malloc(pre.blobLen);
+        if (!*blob || read_full(channel, *blob, pre.blobLen) < 0) {
+            free(*blob);
+            return -1;
+        }
+    }
+
+    *fds = calloc(pre.nfds ? pre.nfds : 1, sizeof(int));
+    *nfds = 0;
+    while (*nfds < (int)pre.nfds) {
+        char dummy;
+        struct iovec iov = { .iov_base = &dummy, .iov_len = 1 };
+        char ctrl[CMSG_SPACE(sizeof(int) * UPGRADE_FDS_PER_MSG)];
+        struct msghdr msg = {0};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+
+        ssize_t n;
+        do {
+            n = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) break;
+
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+            int count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(*fds + *nfds, CMSG_DATA(c), sizeof(int) * count);
+            *nfds += count;
+        }
+    }
+
+    if (*nfds != (int)pre.nfds) {
+        for (int i = 0; i < *nfds; i++) close((*fds)[i]);
+        free(*fds);
+        free(*blob);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief New process: confirm it has taken over the sockets
+ */
+int upgrade_send_ack(int channel) {
+    char ok = 'K';
+    return write_full(channel, &ok, 1);
+}
+
+/**
+ * @brief Old process: wait for the new process to confirm the takeover
+ *
+ * @return 0 if acknowledged, -1 on timeout or if the child died first
+ */
+int upgrade_wait_ack(int channel, int timeoutMs) {
+    struct pollfd pfd = { .fd = channel, .events = POLLIN };
+    int r;
+    do {
+        r = poll(&pfd, 1, timeoutMs);
+    } while (r < 0 && errno == EINTR);
+    if (r <= 0) return -1;
+
+    char ok = 0;
+    if (read(channel, &ok, 1) != 1 || ok != 'K') return -1;
+    return 0;
+}
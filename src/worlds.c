@@ -0,0 +1,399 @@
+// worlds.c
+#include "../include/worlds.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WORLDS_X86 1
+#endif
+
+/* --- Kernels ---
+ * Each one walks 64 worlds per mask word, ANDs the verdict into the live
+ * mask and returns how many worlds are left. */
+
+typedef struct {
+    int (*range)(const uint8_t *col, uint64_t *live, int words, uint8_t lo, uint8_t hi);
+    int (*any)(const uint8_t *const *cols, int nbCols, uint64_t *live, int words, int found);
+    int (*equal)(const uint8_t *col, uint64_t *live, int words, uint8_t value, int keep);
+} WorldsKernels;
+
+static int range_scalar(const uint8_t *col, uint64_t *live, int words, uint8_t lo, uint8_t hi) {
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i++) {
+            uint8_t v = col[w * 64 + i];
+            bits |= (uint64_t)(v >= lo && v <= hi) << i;
+        }
+        live[w] &= bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+static int any_scalar(const uint8_t *const *cols, int nbCols, uint64_t *live, int words, int found) {
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i++) {
+            uint8_t acc = 0;
+            for (int c = 0; c < nbCols; c++) acc |= cols[c][w * 64 + i];
+            bits |= (uint64_t)(acc != 0) << i;
+        }
+        live[w] &= found ? bits : ~bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+static int equal_scalar(const uint8_t *col, uint64_t *live, int words, uint8_t value, int keep) {
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int i = 0; i < 64; i++) bits |= (uint64_t)(col[w * 64 + i] == value) << i;
+        live[w] &= keep ? bits : ~bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+static const WorldsKernels kernelsScalar = {range_scalar, any_scalar, equal_scalar};
+
+#ifdef WORLDS_X86
+
+// lo <= v <= hi on unsigned bytes: v is its own max with lo and min with hi
+__attribute__((target("sse2")))
+static int range_sse2(const uint8_t *col, uint64_t *live, int words, uint8_t lo, uint8_t hi) {
+    const __m128i vlo = _mm_set1_epi8((char)lo), vhi = _mm_set1_epi8((char)hi);
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int q = 0; q < 4; q++) {
+            __m128i v = _mm_load_si128((const __m128i *)(col + w * 64 + q * 16));
+            __m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, vlo), v),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(v, vhi), v));
+            bits |= (uint64_t)(uint16_t)_mm_movemask_epi8(in) << (q * 16);
+        }
+        live[w] &= bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+__attribute__((target("sse2")))
+static int any_sse2(const uint8_t *const *cols, int nbCols, uint64_t *live, int words, int found) {
+    const __m128i zero = _mm_setzero_si128();
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t zeros = 0;
+        for (int q = 0; q < 4; q++) {
+            __m128i acc = zero;
+            for (int c = 0; c < nbCols; c++) {
+                acc = _mm_or_si128(acc, _mm_load_si128((const __m128i *)(cols[c] + w * 64 + q * 16)));
+            }
+            zeros |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) << (q * 16);
+        }
+        live[w] &= found ? ~zeros : zeros;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+__attribute__((target("sse2")))
+static int equal_sse2(const uint8_t *col, uint64_t *live, int words, uint8_t value, int keep) {
+    const __m128i vv = _mm_set1_epi8((char)value);
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int q = 0; q < 4; q++) {
+            __m128i v = _mm_load_si128((const __m128i *)(col + w * 64 + q * 16));
+            bits |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vv)) << (q * 16);
+        }
+        live[w] &= keep ? bits : ~bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+__attribute__((target("avx2")))
+static int range_avx2(const uint8_t *col, uint64_t *live, int words, uint8_t lo, uint8_t hi) {
+    const __m256i vlo = _mm256_set1_epi8((char)lo), vhi = _mm256_set1_epi8((char)hi);
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int h = 0; h < 2; h++) {
+            __m256i v = _mm256_load_si256((const __m256i *)(col + w * 64 + h * 32));
+            __m256i in = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, vlo), v),
+                                          _mm256_cmpeq_epi8(_mm256_min_epu8(v, vhi), v));
+            bits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(in) << (h * 32);
+        }
+        live[w] &= bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+__attribute__((target("avx2")))
+static int any_avx2(const uint8_t *const *cols, int nbCols, uint64_t *live, int words, int found) {
+    const __m256i zero = _mm256_setzero_si256();
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t zeros = 0;
+        for (int h = 0; h < 2; h++) {
+            __m256i acc = zero;
+            for (int c = 0; c < nbCols; c++) {
+                acc = _mm256_or_si256(acc, _mm256_load_si256((const __m256i *)(cols[c] + w * 64 + h * 32)));
+            }
+            zeros |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(acc, zero)) << (h * 32);
+        }
+        live[w] &= found ? ~zeros : zeros;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+__attribute__((target("avx2")))
+static int equal_avx2(const uint8_t *col, uint64_t *live, int words, uint8_t value, int keep) {
+    const __m256i vv = _mm256_set1_epi8((char)value);
+    int left = 0;
+    for (int w = 0; w < words; w++) {
+        if (!live[w]) continue;
+        uint64_t bits = 0;
+        for (int h = 0; h < 2; h++) {
+            __m256i v = _mm256_load_si256((const __m256i *)(col + w * 64 + h * 32));
+            bits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vv)) << (h * 32);
+        }
+        live[w] &= keep ? bits : ~bits;
+        left += __builtin_popcountll(live[w]);
+    }
+    return left;
+}
+
+static const WorldsKernels kernelsSse2 = {range_sse2, any_sse2, equal_sse2};
+static const WorldsKernels kernelsAvx2 = {range_avx2, any_avx2, equal_avx2};
+
+#endif
+
+/* --- Dispatch --- */
+
+static WorldsIsa activeIsa = WORLDS_SCALAR;
+static const WorldsKernels *kernels = NULL;
+
+static WorldsIsa best_isa(void) {
+#ifdef WORLDS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return WORLDS_AVX2;
+    if (__builtin_cpu_supports("sse2")) return WORLDS_SSE2;
+#endif
+    return WORLDS_SCALAR;
+}
+
+/**
+ * @brief Use an instruction set, or the best one below it this CPU has
+ */
+void worlds_set_isa(WorldsIsa isa) {
+    WorldsIsa best = best_isa();
+    activeIsa = isa > best ? best : isa;
+#ifdef WORLDS_X86
+    if (activeIsa == WORLDS_AVX2) {
+        kernels = &kernelsAvx2;
+        return;
+    }
+    if (activeIsa == WORLDS_SSE2) {
+        kernels = &kernelsSse2;
+        return;
+    }
+#endif
+    kernels = &kernelsScalar;
+}
+
+WorldsIsa worlds_isa(void) {
+    if (!kernels) worlds_set_isa(WORLDS_AVX2);
+    return activeIsa;
+}
+
+const char *worlds_isa_name(WorldsIsa isa) {
+    static const char *names[] = {"scalar", "sse2", "avx2"};
+    return names[isa];
+}
+
+static const WorldsKernels *active_kernels(void) {
+    if (!kernels) worlds_set_isa(WORLDS_AVX2);
+    return kernels;
+}
+
+/* --- Enumeration --- */
+
+typedef struct {
+    WorldSet *ws;
+    uint8_t counts[MAX_PLAYERS][MAX_OBJECTS];
+    uint32_t hands[MAX_PLAYERS];
+    uint8_t culprit;
+} WorldCursor;
+
+static void deal_seat(WorldCursor *cur, uint32_t free, int seat);
+
+// Choose the hand of `seat` among the free cards, in increasing order
+static void pick_cards(WorldCursor *cur, uint32_t free, int seat, int left, int from) {
+    const RuleSet *r = cur->ws->rules;
+    if (left == 0) {
+        deal_seat(cur, free, seat + 1);
+        return;
+    }
+    for (int c = from; c < r->nbCards; c++) {
+        if (!((free >> c) & 1)) continue;
+        for (int o = 0; o < MAX_OBJECTS; o++) cur->counts[seat][o] += r->cardObjects[c][o];
+        cur->hands[seat] |= 1u << c;
+        pick_cards(cur, free & ~(1u << c), seat, left - 1, c + 1);
+        cur->hands[seat] &= ~(1u << c);
+        for (int o = 0; o < MAX_OBJECTS; o++) cur->counts[seat][o] -= r->cardObjects[c][o];
+    }
+}
+
+static void deal_seat(WorldCursor *cur, uint32_t free, int seat) {
+    WorldSet *ws = cur->ws;
+    if (seat < ws->rules->nbPlayers) {
+        pick_cards(cur, free, seat, ws->rules->handSize, 0);
+        return;
+    }
+    int i = ws->nbWorlds++;
+    ws->culprit[i] = cur->culprit;
+    for (int p = 0; p < seat; p++) {
+        ws->hands[p][i] = cur->hands[p];
+        for (int o = 0; o < MAX_OBJECTS; o++) ws->counts[p][o][i] = cur->counts[p][o];
+    }
+}
+
+/**
+ * @brief List every world consistent with the hand of seat 0
+ *
+ * @return 0, or -1 if there are too many worlds or no memory
+ */
+int worlds_build(WorldSet *ws, const RuleSet *rules, const int *hand) {
+    memset(ws, 0, sizeof(*ws));
+    ws->rules = rules;
+
+    // m! / (hand!)^(opponents), m unseen cards: culprit times deals of the rest
+    int m = rules->nbCards - rules->handSize;
+    double count = 1;
+    for (int i = 2; i <= m; i++) count *= i;
+    for (int p = 1; p < rules->nbPlayers; p++) {
+        for (int i = 2; i <= rules->handSize; i++) count /= i;
+    }
+    if (count > WORLDS_MAX) {
+        fprintf(stderr, "[Worlds] %s: %.0f worlds, more than %d\n", rules->name, count, WORLDS_MAX);
+        return -1;
+    }
+    ws->padded = ((int)(count + 0.5) + 63) / 64 * 64;
+
+    int failed = 0;
+    ws->culprit = aligned_alloc(64, ws->padded);
+    ws->live = calloc(ws->padded / 64, sizeof(uint64_t));
+    failed |= !ws->culprit || !ws->live;
+    for (int p = 0; p < rules->nbPlayers; p++) {
+        ws->hands[p] = aligned_alloc(64, ws->padded * sizeof(uint32_t));
+        failed |= !ws->hands[p];
+        for (int o = 0; o < MAX_OBJECTS; o++) {
+            ws->counts[p][o] = aligned_alloc(64, ws->padded);
+            failed |= !ws->counts[p][o];
+            if (ws->counts[p][o]) memset(ws->counts[p][o], 0, ws->padded);
+        }
+    }
+    if (failed) {
+        worlds_free(ws);
+        return -1;
+    }
+    memset(ws->culprit, 0xff, ws->padded);
+
+    WorldCursor cur = {.ws = ws};
+    uint32_t unseen = rules->nbCards >= 32 ? 0xffffffffu : (1u << rules->nbCards) - 1;
+    for (int i = 0; i < rules->handSize; i++) {
+        unseen &= ~(1u << hand[i]);
+        cur.hands[0] |= 1u << hand[i];
+        for (int o = 0; o < MAX_OBJECTS; o++) cur.counts[0][o] += rules->cardObjects[hand[i]][o];
+    }
+    for (int c = 0; c < rules->nbCards; c++) {
+        if (!((unseen >> c) & 1)) continue;
+        cur.culprit = c;
+        deal_seat(&cur, unseen & ~(1u << c), 1);
+    }
+    worlds_reset(ws);
+    return 0;
+}
+
+void worlds_free(WorldSet *ws) {
+    free(ws->culprit);
+    free(ws->live);
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        free(ws->hands[p]);
+        for (int o = 0; o < MAX_OBJECTS; o++) free(ws->counts[p][o]);
+    }
+    memset(ws, 0, sizeof(*ws));
+}
+
+// Every world possible again (padding stays dead)
+void worlds_reset(WorldSet *ws) {
+    int words = ws->padded / 64;
+    for (int w = 0; w < words; w++) ws->live[w] = ~0ull;
+    if (ws->nbWorlds % 64) ws->live[words - 1] = (1ull << (ws->nbWorlds % 64)) - 1;
+    if (ws->nbWorlds == 0 && words) ws->live[0] = 0;
+    ws->nbLive = ws->nbWorlds;
+}
+
+/**
+ * @brief S answer: keep the worlds where seat holds lo..hi of the object
+ *
+ * @return Worlds left
+ */
+int worlds_filter_count(WorldSet *ws, int seat, int object, int lo, int hi) {
+    return ws->nbLive = active_kernels()->range(ws->counts[seat][object], ws->live, ws->padded / 64, lo, hi);
+}
+
+/**
+ * @brief O answer: somebody among aliveSeats holds the object, or nobody
+ */
+int worlds_filter_observe(WorldSet *ws, int object, int found, uint32_t aliveSeats) {
+    const uint8_t *cols[MAX_PLAYERS];
+    int n = 0;
+    for (int p = 0; p < ws->rules->nbPlayers; p++) {
+        if ((aliveSeats >> p) & 1) cols[n++] = ws->counts[p][object];
+    }
+    return ws->nbLive = active_kernels()->any(cols, n, ws->live, ws->padded / 64, found);
+}
+
+/**
+ * @brief Keep the worlds where the card is (or is not) the culprit
+ */
+int worlds_filter_card(WorldSet *ws, int card, int isCulprit) {
+    return ws->nbLive = active_kernels()->equal(ws->culprit, ws->live, ws->padded / 64, card, isCulprit);
+}
+
+/**
+ * @brief Live worlds per culprit card, and each seat's object counts summed
+ * over them (divide by nbLive for the expected count). Either may be NULL.
+ */
+void worlds_tally(const WorldSet *ws, long *perCulprit, long sums[MAX_PLAYERS][MAX_OBJECTS]) {
+    const RuleSet *r = ws->rules;
+    if (perCulprit) memset(perCulprit, 0, sizeof(long) * r->nbCards);
+    if (sums) memset(sums, 0, sizeof(long) * MAX_PLAYERS * MAX_OBJECTS);
+    for (int w = 0; w < ws->padded / 64; w++) {
+        for (uint64_t bits = ws->live[w]; bits; bits &= bits - 1) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            if (perCulprit) perCulprit[ws->culprit[i]]++;
+            if (!sums) continue;
+            for (int p = 0; p < r->nbPlayers; p++) {
+                for (int o = 0; o < r->nbObjects; o++) sums[p][o] += ws->counts[p][o][i];
+            }
+        }
+    }
+}